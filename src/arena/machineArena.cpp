@@ -0,0 +1,190 @@
+#include "arena/machineArena.h"
+
+#include <new>
+
+#include "machine.h"
+
+#ifdef _WIN32
+	#include <_windows.h>
+#else
+	#include <sys/mman.h>
+	#include <unistd.h>
+	#ifdef __linux__
+		#include <sys/syscall.h>
+	#endif
+#endif
+
+namespace
+{
+	constexpr std::size_t cacheLine = 64;
+	constexpr std::size_t hugePageSize = 2u << 20;
+
+	std::size_t roundUp(std::size_t value, std::size_t multiple)
+	{
+		return (value + multiple - 1) / multiple * multiple;
+	}
+
+#ifdef __linux__
+	// Binds the pages of a fresh mapping to one node before they are first touched.
+	// Uses the raw syscall so the build does not depend on libnuma.
+	bool bindToNode(void* address, std::size_t bytes, int node)
+	{
+		constexpr int MPOL_BIND_MODE = 2;
+		unsigned long mask[16] = {};
+		if (node < 0 || node >= static_cast<int>(sizeof(mask) * 8))
+			return false;
+		mask[node / (sizeof(unsigned long) * 8)] = 1ul << (node % (sizeof(unsigned long) * 8));
+		return syscall(SYS_mbind, address, bytes, MPOL_BIND_MODE, mask, sizeof(mask) * 8, 0) == 0;
+	}
+#endif
+}
+
+machineArena::machineArena(std::size_t capacity, const arenaOptions& options)
+{
+	slotBytes = roundUp(sizeof(machine), cacheLine);
+	static_assert(alignof(machine) <= cacheLine, "machine needs stronger alignment than a cache line");
+
+	const int node = options.numaNode;
+	const std::size_t bytes = roundUp(slotBytes * capacity, options.hugePages ? hugePageSize : 4096);
+
+#ifdef _WIN32
+	void* mapped = nullptr;
+	if (options.hugePages)
+	{
+		// Needs SeLockMemoryPrivilege; quietly falls back without it
+		const std::size_t large = roundUp(bytes, GetLargePageMinimum() ? GetLargePageMinimum() : hugePageSize);
+		mapped = node >= 0
+			? VirtualAllocExNuma(GetCurrentProcess(), nullptr, large, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE, static_cast<DWORD>(node))
+			: VirtualAlloc(nullptr, large, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		hugePages = mapped != nullptr;
+	}
+	if (!mapped)
+	{
+		mapped = node >= 0
+			? VirtualAllocExNuma(GetCurrentProcess(), nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, static_cast<DWORD>(node))
+			: VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	}
+	if (mapped && node >= 0)
+	{
+		boundNode = node;
+	}
+#else
+	void* mapped = MAP_FAILED;
+#ifdef MAP_HUGETLB
+	if (options.hugePages)
+	{
+		mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		hugePages = mapped != MAP_FAILED;
+	}
+#endif
+	if (mapped == MAP_FAILED)
+	{
+		mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+		// No reserved huge pages: ask for transparent ones instead
+		if (mapped != MAP_FAILED && options.hugePages)
+		{
+			hugePages = madvise(mapped, bytes, MADV_HUGEPAGE) == 0;
+		}
+#endif
+	}
+	if (mapped == MAP_FAILED)
+	{
+		mapped = nullptr;
+	}
+#ifdef __linux__
+	if (mapped && node >= 0 && bindToNode(mapped, bytes, node))
+	{
+		boundNode = node;
+	}
+#endif
+#endif
+
+	if (!mapped)
+	{
+		LOG_ERROR("machineArena: failed to map %zu bytes for %zu machines", bytes, capacity);
+		return;
+	}
+	if (node >= 0 && boundNode < 0)
+	{
+		LOG_WARNING("machineArena: could not bind to NUMA node %d", node);
+	}
+
+	base = static_cast<uint8_t*>(mapped);
+	mappedBytes = bytes;
+	slotCount = capacity;
+	live.assign(capacity, 0);
+	freeSlots.reserve(capacity);
+	// Lowest slots on top so instances fill the arena front to back
+	for (std::size_t i = capacity; i > 0; --i)
+	{
+		freeSlots.push_back(static_cast<uint32_t>(i - 1));
+	}
+}
+
+machineArena::~machineArena()
+{
+	for (std::size_t i = 0; i < slotCount; ++i)
+	{
+		if (live[i])
+		{
+			reinterpret_cast<machine*>(base + i * slotBytes)->~machine();
+		}
+	}
+	if (!base)
+		return;
+#ifdef _WIN32
+	VirtualFree(base, 0, MEM_RELEASE);
+#else
+	munmap(base, mappedBytes);
+#endif
+}
+
+machine* machineArena::create(unsigned int seed)
+{
+	if (freeSlots.empty())
+	{
+		return nullptr;
+	}
+	const uint32_t slot = freeSlots.back();
+	freeSlots.pop_back();
+	live[slot] = 1;
+	return new (base + static_cast<std::size_t>(slot) * slotBytes) machine(seed);
+}
+
+void machineArena::destroy(machine* instance)
+{
+	if (!instance)
+		return;
+	const std::size_t slot = (reinterpret_cast<uint8_t*>(instance) - base) / slotBytes;
+	instance->~machine();
+	live[slot] = 0;
+	freeSlots.push_back(static_cast<uint32_t>(slot));
+}
+
+machineArena::handle machineArena::acquire(unsigned int seed)
+{
+	if (machine* instance = create(seed))
+	{
+		return handle(instance, releaser{ this });
+	}
+	return handle(new machine(seed), releaser{ nullptr });
+}
+
+void machineArena::releaser::operator()(machine* instance) const
+{
+	if (arena)
+	{
+		arena->destroy(instance);
+	}
+	else
+	{
+		delete instance;
+	}
+}
+
+bool machineArena::owns(const machine* instance) const
+{
+	const uint8_t* at = reinterpret_cast<const uint8_t*>(instance);
+	return base && at >= base && at < base + slotCount * slotBytes && (at - base) % slotBytes == 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class machine;
+
+struct arenaOptions
+{
+	bool hugePages = false; // try explicit huge pages, then transparent huge pages
+	int numaNode = -1;		// -1: no placement; pinned workers pass threadPool::pinnedNode()
+};
+
+// Places up to `capacity` machines contiguously in one mapping. Every slot starts on
+// its own cache line so machines driven by different threads never share one.
+// create/destroy are O(1) via a free list. Not synchronized: give each thread its
+// own arena, or guard it externally.
+class machineArena
+{
+public:
+	explicit machineArena(std::size_t capacity, const arenaOptions& options = {});
+	~machineArena(); // destroys any machines still alive
+
+	machineArena(const machineArena&) = delete;
+	machineArena& operator=(const machineArena&) = delete;
+
+	// Null when the arena is full or its mapping failed
+	machine* create(unsigned int seed);
+	void destroy(machine* instance);
+
+	// Returns the machine to its arena, or deletes it if it came from the heap
+	struct releaser
+	{
+		machineArena* arena = nullptr;
+		void operator()(machine* instance) const;
+	};
+	using handle = std::unique_ptr<machine, releaser>;
+	// create() that falls back to the heap when the arena is full
+	handle acquire(unsigned int seed);
+
+	bool owns(const machine* instance) const;
+	std::size_t capacity() const { return slotCount; }
+	std::size_t size() const { return slotCount - freeSlots.size(); }
+	std::size_t slotSize() const { return slotBytes; }
+	bool usingHugePages() const { return hugePages; }
+	int node() const { return boundNode; }
+
+private:
+	uint8_t* base = nullptr;
+	std::size_t mappedBytes = 0;
+	std::size_t slotBytes = 0;
+	std::size_t slotCount = 0;
+	bool hugePages = false;
+	int boundNode = -1;
+
+	std::vector<uint32_t> freeSlots; // stack of free slot indices
+	std::vector<uint8_t> live;
+};
@@ -0,0 +1,407 @@
+#include "batch/batchRunner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <sstream>
+
+#include "arena/machineArena.h"
+#include "batch/inputScript.h"
+#include "batch/threadPool.h"
+#include "machine.h"
+#include "rom/romImage.h"
+#include "rom/romPack.h"
+#include "trace/trace.h"
+#include "util/json.h"
+
+namespace fs = std::filesystem;
+
+const char* batchStatusName(batchStatus status)
+{
+	switch (status)
+	{
+		case BATCH_OK:
+			return "ok";
+		case BATCH_LOAD_FAILED:
+			return "load-failed";
+		case BATCH_INPUT_FAILED:
+			return "input-failed";
+		case BATCH_TIMEOUT:
+			return "timeout";
+		default:
+			return "unknown";
+	}
+}
+
+static bool isRomFile(const fs::path& path)
+{
+	std::string ext = path.extension().string();
+	std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+	return ext == ".ch8";
+}
+
+// Pack metadata is "key=value" lines; an "input=" line ends them and everything after
+// it is the job's input script.
+static void readPackMetadata(std::string_view metadata, batchJob& job)
+{
+	while (!metadata.empty())
+	{
+		const std::size_t end = metadata.find('\n');
+		const std::string_view line = metadata.substr(0, end);
+		metadata = end == std::string_view::npos ? std::string_view() : metadata.substr(end + 1);
+		if (line == "input=")
+		{
+			job.inputText.assign(metadata);
+			return;
+		}
+		if (line.substr(0, 7) == "frames=")
+		{
+			const int frames = atoi(std::string(line.substr(7)).c_str());
+			if (frames > 0)
+			{
+				job.frames = frames;
+			}
+		}
+	}
+}
+
+static std::string packMetadata(const batchJob& job)
+{
+	std::string metadata = "frames=" + std::to_string(job.frames) + "\n";
+	if (!job.inputText.empty())
+	{
+		metadata += "input=\n" + job.inputText;
+	}
+	else if (!job.inputPath.empty())
+	{
+		std::ifstream file(job.inputPath, std::ios::binary);
+		if (!file.is_open())
+		{
+			LOG_WARNING("%s: cannot read input script %s, packing without it", job.name.c_str(), job.inputPath.c_str());
+			return metadata;
+		}
+		std::ostringstream script;
+		script << file.rdbuf();
+		metadata += "input=\n" + script.str();
+	}
+	return metadata;
+}
+
+bool loadBatchJobs(const std::string& inputPath, int defaultFrames, std::vector<batchJob>& jobs)
+{
+	std::error_code ec;
+	const fs::path input(inputPath);
+
+	if (fs::is_regular_file(input, ec) && romPack::isPack(inputPath))
+	{
+		const std::shared_ptr<const romPack> pack = romPack::open(inputPath);
+		if (!pack)
+			return false;
+		jobs.reserve(jobs.size() + pack->size());
+		for (std::size_t i = 0; i < pack->size(); ++i)
+		{
+			batchJob job;
+			job.name = std::string(pack->name(i));
+			job.romPath = inputPath + ":" + job.name;
+			job.frames = defaultFrames;
+			readPackMetadata(pack->metadata(i), job);
+			job.image = pack->image(i);
+			jobs.push_back(std::move(job));
+		}
+		// The pack is indexed by hash; reports list jobs by name as for a directory
+		std::sort(jobs.begin(), jobs.end(), [](const batchJob& a, const batchJob& b) { return a.name < b.name; });
+		return true;
+	}
+
+	if (fs::is_directory(input, ec))
+	{
+		for (const fs::directory_entry& entry : fs::recursive_directory_iterator(input, ec))
+		{
+			if (entry.is_regular_file() && isRomFile(entry.path()))
+			{
+				batchJob job;
+				job.romPath = entry.path().string();
+				job.name = fs::relative(entry.path(), input, ec).generic_string();
+				job.frames = defaultFrames;
+				jobs.push_back(job);
+			}
+		}
+		// Directory order is unspecified; keep reports stable between runs
+		std::sort(jobs.begin(), jobs.end(), [](const batchJob& a, const batchJob& b) { return a.name < b.name; });
+		return true;
+	}
+
+	if (isRomFile(input))
+	{
+		batchJob job;
+		job.name = input.filename().string();
+		job.romPath = inputPath;
+		job.frames = defaultFrames;
+		jobs.push_back(job);
+		return true;
+	}
+
+	std::ifstream manifest(inputPath);
+	if (!manifest.is_open())
+	{
+		LOG_ERROR("Batch input is neither a directory nor a readable manifest: %s", inputPath.c_str());
+		return false;
+	}
+
+	const fs::path base = input.parent_path();
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(manifest, line))
+	{
+		++lineNumber;
+		const std::size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#')
+			continue;
+
+		std::istringstream fields(line);
+		batchJob job;
+		std::string rom;
+		fields >> rom;
+		job.frames = defaultFrames;
+		if (!(fields >> job.frames))
+		{
+			job.frames = defaultFrames;
+			fields.clear();
+		}
+		std::string script;
+		if (fields >> script)
+		{
+			job.inputPath = (base / script).string();
+		}
+		if (job.frames <= 0)
+		{
+			LOG_ERROR("Manifest line %d: frame count must be positive", lineNumber);
+			return false;
+		}
+		job.romPath = (base / rom).string();
+		job.name = rom;
+		jobs.push_back(job);
+	}
+	return true;
+}
+
+bool loadJobInput(const batchJob& job, inputScript& script)
+{
+	if (!job.inputPath.empty())
+		return script.load(job.inputPath);
+	if (!job.inputText.empty())
+		return script.parse(job.inputText);
+	return true;
+}
+
+batchResult runBatchJob(const batchJob& job, const batchOptions& options)
+{
+	TRACE_ZONE("runBatchJob");
+	using clock = std::chrono::steady_clock;
+	const clock::time_point start = clock::now();
+	const clock::time_point deadline = start + std::chrono::milliseconds(options.timeoutMs);
+
+	batchResult result;
+
+	// A worker pinned by --numa takes its machine from an arena bound to its node;
+	// otherwise the stack does as well
+	std::optional<machine> onStack;
+	machineArena::handle onNode;
+	const int node = threadPool::pinnedNode();
+	if (node >= 0)
+	{
+		thread_local machineArena arena(1, arenaOptions{ false, node });
+		onNode = arena.acquire(options.seed);
+	}
+	else
+	{
+		onStack.emplace(options.seed);
+	}
+	machine& m = onNode ? *onNode : *onStack;
+	m.recordHistory = false;
+	m.faults.maxFirstLogsPerInterval = 0; // counts go into the report instead
+
+	inputScript script;
+	if (!loadJobInput(job, script))
+	{
+		result.status = BATCH_INPUT_FAILED;
+		return result;
+	}
+	const std::shared_ptr<const romImage> image = job.image ? job.image : romImage::load(job.romPath);
+	if (!image || !m.loadRom(image))
+	{
+		result.status = BATCH_LOAD_FAILED;
+		return result;
+	}
+	result.romHash = image->hash();
+
+	for (int frame = 0; frame < job.frames; ++frame)
+	{
+		script.apply(frame, m.keypad);
+		result.instructions += static_cast<uint64_t>(m.runCycles(options.cyclesPerFrame));
+		m.tickTimers();
+		result.framesRun = frame + 1;
+
+		// Watchdog: a clock read every 64 frames is noise next to the emulation
+		if ((frame & 63) == 63 && clock::now() > deadline)
+		{
+			result.status = BATCH_TIMEOUT;
+			break;
+		}
+	}
+
+	result.wallMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	result.ips = result.wallMs > 0.0 ? static_cast<double>(result.instructions) * 1000.0 / result.wallMs : 0.0;
+	result.digest = m.digest();
+	m.packScreen(result.framebuffer);
+	for (int t = 0; t < FAULT_TYPE_COUNT; ++t)
+	{
+		result.faults[t] = m.faults.total(static_cast<faultType>(t));
+	}
+	return result;
+}
+
+bool writeBatchReport(const std::string& path, const std::vector<batchJob>& jobs, const std::vector<batchResult>& results,
+	unsigned int workers, double wallMs)
+{
+	FILE* out = fopen(path.c_str(), "wb");
+	if (!out)
+	{
+		LOG_ERROR("Failed to open batch report: %s", path.c_str());
+		return false;
+	}
+
+	uint64_t totalInstructions = 0;
+	for (const batchResult& r : results)
+	{
+		totalInstructions += r.instructions;
+	}
+
+	fprintf(out, "{\n  \"roms\": %zu,\n  \"workers\": %u,\n  \"wallMs\": %.3f,\n  \"totalInstructions\": %llu,\n  \"aggregateIps\": %.0f,\n  \"results\": [\n",
+		jobs.size(), workers, wallMs, static_cast<unsigned long long>(totalInstructions),
+		wallMs > 0.0 ? static_cast<double>(totalInstructions) * 1000.0 / wallMs : 0.0);
+
+	for (std::size_t i = 0; i < jobs.size(); ++i)
+	{
+		const batchJob& job = jobs[i];
+		const batchResult& r = results[i];
+
+		fputs("    {\"name\": ", out);
+		writeJsonString(out, job.name.c_str());
+		fputs(", \"rom\": ", out);
+		writeJsonString(out, job.romPath.c_str());
+		fprintf(out, ", \"status\": \"%s\", \"frames\": %d, \"instructions\": %llu, \"wallMs\": %.3f, \"ips\": %.0f, \"romHash\": \"%016llx\", \"digest\": \"%016llx\", \"framebuffer\": \"",
+			batchStatusName(r.status), r.framesRun, static_cast<unsigned long long>(r.instructions), r.wallMs, r.ips,
+			static_cast<unsigned long long>(r.romHash), static_cast<unsigned long long>(r.digest));
+		for (uint8_t byte : r.framebuffer)
+		{
+			fprintf(out, "%02x", byte);
+		}
+		fputs("\", \"faults\": {", out);
+		for (int t = 0; t < FAULT_TYPE_COUNT; ++t)
+		{
+			fprintf(out, "%s\"%s\": %llu", t ? ", " : "", faultTypeName(static_cast<faultType>(t)), static_cast<unsigned long long>(r.faults[t]));
+		}
+		fprintf(out, "}}%s\n", i + 1 < jobs.size() ? "," : "");
+	}
+	fputs("  ]\n}\n", out);
+
+	const bool ok = ferror(out) == 0;
+	fclose(out);
+	return ok;
+}
+
+int runBatch(const batchOptions& options)
+{
+	std::vector<batchJob> jobs;
+	if (!loadBatchJobs(options.inputPath, options.defaultFrames, jobs))
+	{
+		return 1;
+	}
+	if (jobs.empty())
+	{
+		LOG_ERROR("No ROMs found in %s", options.inputPath.c_str());
+		return 1;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	// Map each distinct ROM once; jobs that repeat a ROM share the image and its decoded words.
+	// Jobs from a pack already point into its mapping.
+	for (batchJob& job : jobs)
+	{
+		if (!job.image)
+		{
+			job.image = romImage::load(job.romPath);
+		}
+	}
+
+	std::vector<batchResult> results(jobs.size());
+	unsigned int workers = 0;
+	{
+		threadPool pool(options.jobs, "batch", false, options.numa);
+		workers = pool.size();
+		LOG("Running %zu ROMs on %u workers", jobs.size(), workers);
+		pool.parallelFor(jobs.size(), [&](std::size_t i) { results[i] = runBatchJob(jobs[i], options); });
+	}
+	const double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	int failures = 0;
+	for (std::size_t i = 0; i < jobs.size(); ++i)
+	{
+		if (results[i].status != BATCH_OK)
+		{
+			++failures;
+			LOG_WARNING("%s: %s", jobs[i].name.c_str(), batchStatusName(results[i].status));
+		}
+	}
+
+	if (!writeBatchReport(options.reportPath, jobs, results, workers, wallMs))
+	{
+		return 1;
+	}
+	LOG("Batch finished in %.1f ms: %zu ROMs, %d failed, report written to %s", wallMs, jobs.size(), failures, options.reportPath.c_str());
+	return failures == 0 ? 0 : 1;
+}
+
+int runBuildPack(const packOptions& options)
+{
+	std::vector<batchJob> jobs;
+	if (!loadBatchJobs(options.inputPath, options.defaultFrames, jobs))
+	{
+		return 1;
+	}
+	if (jobs.empty())
+	{
+		LOG_ERROR("No ROMs found in %s", options.inputPath.c_str());
+		return 1;
+	}
+
+	std::vector<romPack::source> sources;
+	sources.reserve(jobs.size());
+	for (const batchJob& job : jobs)
+	{
+		romPack::source source;
+		source.name = job.name;
+		source.image = job.image ? job.image : romImage::load(job.romPath);
+		if (!source.image)
+		{
+			LOG_ERROR("Failed to load %s", job.romPath.c_str());
+			return 1;
+		}
+		source.metadata = packMetadata(job);
+		sources.push_back(std::move(source));
+	}
+
+	if (!romPack::write(options.outputPath, sources))
+	{
+		return 1;
+	}
+	std::error_code ec;
+	LOG("Packed %zu ROMs into %s (%llu bytes)", sources.size(), options.outputPath.c_str(),
+		static_cast<unsigned long long>(fs::file_size(options.outputPath, ec)));
+	return 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fault.h"
+
+class inputScript;
+class romImage;
+
+struct batchOptions
+{
+	std::string inputPath;						// directory of ROMs or a manifest file
+	std::string reportPath = "batch-report.json";
+	int defaultFrames = 600;					// frames per ROM when the manifest does not say
+	int cyclesPerFrame = 700 / 60;				// matches the GUI's default speed
+	unsigned int jobs = 0;						// 0 = one worker per hardware thread
+	bool numa = false;							// pin workers to NUMA nodes, machines in node-local memory
+	int timeoutMs = 30000;						// per-ROM wall-clock watchdog
+	unsigned int seed = 1;						// RNG seed so digests are reproducible
+};
+
+struct batchJob
+{
+	std::string name;
+	std::string romPath;
+	std::string inputPath; // optional input script
+	std::string inputText; // input script carried inline by a ROM pack; used when inputPath is empty
+	int frames = 0;
+	std::shared_ptr<const romImage> image; // preloaded by runBatch; shared by duplicate ROMs
+};
+
+enum batchStatus
+{
+	BATCH_OK = 0,
+	BATCH_LOAD_FAILED,
+	BATCH_INPUT_FAILED,
+	BATCH_TIMEOUT
+};
+
+struct batchResult
+{
+	batchStatus status = BATCH_OK;
+	int framesRun = 0;
+	uint64_t instructions = 0;
+	double wallMs = 0.0;
+	double ips = 0.0;
+	uint64_t digest = 0;
+	uint64_t romHash = 0;
+	uint8_t framebuffer[256] = {}; // 64x32, row-major, 8 pixels per byte, MSB first
+	uint64_t faults[FAULT_TYPE_COUNT] = {};
+};
+
+const char* batchStatusName(batchStatus status);
+
+// Expands a directory (every .ch8 below it), a ROM pack or a manifest into jobs.
+// Manifest lines: <rom> [frames] [input-script], paths relative to the manifest.
+// Pack entries arrive with their images already mapped.
+bool loadBatchJobs(const std::string& inputPath, int defaultFrames, std::vector<batchJob>& jobs);
+
+// Fills `script` from the job's input file or inline text; true if there is none
+bool loadJobInput(const batchJob& job, inputScript& script);
+
+// Runs one ROM headlessly; safe to call concurrently
+batchResult runBatchJob(const batchJob& job, const batchOptions& options);
+
+bool writeBatchReport(const std::string& path, const std::vector<batchJob>& jobs, const std::vector<batchResult>& results,
+	unsigned int workers, double wallMs);
+
+// Entry point for --batch. Returns a process exit code.
+int runBatch(const batchOptions& options);
+
+struct packOptions
+{
+	std::string inputPath; // directory of ROMs or a manifest, as for --batch
+	std::string outputPath = "corpus.c8pk";
+	int defaultFrames = 600;
+};
+
+// Entry point for --build-pack: writes the jobs of a directory or manifest into one
+// ROM pack, keeping each job's frame count and input script. Returns an exit code.
+int runBuildPack(const packOptions& options);
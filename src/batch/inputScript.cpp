@@ -0,0 +1,66 @@
+#include "batch/inputScript.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+bool inputScript::load(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		LOG_ERROR("Failed to open input script: %s", path.c_str());
+		return false;
+	}
+	std::stringstream text;
+	text << file.rdbuf();
+	return parse(text.str());
+}
+
+bool inputScript::parse(const std::string& text)
+{
+	events.clear();
+	cursor = 0;
+
+	std::istringstream lines(text);
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(lines, line))
+	{
+		++lineNumber;
+		const std::size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#')
+			continue;
+
+		std::istringstream fields(line);
+		int frame = 0;
+		std::string key;
+		std::string action;
+		if (!(fields >> frame >> key >> action) || frame < 0 || key.size() != 1 || !isxdigit(static_cast<unsigned char>(key[0]))
+			|| (action != "down" && action != "up"))
+		{
+			LOG_ERROR("Input script line %d: expected '<frame> <key 0-F> <down|up>'", lineNumber);
+			return false;
+		}
+		addEvent(frame, static_cast<uint8_t>(std::stoi(key, nullptr, 16)), action == "down");
+	}
+	return true;
+}
+
+void inputScript::addEvent(int frame, uint8_t key, bool down)
+{
+	const event e = { frame, static_cast<uint8_t>(key & 0x0Fu), down };
+	// Keep file order for events on the same frame
+	auto at = std::upper_bound(events.begin(), events.end(), e, [](const event& a, const event& b) { return a.frame < b.frame; });
+	events.insert(at, e);
+}
+
+void inputScript::apply(int frame, uint8_t keypad[16])
+{
+	while (cursor < events.size() && events[cursor].frame <= frame)
+	{
+		keypad[events[cursor].key] = events[cursor].down ? 1 : 0;
+		++cursor;
+	}
+}
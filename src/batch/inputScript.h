@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scripted keypad input for headless runs. One event per line:
+//   <frame> <key 0-F> <down|up>
+// Blank lines and lines starting with '#' are ignored.
+class inputScript
+{
+public:
+	struct event
+	{
+		int frame;
+		uint8_t key;
+		bool down;
+	};
+
+	bool load(const std::string& path);
+	bool parse(const std::string& text);
+	void addEvent(int frame, uint8_t key, bool down);
+
+	// Rewinds to frame 0
+	void restart() { cursor = 0; }
+	// Applies every event scheduled at or before `frame` that has not been applied yet
+	void apply(int frame, uint8_t keypad[16]);
+
+	bool empty() const { return events.empty(); }
+	const std::vector<event>& getEvents() const { return events; }
+
+private:
+	std::vector<event> events; // sorted by frame
+	std::size_t cursor = 0;
+};
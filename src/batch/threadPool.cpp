@@ -0,0 +1,282 @@
+#include "batch/threadPool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#ifdef _WIN32
+	#include <_windows.h>
+#elif defined(__linux__)
+	#include <sched.h>
+	#include <sys/resource.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+#include "trace/trace.h"
+
+namespace
+{
+	// Pool and worker index owning this thread; currentPool is null outside any pool
+	thread_local const threadPool* currentPool = nullptr;
+	thread_local unsigned int currentWorker = 0;
+	thread_local int currentNode = -1;
+
+	void lowerThreadPriority()
+	{
+#ifdef _WIN32
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__linux__)
+		// Linux applies nice values per thread
+		setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#endif
+	}
+
+#ifdef __linux__
+	// Expands a sysfs list such as "0-3,8-11"; empty if it does not parse
+	std::vector<int> parseList(const std::string& text)
+	{
+		std::vector<int> values;
+		const char* at = text.c_str();
+		while (*at)
+		{
+			char* end = nullptr;
+			const long first = strtol(at, &end, 10);
+			if (end == at)
+				return {};
+			long last = first;
+			at = end;
+			if (*at == '-')
+			{
+				last = strtol(at + 1, &end, 10);
+				if (end == at + 1)
+					return {};
+				at = end;
+			}
+			for (long v = first; v <= last; ++v)
+			{
+				values.push_back(static_cast<int>(v));
+			}
+			if (*at != ',')
+				break;
+			++at;
+		}
+		return values;
+	}
+
+	std::vector<int> readList(const std::string& path)
+	{
+		std::ifstream file(path);
+		std::string text;
+		std::getline(file, text);
+		return parseList(text);
+	}
+#endif
+
+	// NUMA nodes that have CPUs; empty when that cannot be determined
+	std::vector<int> numaNodes()
+	{
+#ifdef _WIN32
+		std::vector<int> nodes;
+		ULONG highest = 0;
+		if (!GetNumaHighestNodeNumber(&highest))
+			return nodes;
+		for (ULONG node = 0; node <= highest; ++node)
+		{
+			GROUP_AFFINITY affinity = {};
+			if (GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity) && affinity.Mask)
+			{
+				nodes.push_back(static_cast<int>(node));
+			}
+		}
+		return nodes;
+#elif defined(__linux__)
+		return readList("/sys/devices/system/node/has_cpu");
+#else
+		return {};
+#endif
+	}
+
+	bool pinToNode(int node)
+	{
+#ifdef _WIN32
+		GROUP_AFFINITY affinity = {};
+		return GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity) && SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr);
+#elif defined(__linux__)
+		const std::vector<int> cpus = readList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int cpu : cpus)
+		{
+			if (cpu >= 0 && cpu < CPU_SETSIZE)
+			{
+				CPU_SET(cpu, &set);
+			}
+		}
+		return !cpus.empty() && sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+		(void)node;
+		return false;
+#endif
+	}
+}
+
+threadPool::threadPool(unsigned int threads, const char* name, bool background, bool pinToNodes)
+	: name(name), background(background)
+{
+	if (threads == 0)
+	{
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	if (pinToNodes)
+	{
+		const std::vector<int> nodes = numaNodes();
+		if (nodes.size() > 1)
+		{
+			for (unsigned int i = 0; i < threads; ++i)
+			{
+				workerNodes.push_back(nodes[i % nodes.size()]);
+			}
+			LOG("%s: pinning %u workers across %zu NUMA nodes", name, threads, nodes.size());
+		}
+		else
+		{
+			LOG("%s: one NUMA node, workers are not pinned", name);
+		}
+	}
+
+	for (unsigned int i = 0; i < threads; ++i)
+	{
+		queues.push_back(std::make_unique<worker>());
+	}
+	for (unsigned int i = 0; i < threads; ++i)
+	{
+		workers.emplace_back(&threadPool::workerLoop, this, i);
+	}
+}
+
+threadPool::~threadPool()
+{
+	wait();
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		stopping = true;
+	}
+	wakeWorkers.notify_all();
+	for (std::thread& t : workers)
+	{
+		t.join();
+	}
+}
+
+void threadPool::submit(std::function<void()> task)
+{
+	const unsigned int target = currentPool == this
+		? currentWorker
+		: nextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+
+	pending.fetch_add(1, std::memory_order_acq_rel);
+	{
+		std::lock_guard<std::mutex> guard(queues[target]->lock);
+		queues[target]->tasks.push_back(std::move(task));
+	}
+	{
+		// Taking sleepLock orders the increment against a worker about to sleep
+		std::lock_guard<std::mutex> guard(sleepLock);
+		queued.fetch_add(1, std::memory_order_release);
+	}
+	wakeWorkers.notify_one();
+}
+
+void threadPool::wait()
+{
+	std::unique_lock<std::mutex> guard(sleepLock);
+	allDone.wait(guard, [this] { return pending.load(std::memory_order_acquire) == 0; });
+}
+
+void threadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& body)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		submit([&body, i] { body(i); });
+	}
+	wait();
+}
+
+bool threadPool::popLocal(unsigned int index, std::function<void()>& task)
+{
+	worker& own = *queues[index];
+	std::lock_guard<std::mutex> guard(own.lock);
+	if (own.tasks.empty())
+		return false;
+	task = std::move(own.tasks.back());
+	own.tasks.pop_back();
+	return true;
+}
+
+bool threadPool::steal(unsigned int thief, std::function<void()>& task)
+{
+	const unsigned int count = size();
+	for (unsigned int offset = 1; offset < count; ++offset)
+	{
+		worker& victim = *queues[(thief + offset) % count];
+		std::unique_lock<std::mutex> guard(victim.lock, std::try_to_lock);
+		if (!guard.owns_lock() || victim.tasks.empty())
+			continue;
+		task = std::move(victim.tasks.front());
+		victim.tasks.pop_front();
+		return true;
+	}
+	return false;
+}
+
+void threadPool::workerLoop(unsigned int index)
+{
+	currentPool = this;
+	currentWorker = index;
+	trace::setThreadName(name);
+	if (!workerNodes.empty())
+	{
+		if (pinToNode(workerNodes[index]))
+		{
+			currentNode = workerNodes[index];
+		}
+		else
+		{
+			LOG_WARNING("%s: could not pin worker %u to NUMA node %d", name, index, workerNodes[index]);
+		}
+	}
+	if (background)
+	{
+		lowerThreadPriority();
+	}
+
+	std::function<void()> task;
+	while (true)
+	{
+		if (popLocal(index, task) || steal(index, task))
+		{
+			queued.fetch_sub(1, std::memory_order_acq_rel);
+			task();
+			task = nullptr;
+
+			if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				std::lock_guard<std::mutex> guard(sleepLock);
+				allDone.notify_all();
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> guard(sleepLock);
+		wakeWorkers.wait(guard, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+		if (stopping && queued.load(std::memory_order_acquire) == 0)
+			return;
+	}
+}
+
+int threadPool::pinnedNode()
+{
+	return currentNode;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool. Each worker owns a deque: it pops its own newest task
+// and, when empty, steals the oldest task from another worker. Tasks submitted from
+// outside the pool are spread round-robin; tasks submitted from a worker stay local.
+class threadPool
+{
+public:
+	// threads == 0 uses std::thread::hardware_concurrency(). Background pools run their
+	// workers at the lowest OS priority so they only soak up idle cores. With
+	// pinToNodes, workers are dealt round-robin over the NUMA nodes and each is pinned
+	// to its node's CPUs (a no-op on single-node machines).
+	explicit threadPool(unsigned int threads = 0, const char* name = "worker", bool background = false, bool pinToNodes = false);
+	~threadPool();
+
+	threadPool(const threadPool&) = delete;
+	threadPool& operator=(const threadPool&) = delete;
+
+	void submit(std::function<void()> task);
+	// Blocks until every submitted task has finished. Must not be called from a task.
+	void wait();
+	unsigned int size() const { return static_cast<unsigned int>(queues.size()); }
+
+	// Runs body(i) for i in [0, count) across the pool and waits
+	void parallelFor(std::size_t count, const std::function<void(std::size_t)>& body);
+
+	// NUMA node the calling thread is pinned to, or -1 outside a pinned pool
+	static int pinnedNode();
+
+private:
+	struct worker
+	{
+		std::mutex lock;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	void workerLoop(unsigned int index);
+	bool popLocal(unsigned int index, std::function<void()>& task);
+	bool steal(unsigned int thief, std::function<void()>& task);
+
+	std::vector<std::unique_ptr<worker>> queues;
+	std::vector<std::thread> workers;
+	const char* name;
+	bool background;
+	std::vector<int> workerNodes; // node per worker when pinning, else empty
+
+	std::mutex sleepLock;
+	std::condition_variable wakeWorkers;
+	std::condition_variable allDone;
+	std::atomic<std::size_t> queued{ 0 };  // submitted but not yet started
+	std::atomic<std::size_t> pending{ 0 }; // submitted but not yet finished
+	std::atomic<unsigned int> nextQueue{ 0 };
+	bool stopping = false;
+};
@@ -4,85 +4,29 @@
 #include "chip8.h"
 
 #include <chrono>
-#include <fstream>
 
 #include "raylib.h"
+#include "trace/startup.h"
+#include "trace/trace.h"
 
 chip8::chip8()
-	: randGen(std::chrono::system_clock::now().time_since_epoch().count())
+	: chip8(config())
 {
-	// Initialize the Chip-8 system
-	pc = entryPoint; // Program counter starts at 0x200
-	I = 0;			 // Index register
-	sp = 0;			 // Stack pointer
-	draw_flag = false;
-	delayTimer = 0;
-	soundTimer = 0;
-	instructionsPerSecond = 700;
-
-	randByte = std::uniform_int_distribution<int>(0, 255);
-
-	memset(V, 0, sizeof(V));
-	memset(stack, 0, sizeof(stack));
-	memset(memory, 0, sizeof(memory));
-
-	// Load the font set into memory at the specified address
-	for (unsigned int i = 0; i < sizeof(fontSet); ++i)
-	{
-		memory[fontSetStartAddress + i] = fontSet[i];
-	}
-
-	LOG("Font loaded into memory starting at address 0x%U", fontSetStartAddress);
-
-	// resetting display and keypad
-	memset(screen, 0, sizeof(screen));
-	memset(keypad, 0, sizeof(keypad));
-
-	beep = LoadSound("sound\\beep.wav");
 }
 
 chip8::chip8(const config& cfg)
-	: randGen(std::chrono::system_clock::now().time_since_epoch().count())
+	: cfg(cfg)
 {
-	// Initialize the Chip-8 system with configuration
-	pc = 0x200; // Program counter starts at 0x200
-	I = 0;		// Index register
-	sp = 0;		// Stack pointer
-	draw_flag = false;
-	delayTimer = 0;
-	soundTimer = 0;
 	instructionsPerSecond = cfg.cpuHz;
 
-	randByte = std::uniform_int_distribution<int>(0, 255);
-
-	memset(V, 0, sizeof(V));
-	memset(stack, 0, sizeof(stack));
-	memset(memory, 0, sizeof(memory));
-
-	// Load the font set into memory at the specified address
-	for (unsigned int i = 0; i < sizeof(fontSet); ++i)
-	{
-		memory[fontSetStartAddress + i] = fontSet[i];
-	}
-
-	LOG("Font loaded into memory starting at address 0x&U", fontSetStartAddress);
-
-	// resetting display and keypad
-	memset(screen, 0, sizeof(screen));
-	memset(keypad, 0, sizeof(keypad));
-
-	// this->cfg = cfg;
-
 	disp.setTitle("CHIP-8 Emulator");
 	disp.setSize(cfg.chip8Width * cfg.windowScale, cfg.chip8Height * cfg.windowScale);
 	disp.setFullscreen(false);
-
-	beep = LoadSound("sound\\beep.wav");
 }
 
 chip8::~chip8()
 {
-	UnloadSound(beep);
+	releaseAudio();
 }
 
 // Internal storage for the global chip8 instance (shared by all getters)
@@ -111,60 +55,79 @@ chip8& chip8::Get(const config& cfg)
 
 void chip8::resetChip8()
 {
-	// Initialize the Chip-8 system with configuration
-	pc = 0x200; // Program counter starts at 0x200
-	I = 0;		// Index register
-	sp = 0;		// Stack pointer
-	draw_flag = false;
-	delayTimer = 0;
-	soundTimer = 0;
-	instructionsPerSecond = 700;
-
-	randByte = std::uniform_int_distribution<int>(0, 255);
-
-	memset(V, 0, sizeof(V));
-	memset(stack, 0, sizeof(stack));
-	memset(memory, 0, sizeof(memory));
-
-	// Load the font set into memory at the specified address
-	for (unsigned int i = 0; i < sizeof(fontSet); ++i)
+	// Speed and quirks are settings, not guest state, so both survive
+	if (!restart())
 	{
-		memory[fontSetStartAddress + i] = fontSet[i];
+		reset();
 	}
+}
 
-	LOG("Font loaded into memory starting at address 0x&U", fontSetStartAddress);
+bool chip8::openRom(const std::string& path)
+{
+	quirks = autoQuirks ? resolveQuirks(path, quirkDetection) : configuredQuirks;
+	return loadRom(path);
+}
 
-	// resetting display and keypad
-	memset(screen, 0, sizeof(screen));
-	memset(keypad, 0, sizeof(keypad));
+bool chip8::openLibraryEntry(const romEntry& entry)
+{
+	reset();
+	filepath = entry.path;
+	instructionsPerSecond = entry.known && entry.metadata.tickrate > 0 ? entry.metadata.tickrate * 60 : cfg.cpuHz;
+	if (entry.known && entry.metadata.hasQuirks)
+	{
+		quirks = entry.metadata.quirks;
+		return loadRom(entry.path);
+	}
+	return openRom(entry.path);
 }
 
 void chip8::run()
 {
-	checkNonChip8Inputs();
+	{
+		TRACE_ZONE("checkNonChip8Inputs");
+		checkNonChip8Inputs();
+	}
+	pollFileDialog();
 
 	switch (state)
 	{
 		case chip8States::MENU:
 		{
+			TRACE_ZONE("gui::run");
+			PERF_STAGE(metrics, STAGE_GUI);
 			guiInstance.run(this);
 			break;
 		}
 		case chip8States::RUNNING:
 		{
-
-			emulateCycle();
+			{
+				TRACE_ZONE("emulateCycle");
+				PERF_STAGE(metrics, STAGE_EMULATION);
+				emulateCycle();
+			}
 			if (draw_flag == true)
 			{
+				TRACE_ZONE("updateDisplay");
+				PERF_STAGE(metrics, STAGE_RENDER);
 				disp.updateDisplay();
 				draw_flag = false;
 			}
+			if (session.saveIntervalSeconds > 0 && GetTime() - lastSessionSave >= session.saveIntervalSeconds)
+			{
+				saveSessionNow();
+			}
 
 			break;
 		}
 		case chip8States::PAUSED:
 		{
-			disp.updateDisplay();
+			{
+				TRACE_ZONE("updateDisplay");
+				PERF_STAGE(metrics, STAGE_RENDER);
+				disp.updateDisplay();
+			}
+			TRACE_ZONE("drawpauseMenu");
+			PERF_STAGE(metrics, STAGE_GUI);
 			guiInstance.drawpauseMenu(this);
 			// Do nothing, just wait for unpause
 			break;
@@ -180,88 +143,143 @@ void chip8::run()
 		}
 	}
 
+	TRACE_ZONE("drawChip8DebugWindow");
+	PERF_STAGE(metrics, STAGE_GUI);
 	guiInstance.drawChip8DebugWindow(*this, &showDebugWindow);
+	guiInstance.drawPerfHud(*this, &showPerfHud);
 }
 
-void chip8::loadRom(const std::string& romFilepath)
+void chip8::emulateCycle()
 {
-	try
+	updateKeys();
+	// loop to emulate the number of cycles per frame
+	const int cyclesPerFrame = instructionsPerSecond / 60;
+	metrics.addInstructions(runCycles(cyclesPerFrame));
+	faults.tick();
+	if (faults.takeHaltRequest())
+	{
+		// Stop at the faulting instruction and show the debugger
+		state = chip8States::PAUSED;
+		showDebugWindow = true;
+		LOG("Halted on fault at PC 0x%03X", pc);
+	}
+	// Play the beep while the sound timer is set
+	if (soundTimer > 0)
 	{
-		// bounded direct read
-		std::ifstream file(romFilepath, std::ios::binary | std::ios::ate);
-		if (!file.is_open())
+		if (beepReady() && !IsSoundPlaying(beep))
 		{
-			LOG_ERROR("Failed to open ROM");
-			return;
+			PlaySound(beep);
 		}
-
-		const std::streamsize romSize = static_cast<std::streamsize>(file.tellg());
-		file.seekg(0, std::ios::beg);
-
-		const std::size_t capacity = sizeof(memory) - static_cast<std::size_t>(entryPoint);
-		// Clamp the number of bytes to read so we never write past the end of memory.
-		const std::size_t toLoad = std::min<std::size_t>(static_cast<std::size_t>(romSize), capacity);
-
-		if (toLoad == 0)
+	}
+	else
+	{
+		if (beepLoaded && IsSoundPlaying(beep))
 		{
-			LOG_ERROR("ROM too large or no capacity");
-			return;
+			StopSound(beep);
 		}
+	}
+	tickTimers();
+}
 
-		// Read ROM bytes directly into the memory window starting at 0x200.
-		file.read(reinterpret_cast<char*>(memory + entryPoint), static_cast<std::streamsize>(toLoad));
-
-		if (!file)
-		{
-			LOG_ERROR("ROM read failed: read %lld of %zu bytes", static_cast<long long>(file.gcount()), toLoad);
-		}
-		else if (toLoad < static_cast<std::size_t>(romSize))
+void chip8::pollFileDialog()
+{
+	fileDialog::result chosen;
+	while (romDialog.poll(chosen))
+	{
+		if (chosen.outcome == fileDialog::DIALOG_ERROR)
 		{
-			LOG_ERROR("ROM truncated: %zu bytes didn't fit", static_cast<std::size_t>(romSize) - toLoad);
+			LOG_ERROR("File dialog: %s", chosen.error.c_str());
+			continue;
 		}
-		else
+		if (chosen.outcome != fileDialog::DIALOG_OK)
+			continue;
+
+		LOG("Rom Path: %s", chosen.path.c_str());
+		filepath = chosen.path;
+		// A full reset drops the previous image, so a file edited since is read again
+		reset();
+		instructionsPerSecond = cfg.cpuHz;
+		if (openRom(filepath))
 		{
-			LOG("Loaded ROM: %s (%lld bytes)", romFilepath.c_str(), static_cast<long long>(romSize));
+			state = chip8States::RUNNING;
 		}
 	}
-	catch (const std::exception& e)
+}
+
+bool chip8::beepReady()
+{
+	if (audioStarted)
+		return beepLoaded;
+	// Only ROMs that beep pay for the audio device, and only once
+	audioStarted = true;
+	const uint64_t start = trace::nowNs();
+	InitAudioDevice();
+	if (IsAudioDeviceReady())
 	{
-		LOG_ERROR("Failed to load ROM: %s", e.what());
+		SetMasterVolume(muted ? 0.0f : 1.0f);
+		// Copied next to the executable by the build, so the working directory does not matter
+		const std::string path = std::string(GetApplicationDirectory()) + "sound/beep.wav";
+		beep = LoadSound(path.c_str());
+		beepLoaded = IsSoundValid(beep);
+		if (!beepLoaded)
+		{
+			LOG_WARNING("Cannot load %s; the ROM will be silent", path.c_str());
+		}
 	}
+	startup::lateInit("audio", start);
+	return beepLoaded;
 }
 
-void chip8::emulateCycle()
+void chip8::releaseAudio()
 {
-	updateKeys();
-	// loop to emulate the number of cycles per frame
-	for (int i = 0; i < instructionsPerSecond / 60; ++i)
+	if (beepLoaded)
 	{
-		uint16_t opcode = fetchInstruction();
-
-		pc += 2; // Move to the next instruction
-		executeInstruction(opcode);
+		UnloadSound(beep);
+		beepLoaded = false;
 	}
-	// Decrement the delay timer if it's been set
-	if (delayTimer > 0)
+	if (audioStarted && IsAudioDeviceReady())
 	{
-		--delayTimer;
+		CloseAudioDevice();
 	}
+}
 
-	// Decrement the sound timer if it's been set
-	if (soundTimer > 0)
+thumbnailCache* chip8::libraryThumbnails()
+{
+	if (!thumbnails && library)
 	{
-		if (!IsSoundPlaying(beep))
-		{
-			PlaySound(beep);
-		}
-		soundTimer--;
+		const uint64_t start = trace::nowNs();
+		thumbnails = std::make_unique<thumbnailCache>(thumbnailSettings);
+		startup::lateInit("ROM previews", start);
 	}
-	else
+	return thumbnails.get();
+}
+
+bool chip8::resumeSession()
+{
+	const auto start = std::chrono::steady_clock::now();
+	sessionInfo info;
+	if (!loadSession(session.path, *this, info))
+		return false;
+	filepath = info.romPath;
+	instructionsPerSecond = info.instructionsPerSecond;
+	state = chip8States::RUNNING;
+	lastSessionSave = GetTime();
+	LOG("Resumed %s in %.2f ms", filepath.c_str(), std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	return true;
+}
+
+void chip8::saveSessionNow()
+{
+	lastSessionSave = GetTime();
+	if (!loadedImage())
+		return;
+	sessionInfo info;
+	info.romPath = filepath;
+	info.instructionsPerSecond = instructionsPerSecond;
+	info.quirks = quirks;
+	if (saveSession(session.path, *this, info))
 	{
-		if (IsSoundPlaying(beep))
-		{
-			StopSound(beep);
-		}
+		sessionResumable = true;
 	}
 }
 
@@ -321,16 +339,34 @@ void chip8::checkNonChip8Inputs()
 		showDebugWindow = !showDebugWindow;
 	}
 
+	// performance overlay
+	if (IsKeyPressed(KEY_F3))
+	{
+		showPerfHud = !showPerfHud;
+	}
+
 	// mute audio
 	if (IsKeyPressed(KEY_M))
 	{
-		if (GetMasterVolume() == 0)
+		muted = !muted;
+		if (audioStarted && IsAudioDeviceReady())
+		{
+			SetMasterVolume(muted ? 0.0f : 1.0f);
+		}
+	}
+
+	// trace capture: first press starts recording, second press writes the file
+	if (IsKeyPressed(KEY_F9))
+	{
+		if (!trace::isEnabled())
 		{
-			SetMasterVolume(100);
+			trace::setEnabled(true);
+			LOG("Trace capture started");
 		}
 		else
 		{
-			SetMasterVolume(0);
+			trace::setEnabled(false);
+			trace::dump(tracePath);
 		}
 	}
 
@@ -346,453 +382,3 @@ void chip8::checkNonChip8Inputs()
 		}
 	}
 }
-
-uint16_t chip8::fetchInstruction()
-{
-	const uint16_t opcode = (memory[pc] << 8u) | (memory[pc + 1]);
-	opcode_history.push_back(opcode);
-	return opcode;
-}
-
-void chip8::executeInstruction(uint16_t opcode)
-{
-	// LOG("Opcode: 0x%x", opcode);
-	//  Decode and execute the opcode
-	switch (opcode & 0xF000)
-	{
-		case 0x0000: // 0x00E0, 0x00EE
-			switch (opcode & 0x00FF)
-			{
-				case 0x00E0:
-				{
-					// Clears the screen.
-					memset(screen, 0, sizeof(screen));
-					draw_flag = true;
-					break;
-				}
-				case 0x00EE:
-				{
-					--sp;			// Decrement stack pointer
-					pc = stack[sp]; // Set program counter to the address at the top of the stack
-					break;
-				}
-				default:
-				{
-					LOG_ERROR("Unknown opcode [0x0000]: 0x%X", opcode);
-					/* SYS addr */
-					break;
-				}
-			}
-			break;
-		/* JP addr */
-		case 0x1000:
-		{
-			// gets the address from the opcode (the lowest 12 bits) and sets the program counter to that address. stack is not required for this operation.
-			uint16_t address = opcode & 0x0FFFu;
-			pc = address;
-			break;
-		}
-		/* CALL addr */
-		case 0x2000:
-		{
-			uint16_t address = opcode & 0x0FFFu;
-
-			stack[sp] = pc;
-			++sp;
-			pc = address;
-			break;
-		}
-		/* SE Vx, byte */
-		case 0x3000:
-		{
-			const uint8_t Vx = getVxRegistry(opcode);
-			uint8_t byte = opcode & 0x00FFu;
-
-			if (V[Vx] == byte)
-			{
-				pc += 2; // Skip the next instruction if Vx == byte
-			}
-
-			break;
-		}
-		/* SNE Vx, byte */
-		case 0x4000:
-		{
-			const uint8_t Vx = getVxRegistry(opcode);
-			uint8_t byte = opcode & 0x00FFu;
-
-			if (V[Vx] != byte)
-			{
-				pc += 2; // Skip the next instruction if Vx != byte
-			}
-			break;
-		}
-		/* SE Vx, Vy */
-		case 0x5000:
-		{
-			const uint8_t Vx = getVxRegistry(opcode);
-			const uint8_t Vy = getVyRegistry(opcode);
-
-			if (V[Vx] == V[Vy])
-			{
-				pc += 2; // Skip the next instruction if Vx == Vy
-			}
-			break;
-		}
-		/* LD Vx, byte */
-		case 0x6000:
-		{
-			const uint8_t Vx = getVxRegistry(opcode);
-			uint8_t byte = opcode & 0x00FFu;
-			V[Vx] = byte; // Load byte into Vx
-			break;
-		}
-		/* ADD Vx, byte */
-		case 0x7000:
-		{
-			const uint8_t Vx = getVxRegistry(opcode);
-			uint8_t byte = opcode & 0x00FFu;
-			V[Vx] += byte; // Add byte to Vx
-			break;
-		}
-		case 0x8000:
-			switch (opcode & 0x000F)
-			{
-				/* LD Vx, Vy */
-				case 0x0:
-				{
-					const uint8_t Vx = getVxRegistry(opcode);
-					const uint8_t Vy = getVyRegistry(opcode);
-					V[Vx] = V[Vy]; // Load value of Vy into Vx
-					break;
-				}
-				/* OR Vx, Vy */
-				case 0x1:
-				{
-					const uint8_t Vx = getVxRegistry(opcode);
-					const uint8_t Vy = getVyRegistry(opcode);
-					V[Vx] |= V[Vy]; // Bitwise OR Vx and Vy
-					break;
-				}
-				/* AND Vx, Vy */
-				case 0x2:
-				{
-					const uint8_t Vx = getVxRegistry(opcode);
-					const uint8_t Vy = getVyRegistry(opcode);
-					V[Vx] &= V[Vy]; // Bitwise AND Vx and Vy
-					break;
-				}
-				/* XOR Vx, Vy */
-				case 0x3:
-				{
-					const uint8_t Vx = getVxRegistry(opcode);
-					const uint8_t Vy = getVyRegistry(opcode);
-					V[Vx] ^= V[Vy]; // Bitwise XOR Vx and Vy
-					break;
-				}
-				/* ADD Vx, Vy */
-				case 0x4:
-				{
-					const uint8_t Vx = getVxRegistry(opcode);
-					const uint8_t Vy = getVyRegistry(opcode);
-					uint16_t sum = V[Vx] + V[Vy];
-					uint8_t carry = (sum > 0xFF) ? 1 : 0;
-
-					V[Vx] = static_cast<uint8_t>(sum & 0xFF); // Store the result in Vx, keeping it within 8 bits
-					V[0xF] = carry;							  // Set carry flag if overflow occurs
-					break;
-				}
-				/* SUB Vx, Vy */
-				case 0x5:
-				{
-					const uint8_t Vx = getVxRegistry(opcode);
-					const uint8_t Vy = getVyRegistry(opcode);
-					const uint8_t origX = V[Vx];
-					const uint8_t origY = V[Vy];
-					const uint8_t carry = (origY > origX) ? 0 : 1;
-					V[Vx] = origX - origY; // Subtract Vy from Vx#
-					V[0xF] = carry;		   // Set the carry flag if Vx > Vy
-
-					break;
-				}
-				/* SHR Vx */
-				case 0x6:
-				{
-					const uint8_t Vx = getVxRegistry(opcode);
-					const uint8_t origX = V[Vx];
-
-					const uint8_t carry = V[Vx] & 0x1u;
-					V[Vx] = origX >> 1; // Shift Vx right by 1 bit (division by 2)
-					V[0xF] = carry;		// Set the carry flag to the least significant bit
-
-					break;
-				}
-				/* SUBN Vx, Vy */
-				case 0x7:
-				{
-					const uint8_t Vx = getVxRegistry(opcode);
-					const uint8_t Vy = getVyRegistry(opcode);
-					const uint8_t carry = (V[Vx] > V[Vy]) ? 0 : 1;
-
-					V[Vx] = static_cast<uint8_t>(V[Vy] - V[Vx]); // Subtract Vx from Vy
-					V[0xF] = carry;								 // Set the carry flag if Vy > Vx
-					break;
-				}
-				/* SHL Vx */
-				case 0xE:
-				{
-					const uint8_t Vx = getVxRegistry(opcode);
-					const uint8_t carry = (V[Vx] & 0x80u) >> 7u;
-
-					V[Vx] <<= 1;	// Shift Vx left by 1 bit (multiplication by 2)
-					V[0xF] = carry; // Set the carry flag to the most significant bit
-					break;
-				}
-				default:
-					LOG_ERROR("Unknown opcode [0x8000]: 0x%X", opcode);
-					break;
-			}
-			break;
-		/* SNE Vx, Vy */
-		case 0x9000:
-		{
-			const uint8_t Vx = getVxRegistry(opcode);
-			const uint8_t Vy = getVyRegistry(opcode);
-			if (V[Vx] != V[Vy])
-			{
-				pc += 2; // Skip the next instruction if Vx != Vy
-			}
-			break;
-		}
-		/* LD I, addr */
-		case 0xA000:
-		{
-			const uint16_t address = opcode & 0x0FFFu;
-			I = address; // Load the address into the index register I
-			break;
-		}
-		/* JP V0, addr */
-		case 0xB000:
-		{
-			const uint16_t address = opcode & 0x0FFFu;
-			pc = address + V[0]; // Jump to the address plus the value of V0
-			break;
-		}
-		/* RND Vx, byte */
-		case 0xC000:
-		{
-			const uint8_t Vx = getVxRegistry(opcode);
-			uint8_t byte = opcode & 0x00FFu;
-			V[Vx] = static_cast<uint8_t>(randByte(randGen)) & byte; // Generate a random byte and AND it with the byte from the opcode
-			break;
-		}
-		/* DRW Vx, Vy, nibble */
-		case 0xD000:
-		{
-			uint8_t Vx = getVxRegistry(opcode);
-			uint8_t Vy = getVyRegistry(opcode);
-			uint8_t height = opcode & 0x000Fu; // Get the height of the sprite to draw
-
-			V[0xF] = 0; // Clear the collision flag
-			for (uint8_t row = 0; row < height; ++row)
-			{
-				uint8_t spriteRow = memory[I + row]; // Get the sprite row from memory
-				for (uint8_t col = 0; col < 8; ++col)
-				{
-					if ((spriteRow & (0x80 >> col)) != 0) // Check if the pixel is set
-					{
-						uint8_t x = (V[Vx] + col) % 64; // Wrap around the screen width
-						uint8_t y = (V[Vy] + row) % 32; // Wrap around the screen height
-
-						if (screen[x][y] == 1) // Check for collision
-						{
-							V[0xF] = 1; // Set collision flag
-						}
-						screen[x][y] ^= 1; // Toggle the pixel on the display
-					}
-				}
-			}
-			draw_flag = true; // Indicate that the screen needs to be redrawn
-			break;
-		}
-		case 0xE000:
-			switch (opcode & 0x00FF)
-			{
-				/* SKP Vx */
-				case 0x9E:
-				{
-					const uint8_t key = V[getVxRegistry(opcode)];
-					if (keypad[key])
-					{
-						pc += 2; // Skip the next instruction if the key in Vx is pressed
-					}
-					break;
-				}
-				/* SKNP Vx */
-				case 0xA1:
-				{
-					const uint8_t key = V[getVxRegistry(opcode)];
-					if (!keypad[key])
-					{
-						pc += 2; // Skip the next instruction if the key in Vx is pressed
-					}
-					break;
-				}
-				default:
-					LOG_ERROR("Unknown opcode [0xE000]: 0x%X", opcode);
-					break;
-			}
-			break;
-		case 0xF000:
-			switch (opcode & 0x00FF)
-			{
-				/* LD Vx, DT */
-				case 0x07:
-				{
-					V[getVxRegistry(opcode)] = delayTimer; // Load the value of the delay timer into Vx
-					break;
-				}
-				/* LD Vx, K */
-				case 0x0A:
-				{
-					uint8_t Vx = getVxRegistry(opcode);
-					if (keypad[0])
-					{
-						V[Vx] = 0;
-					}
-					else if (keypad[1])
-					{
-						V[Vx] = 1;
-					}
-					else if (keypad[2])
-					{
-						V[Vx] = 2;
-					}
-					else if (keypad[3])
-					{
-						V[Vx] = 3;
-					}
-					else if (keypad[4])
-					{
-						V[Vx] = 4;
-					}
-					else if (keypad[5])
-					{
-						V[Vx] = 5;
-					}
-					else if (keypad[6])
-					{
-						V[Vx] = 6;
-					}
-					else if (keypad[7])
-					{
-						V[Vx] = 7;
-					}
-					else if (keypad[8])
-					{
-						V[Vx] = 8;
-					}
-					else if (keypad[9])
-					{
-						V[Vx] = 9;
-					}
-					else if (keypad[10])
-					{
-						V[Vx] = 10;
-					}
-					else if (keypad[11])
-					{
-						V[Vx] = 11;
-					}
-					else if (keypad[12])
-					{
-						V[Vx] = 12;
-					}
-					else if (keypad[13])
-					{
-						V[Vx] = 13;
-					}
-					else if (keypad[14])
-					{
-						V[Vx] = 14;
-					}
-					else if (keypad[15])
-					{
-						V[Vx] = 15;
-					}
-					else
-					{
-						pc -= 2;
-					}
-					break;
-				}
-				/* LD DT, Vx */
-				case 0x15:
-				{
-					delayTimer = V[getVxRegistry(opcode)]; // Load the value of Vx into the delay timer
-					break;
-				}
-				/* LD ST, Vx */
-				case 0x18:
-				{
-					soundTimer = V[getVxRegistry(opcode)];
-					break;
-				}
-				/* ADD I, Vx */
-				case 0x1E:
-				{
-					I += V[getVxRegistry(opcode)]; // Add the value of Vx to the index register I
-					break;
-				}
-				/* LD F, Vx */
-				case 0x29:
-				{
-					uint8_t key = V[getVxRegistry(opcode)];
-
-					I = fontSetStartAddress + (key * 5); // Set I to the address of the font character corresponding to Vx
-					break;
-				}
-				/* LD B, Vx */
-				case 0x33:
-				{
-					// takes the decimal value of Vx, and places the hundreds digit in memory at location in I, the tens digit at location I+1, and the ones digit at location I+2.
-					uint8_t value = V[getVxRegistry(opcode)];
-					memory[I + 2] = value % 10;
-					value /= 10;
-					memory[I + 1] = value % 10;
-					value /= 10;
-					memory[I] = value % 10;
-					break;
-				}
-				/* LD [I], Vx */
-				case 0x55:
-				{
-					const uint8_t Vx = getVxRegistry(opcode);
-					for (uint8_t i = 0; i <= Vx; ++i)
-					{
-						memory[I + i] = V[i]; // Store the values of V0 to Vx in memory starting at address I
-					}
-					break;
-				}
-				/* LD Vx, [I] */
-				case 0x65:
-				{
-					const uint8_t Vx = getVxRegistry(opcode);
-					for (uint8_t i = 0; i <= Vx; ++i)
-					{
-						V[i] = memory[I + i]; // Store the values of V0 to Vx in memory starting at address I
-					}
-					break;
-				}
-				default:
-				{
-					LOG_ERROR("Unknown opcode: 0x%x", opcode);
-					break;
-				}
-			}
-			break;
-		default:
-			LOG_ERROR("Unknown opcode: 0x%x", opcode);
-			break;
-	}
-}
\ No newline at end of file
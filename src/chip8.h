@@ -1,8 +1,16 @@
 ﻿#pragma once
 
-#include <random>
+#include <memory>
+
 #include "display.h"
 #include "gui.h"
+#include "fileDialog.h"
+#include "library/romLibrary.h"
+#include "library/thumbnailCache.h"
+#include "session/session.h"
+#include "machine.h"
+#include "quirks/quirkDetector.h"
+#include "trace/metrics.h"
 
 struct config
 {
@@ -13,7 +21,7 @@ struct config
 	const int chip8Width = 64;
 	const int chip8Height = 32;
 	const std::string name = "Chip-8 Emulator";
-	const int cpuHz = 60;
+	const int cpuHz = 700; // instructions per second
 };
 
 enum chip8States
@@ -24,7 +32,7 @@ enum chip8States
 	QUIT
 };
 
-class chip8
+class chip8 : public machine
 {
 public:
 	chip8();
@@ -32,104 +40,63 @@ public:
 	~chip8();
 	static chip8& Get();
 	static chip8& Get(const config& cfg);
+	// Restarts the loaded ROM from its in-memory image, keeping speed and quirks
 	void resetChip8();
+	// Loads a ROM with its detected quirk profile when autoQuirks is set, otherwise with configuredQuirks
+	bool openRom(const std::string& path);
+	// Loads a library ROM with the speed and quirks the database recommends, if any
+	bool openLibraryEntry(const romEntry& entry);
 	void run();
-	void loadRom(const std::string& filepath);
 	void emulateCycle();
 	void updateKeys();
 	void checkNonChip8Inputs();
+	// Opens the ROM chosen in a file dialog that finished since the last frame
+	void pollFileDialog();
+	// Restores the last session and starts running it; false if there is none
+	bool resumeSession();
+	// Writes the session file if a ROM is loaded
+	void saveSessionNow();
+	// Unloads the beep and closes the audio device, if the ROM ever beeped
+	void releaseAudio();
+	// Preview cache, started (with its worker pool) the first time the browser asks; null without a library
+	thumbnailCache* libraryThumbnails();
 
 	chip8(const chip8& obj) = delete;
 
-	uint16_t fetchInstruction();
-	void executeInstruction(uint16_t opcode);
-
 public:
 	static chip8* instancePTR;
 
 	chip8States state = MENU;
 
-	uint8_t memory[4096];
-
-	// General purpose registers (V0-VF)
-	uint8_t V[16];
-
-	// Index register
-	uint16_t I;
-
-	// Program counter
-	uint16_t pc;
-
-	// Stack for subroutine calls
-	uint16_t stack[16];
-
-	// Stack pointer
-	uint8_t sp;
-
-	// Delay timer
-	uint8_t delayTimer;
-
-	// Sound timer
-	uint8_t soundTimer;
-
-	// Graphics buffer (64x32 pixels)
-	uint8_t screen[64][32];
-
-	// Flag to indicate if the screen needs to be redrawn
-	bool draw_flag;
-
-	// Keypad state (hex-based input)
-	uint8_t keypad[16];
-	std::vector<uint16_t> opcode_history;
-
 	display disp;
 	gui guiInstance;
 
-	// Font set for CHIP-8, each character is 5x5 pixels
-	uint8_t fontSet[80] = {
-		0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
-		0x20, 0x60, 0x20, 0x20, 0x70, // 1
-		0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
-		0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
-		0x90, 0x90, 0xF0, 0x10, 0x10, // 4
-		0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
-		0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
-		0xF0, 0x10, 0x20, 0x40, 0x40, // 7
-		0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
-		0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
-		0xF0, 0x90, 0xF0, 0x90, 0x90, // A
-		0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
-		0xF0, 0x80, 0x80, 0x80, 0xF0, // C
-		0xE0, 0x90, 0x90, 0x90, 0xE0, // D
-		0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
-		0xF0, 0x80, 0xF0, 0x80, 0x80  // F
-	};
-
-	// font start point
-	const unsigned int fontSetStartAddress = 0x50;
-
-	const int entryPoint = 0x200;
-
 	std::string filepath;
+	fileDialog romDialog; // "Load ROM" from the menus; the result is applied by run()
+	bool autoQuirks = false; // --quirks auto
+	quirkProfile configuredQuirks; // --quirks profile; library entries and sessions only override it per ROM
+	quirkDetectOptions quirkDetection;
+	std::unique_ptr<romLibrary> library; // null unless --library was given
+	thumbnailOptions thumbnailSettings;
+	std::unique_ptr<thumbnailCache> thumbnails; // previews for the library browser, see libraryThumbnails()
+	sessionOptions session;
+	bool sessionResumable = false; // a session file exists; the main menu offers it
 	bool showDebugWindow = false; // Toggle for debug window
+	std::string tracePath = "chip8-trace.json"; // Written when trace capture stops (F9)
+	bool showPerfHud = false;					 // Toggle for performance overlay (F3)
+	perfMetrics metrics;
+
+	int getInstructionsPerSecond() const { return instructionsPerSecond; }
 private:
 	static chip8* instance;
 	config cfg;
 	int instructionsPerSecond;
-	std::default_random_engine randGen;
-	std::uniform_int_distribution<int> randByte;
-
-	Sound beep;
-
-	inline uint8_t getVxRegistry(const uint16_t opcode)
-	{
-		// And bitwise operation to extract the Vx register from the opcode then bit shifting right by 8 bits
-		return (opcode & 0x0F00u) >> 8u; // Extract Vx from opcode
-	}
-
-	inline uint8_t getVyRegistry(const uint16_t opcode)
-	{
-		// And bitwise operation to extract the Vy register from the opcode then bit shifting right by 4 bits
-		return (opcode & 0x00F0u) >> 4u; // Extract Vx from opcode
-	}
+	double lastSessionSave = 0.0; // GetTime() of the last periodic save
+
+	// Opens the audio device and loads the beep on the first call; false if either failed
+	bool beepReady();
+	bool audioStarted = false;
+	bool muted = false; // M key; applied when the device opens, so it holds before the first beep
+	bool beepLoaded = false;
+	Sound beep = {};
 };
\ No newline at end of file
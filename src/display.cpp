@@ -29,15 +29,24 @@ void display::draw()
 void display::drawPixel(const int x, const int y)
 {
 	DrawRectangle(x * scale, y * scale, scale, scale, WHITE);
+	++drawCalls;
 }
 
 void display::updateDisplay()
 {
 	ClearBackground(BLACK);
+	++drawCalls;
 
 	draw();
 }
 
+int display::takeDrawCalls()
+{
+	const int calls = drawCalls;
+	drawCalls = 0;
+	return calls;
+}
+
 void display::setTitle(const std::string& title) {}
 
 void display::setScale(int scale)
@@ -24,6 +24,8 @@ public:
 	void setScale(int scale);
 	void setSize(int width, int height);
 	void setFullscreen(bool fullscreen);
+	// Draw calls issued since the last call, then resets the counter
+	int takeDrawCalls();
 
 private:
 	int cols = 64;
@@ -31,4 +33,5 @@ private:
 	int scale = 20;
 	int width = 64;
 	int height = 32;
+	int drawCalls = 0;
 };
\ No newline at end of file
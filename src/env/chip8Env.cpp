@@ -0,0 +1,388 @@
+#include "env/chip8Env.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "lockstep/lockstep.h"
+#include "machine.h"
+#include "rom/romImage.h"
+#include "trace/trace.h"
+
+namespace
+{
+	// Envs are grouped into lockstep blocks; the last block may have idle lanes
+	using envBlock = lockstepEngine<8>;
+	constexpr int blockLanes = envBlock::laneCount;
+
+	class blockWorkers;
+}
+
+struct chip8_env
+{
+	chip8_env_config config;
+	int count = 0;
+	int height = 0;
+	int width = 0;
+	int frameBytes = 0;
+	std::shared_ptr<const romImage> rom;
+	std::vector<std::unique_ptr<envBlock>> blocks;
+
+	// Last frame_stack frames per env as a ring: [env][slot][frameBytes]
+	std::vector<uint8_t> history;
+	std::vector<int> newestSlot;
+	std::vector<uint32_t> score;
+	std::vector<int> episodeFrames;
+
+	std::unique_ptr<blockWorkers> workers; // null when running on the caller's thread only
+
+	// Arguments of the step in flight, read by every block
+	const int32_t* actions = nullptr;
+	uint8_t* observations = nullptr;
+	float* rewards = nullptr;
+	uint8_t* dones = nullptr;
+};
+
+namespace
+{
+	uint32_t readScore(const chip8_env& env, const envBlock& block, int lane)
+	{
+		uint32_t score = 0;
+		for (int i = 0; i < env.config.reward_address_count; ++i)
+		{
+			score += block.memory[lane][env.config.reward_addresses[i] & machine::addressMask];
+		}
+		return score;
+	}
+
+	// Downsamples the lane's screen into the env's next history slot
+	void captureFrame(chip8_env& env, int index, const envBlock& block, int lane)
+	{
+		const int stack = env.config.frame_stack;
+		const int ds = env.config.downsample;
+		const int slot = (env.newestSlot[index] + 1) % stack;
+		env.newestSlot[index] = slot;
+
+		uint8_t* out = &env.history[(static_cast<std::size_t>(index) * stack + slot) * env.frameBytes];
+		const uint8_t (&screen)[64][32] = block.screen[lane];
+		for (int oy = 0; oy < env.height; ++oy)
+		{
+			for (int ox = 0; ox < env.width; ++ox)
+			{
+				uint8_t lit = 0;
+				for (int dy = 0; dy < ds; ++dy)
+				{
+					for (int dx = 0; dx < ds; ++dx)
+					{
+						lit |= screen[ox * ds + dx][oy * ds + dy];
+					}
+				}
+				out[oy * env.width + ox] = lit & 1u;
+			}
+		}
+	}
+
+	// Copies the env's frame stack, oldest first, into the caller's array
+	void writeObservation(const chip8_env& env, int index, uint8_t* observations)
+	{
+		const int stack = env.config.frame_stack;
+		const std::size_t envBytes = static_cast<std::size_t>(stack) * env.frameBytes;
+		const uint8_t* ring = &env.history[index * envBytes];
+		uint8_t* out = observations + index * envBytes;
+		for (int i = 0; i < stack; ++i)
+		{
+			const int slot = (env.newestSlot[index] + 1 + i) % stack;
+			memcpy(out + static_cast<std::size_t>(i) * env.frameBytes, ring + static_cast<std::size_t>(slot) * env.frameBytes, env.frameBytes);
+		}
+	}
+
+	void restartEnv(chip8_env& env, int index, envBlock& block, int lane)
+	{
+		block.resetLane(lane);
+		block.loadLaneRom(lane, env.rom->data(), env.rom->size());
+		env.score[index] = readScore(env, block, lane);
+		env.episodeFrames[index] = 0;
+		// Fill the whole stack with the first frame
+		for (int i = 0; i < env.config.frame_stack; ++i)
+		{
+			captureFrame(env, index, block, lane);
+		}
+	}
+
+	void stepBlock(chip8_env& env, int blockIndex)
+	{
+		const int32_t* actions = env.actions;
+		float* rewards = env.rewards;
+		uint8_t* dones = env.dones;
+
+		envBlock& block = *env.blocks[blockIndex];
+		const int first = blockIndex * blockLanes;
+		const int lanes = std::min(blockLanes, env.count - first);
+
+		for (int lane = 0; lane < lanes; ++lane)
+		{
+			const int32_t action = actions[first + lane];
+			memset(block.keypad[lane], 0, sizeof(block.keypad[lane]));
+			if (action >= 1 && action <= 16)
+			{
+				block.keypad[lane][action - 1] = 1;
+			}
+		}
+
+		for (int frame = 0; frame < env.config.frame_skip; ++frame)
+		{
+			block.runCycles(env.config.cycles_per_frame);
+			block.tickTimers();
+		}
+
+		for (int lane = 0; lane < lanes; ++lane)
+		{
+			const int index = first + lane;
+			const uint32_t score = readScore(env, block, lane);
+			rewards[index] = static_cast<float>(static_cast<int64_t>(score) - static_cast<int64_t>(env.score[index]));
+			env.score[index] = score;
+			env.episodeFrames[index] += env.config.frame_skip;
+
+			bool done = env.config.done_address >= 0 && block.memory[lane][env.config.done_address] == env.config.done_value;
+			done |= env.config.max_episode_frames > 0 && env.episodeFrames[index] >= env.config.max_episode_frames;
+			dones[index] = done ? 1 : 0;
+
+			if (done)
+			{
+				restartEnv(env, index, block, lane);
+			}
+			else
+			{
+				captureFrame(env, index, block, lane);
+			}
+			writeObservation(env, index, env.observations);
+		}
+	}
+
+	void resetBlock(chip8_env& env, int blockIndex)
+	{
+		envBlock& block = *env.blocks[blockIndex];
+		const int first = blockIndex * blockLanes;
+		const int lanes = std::min(blockLanes, env.count - first);
+		for (int lane = 0; lane < lanes; ++lane)
+		{
+			restartEnv(env, first + lane, block, lane);
+			writeObservation(env, first + lane, env.observations);
+		}
+	}
+
+	using blockFunction = void (*)(chip8_env&, int);
+
+	// Threads kept for the life of the env. run() publishes the function, wakes them,
+	// and then claims blocks from a shared counter alongside them until every block is
+	// done. A step allocates and queues nothing; its cost is one wake-up and one
+	// atomic increment per block.
+	class blockWorkers
+	{
+	public:
+		blockWorkers(chip8_env& env, unsigned int helpers) : env(env), blockCount(static_cast<int>(env.blocks.size()))
+		{
+			for (unsigned int i = 0; i < helpers; ++i)
+			{
+				threads.emplace_back([this] { workerLoop(); });
+			}
+		}
+
+		~blockWorkers()
+		{
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+		}
+
+		void run(blockFunction function)
+		{
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				body.store(function, std::memory_order_relaxed);
+				finishedBlocks.store(0, std::memory_order_relaxed);
+				nextBlock.store(0, std::memory_order_release);
+				++generation;
+			}
+			wake.notify_all();
+			claimBlocks();
+			std::unique_lock<std::mutex> guard(lock);
+			allDone.wait(guard, [this] { return finishedBlocks.load(std::memory_order_acquire) == blockCount; });
+		}
+
+	private:
+		void workerLoop()
+		{
+			trace::setThreadName("env");
+			uint64_t seen = 0;
+			std::unique_lock<std::mutex> guard(lock);
+			for (;;)
+			{
+				wake.wait(guard, [&] { return stopping || generation != seen; });
+				if (stopping)
+					return;
+				seen = generation;
+				guard.unlock();
+				claimBlocks();
+				guard.lock();
+			}
+		}
+
+		void claimBlocks()
+		{
+			for (;;)
+			{
+				const int b = nextBlock.fetch_add(1, std::memory_order_acq_rel);
+				if (b >= blockCount)
+					return;
+				body.load(std::memory_order_relaxed)(env, b);
+				if (finishedBlocks.fetch_add(1, std::memory_order_acq_rel) + 1 == blockCount)
+				{
+					std::lock_guard<std::mutex> guard(lock);
+					allDone.notify_one();
+				}
+			}
+		}
+
+		chip8_env& env;
+		const int blockCount;
+		std::vector<std::thread> threads;
+		std::mutex lock;
+		std::condition_variable wake;
+		std::condition_variable allDone;
+		uint64_t generation = 0;
+		bool stopping = false;
+		std::atomic<blockFunction> body{ nullptr };
+		std::atomic<int> nextBlock{ 0 };
+		std::atomic<int> finishedBlocks{ 0 };
+	};
+
+	void forEachBlock(chip8_env& env, blockFunction function)
+	{
+		if (env.workers)
+		{
+			env.workers->run(function);
+			return;
+		}
+		for (int b = 0; b < static_cast<int>(env.blocks.size()); ++b)
+		{
+			function(env, b);
+		}
+	}
+}
+
+extern "C"
+{
+	void chip8_env_default_config(chip8_env_config* config)
+	{
+		memset(config, 0, sizeof(*config));
+		config->frame_skip = 4;
+		config->cycles_per_frame = 700 / 60;
+		config->frame_stack = 1;
+		config->downsample = 1;
+		config->done_address = -1;
+		config->seed = 1;
+		config->threads = 1;
+	}
+
+	chip8_env* chip8_env_create(const char* rom_path, int n_envs, const chip8_env_config* config)
+	{
+		chip8_env_config cfg;
+		if (config)
+		{
+			cfg = *config;
+		}
+		else
+		{
+			chip8_env_default_config(&cfg);
+		}
+
+		if (n_envs <= 0 || cfg.frame_skip < 1 || cfg.cycles_per_frame < 1 || cfg.frame_stack < 1
+			|| (cfg.downsample != 1 && cfg.downsample != 2 && cfg.downsample != 4)
+			|| cfg.reward_address_count < 0 || cfg.reward_address_count > CHIP8_ENV_MAX_REWARD_ADDRESSES
+			|| cfg.done_address > machine::addressMask)
+		{
+			LOG_ERROR("chip8_env_create: invalid configuration");
+			return nullptr;
+		}
+
+		auto env = std::make_unique<chip8_env>();
+		env->config = cfg;
+		env->rom = romImage::load(rom_path);
+		if (!env->rom)
+		{
+			return nullptr;
+		}
+		env->count = n_envs;
+		env->width = 64 / cfg.downsample;
+		env->height = 32 / cfg.downsample;
+		env->frameBytes = env->width * env->height;
+
+		const int blockCount = (n_envs + blockLanes - 1) / blockLanes;
+		for (int b = 0; b < blockCount; ++b)
+		{
+			// Lane l of block b is env b * blockLanes + l, seeded seed + env
+			env->blocks.push_back(std::make_unique<envBlock>(cfg.seed + static_cast<unsigned int>(b * blockLanes)));
+			if (!env->blocks.back()->loadRom(env->rom->data(), env->rom->size()))
+			{
+				return nullptr;
+			}
+		}
+
+		env->history.assign(static_cast<std::size_t>(n_envs) * cfg.frame_stack * env->frameBytes, 0);
+		env->newestSlot.assign(n_envs, 0);
+		env->score.assign(n_envs, 0);
+		env->episodeFrames.assign(n_envs, 0);
+
+		if (cfg.threads != 1 && blockCount > 1)
+		{
+			// The calling thread takes blocks too, so it counts as one of them
+			const unsigned int threads = cfg.threads ? cfg.threads : std::max(1u, std::thread::hardware_concurrency());
+			env->workers = std::make_unique<blockWorkers>(*env, std::min<unsigned int>(threads, blockCount) - 1);
+		}
+		return env.release();
+	}
+
+	void chip8_env_destroy(chip8_env* env)
+	{
+		delete env;
+	}
+
+	int chip8_env_count(const chip8_env* env)
+	{
+		return env->count;
+	}
+
+	void chip8_env_observation_shape(const chip8_env* env, int* frame_stack, int* height, int* width)
+	{
+		*frame_stack = env->config.frame_stack;
+		*height = env->height;
+		*width = env->width;
+	}
+
+	void chip8_env_reset(chip8_env* env, uint8_t* observations)
+	{
+		env->observations = observations;
+		forEachBlock(*env, resetBlock);
+	}
+
+	void chip8_env_step(chip8_env* env, const int32_t* actions, uint8_t* observations, float* rewards, uint8_t* dones)
+	{
+		env->actions = actions;
+		env->observations = observations;
+		env->rewards = rewards;
+		env->dones = dones;
+		forEachBlock(*env, stepBlock);
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+/*
+ * Vectorized CHIP-8 environment for reinforcement learning, exposed as a C ABI.
+ *
+ * One environment handle runs n_envs copies of a ROM. chip8_env_step() advances
+ * every copy by frame_skip frames and writes observations, rewards and done flags
+ * straight into caller-owned arrays; nothing is allocated after creation.
+ *
+ * Observations are uint8 arrays of shape [n_envs][frame_stack][height][width]
+ * holding 0 or 1, oldest frame first. With downsample = 2 or 4 each output pixel
+ * is lit if any pixel in its block is lit.
+ */
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(CHIP8_ENV_BUILD)
+#define CHIP8_ENV_API __declspec(dllexport)
+#else
+#define CHIP8_ENV_API __declspec(dllimport)
+#endif
+#else
+#define CHIP8_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define CHIP8_ENV_MAX_REWARD_ADDRESSES 8
+
+	typedef struct chip8_env chip8_env;
+
+	typedef struct chip8_env_config
+	{
+		int frame_skip;		  /* frames emulated per step, action held throughout (default 4) */
+		int cycles_per_frame; /* instructions per 60 Hz frame (default 11) */
+		int frame_stack;	  /* frames per observation (default 1) */
+		int downsample;		  /* 1, 2 or 4 (default 1) */
+		int max_episode_frames; /* truncates episodes; 0 = never (default 0) */
+
+		/* Score = sum of the bytes at these guest addresses; reward = score delta per step */
+		uint16_t reward_addresses[CHIP8_ENV_MAX_REWARD_ADDRESSES];
+		int reward_address_count;
+
+		/* Episode ends when memory[done_address] == done_value; done_address < 0 disables */
+		int done_address;
+		uint8_t done_value;
+
+		unsigned int seed; /* env i uses RNG seed seed + i (default 1) */
+		unsigned int threads; /* worker threads; 0 = one per hardware thread (default 1) */
+	} chip8_env_config;
+
+	CHIP8_ENV_API void chip8_env_default_config(chip8_env_config* config);
+
+	/* Returns NULL if the ROM cannot be loaded or the config is invalid. config may be NULL. */
+	CHIP8_ENV_API chip8_env* chip8_env_create(const char* rom_path, int n_envs, const chip8_env_config* config);
+	CHIP8_ENV_API void chip8_env_destroy(chip8_env* env);
+
+	CHIP8_ENV_API int chip8_env_count(const chip8_env* env);
+	/* Observation shape for one env: frame_stack x height x width bytes */
+	CHIP8_ENV_API void chip8_env_observation_shape(const chip8_env* env, int* frame_stack, int* height, int* width);
+
+	/* Restarts every env and writes the first observations */
+	CHIP8_ENV_API void chip8_env_reset(chip8_env* env, uint8_t* observations);
+
+	/*
+	 * actions[i]: 0 = no key, 1..16 = hold key 0x0..0xF.
+	 * Envs that finish an episode report done = 1 and are restarted in place; their
+	 * observation is then the first frame of the new episode.
+	 */
+	CHIP8_ENV_API void chip8_env_step(chip8_env* env, const int32_t* actions, uint8_t* observations, float* rewards, uint8_t* dones);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,467 @@
+#include "explore/explorer.h"
+
+#include <algorithm>
+#include <bit>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "arena/machineArena.h"
+#include "batch/threadPool.h"
+#include "machine.h"
+#include "rom/romImage.h"
+#include "snapshot/snapshot.h"
+#include "trace/trace.h"
+#include "util/json.h"
+
+namespace
+{
+	struct cell
+	{
+		uint64_t key = 0;
+		snapshot state;
+		int depth = 0; // frames from reset
+		uint32_t chosen = 0;
+		uint32_t seen = 0;
+		uint8_t framebuffer[256] = {};
+	};
+
+	// Fenwick tree over the cells' selection weights, so adding a cell, changing its
+	// weight and drawing a cell are all O(log cells)
+	class weightTree
+	{
+	public:
+		void push(double weight)
+		{
+			// Node i sums (i - lowbit(i), i]: the new value plus the nodes it spans
+			const std::size_t i = tree.size() + 1;
+			double node = weight;
+			for (std::size_t step = 1; step < (i & (0 - i)); step <<= 1)
+			{
+				node += tree[i - step - 1];
+			}
+			tree.push_back(node);
+		}
+
+		void add(std::size_t index, double delta)
+		{
+			for (std::size_t i = index + 1; i <= tree.size(); i += i & (0 - i))
+			{
+				tree[i - 1] += delta;
+			}
+		}
+
+		double total() const
+		{
+			double sum = 0.0;
+			for (std::size_t i = tree.size(); i > 0; i -= i & (0 - i))
+			{
+				sum += tree[i - 1];
+			}
+			return sum;
+		}
+
+		// First index whose running total passes pick
+		std::size_t find(double pick) const
+		{
+			std::size_t position = 0;
+			for (std::size_t mask = std::bit_floor(tree.size()); mask > 0; mask >>= 1)
+			{
+				const std::size_t next = position + mask;
+				if (next <= tree.size() && tree[next - 1] <= pick)
+				{
+					position = next;
+					pick -= tree[next - 1];
+				}
+			}
+			return std::min(position, tree.size() - 1);
+		}
+
+	private:
+		std::vector<double> tree;
+	};
+
+	struct archive
+	{
+		std::shared_mutex lock;
+		std::vector<cell> cells;
+		std::unordered_map<uint64_t, std::size_t> index;
+		weightTree weights; // 1/sqrt(1 + chosen) per cell
+	};
+
+	double cellWeight(uint32_t chosen)
+	{
+		return 1.0 / std::sqrt(1.0 + chosen);
+	}
+
+	void addCell(archive& a, cell&& c)
+	{
+		a.index[c.key] = a.cells.size();
+		a.weights.push(cellWeight(c.chosen));
+		a.cells.push_back(std::move(c));
+	}
+
+	struct cellSummary
+	{
+		uint64_t key;
+		int depth;
+		uint32_t chosen;
+		uint32_t seen;
+		uint8_t framebuffer[256];
+	};
+
+	struct exploreResult
+	{
+		std::size_t cells = 0;
+		std::size_t screens = 0;
+		std::size_t pcsCovered = 0;
+		int maxDepth = 0;
+		uint64_t instructions = 0;
+		double wallMs = 0.0;
+		uint8_t covered[4096] = {};
+		std::vector<cellSummary> deepest; // up to 256 cells, deepest first
+	};
+
+	uint64_t mixKey(uint64_t hash, uint64_t value)
+	{
+		return (hash ^ value) * 0x100000001B3ull;
+	}
+
+	uint64_t computeCellKey(const machine& m, cellKeyMode mode)
+	{
+		uint64_t key = 0xCBF29CE484222325ull;
+		if (mode == CELL_RAM)
+		{
+			for (uint8_t value : m.V)
+			{
+				key = mixKey(key, value);
+			}
+			return mixKey(key, m.I);
+		}
+
+		// Screen: 8x4 blocks of 8x8 pixels, each block's lit count quantized to 0..3
+		for (int by = 0; by < 4; ++by)
+		{
+			for (int bx = 0; bx < 8; ++bx)
+			{
+				int lit = 0;
+				for (int x = bx * 8; x < bx * 8 + 8; ++x)
+				{
+					for (int y = by * 8; y < by * 8 + 8; ++y)
+					{
+						lit += m.screen[x][y] & 1;
+					}
+				}
+				const int level = lit == 0 ? 0 : lit < 16 ? 1 : lit < 40 ? 2 : 3;
+				key = mixKey(key, static_cast<uint64_t>(level));
+			}
+		}
+		return key;
+	}
+
+	uint64_t screenHash(const uint8_t packed[256])
+	{
+		uint64_t hash = 0xCBF29CE484222325ull;
+		for (int i = 0; i < 256; ++i)
+		{
+			hash = mixKey(hash, packed[i]);
+		}
+		return hash;
+	}
+
+	// Same as machine::runCycles, but marks every PC that executes
+	uint64_t runCovered(machine& m, int cycles, uint8_t covered[4096])
+	{
+		for (int i = 0; i < cycles; ++i)
+		{
+			covered[m.pc & machine::addressMask] = 1;
+			const uint16_t opcode = m.fetchInstruction();
+			m.pc += 2;
+			m.executeInstruction(opcode);
+		}
+		return static_cast<uint64_t>(cycles);
+	}
+
+	// Picks a cell with probability proportional to 1/sqrt(1 + times chosen)
+	std::size_t selectCell(const archive& a, std::minstd_rand& rng)
+	{
+		return a.weights.find(std::uniform_real_distribution<double>(0.0, a.weights.total())(rng));
+	}
+
+	void markChosen(archive& a, std::size_t i)
+	{
+		cell& c = a.cells[i];
+		const double before = cellWeight(c.chosen);
+		++c.chosen;
+		a.weights.add(i, cellWeight(c.chosen) - before);
+	}
+
+	// Runs one exploration (or, with fromRootOnly, plain random play from reset)
+	exploreResult explore(const exploreOptions& options, const std::shared_ptr<const romImage>& rom, bool fromRootOnly)
+	{
+		TRACE_ZONE("explore");
+		const auto start = std::chrono::steady_clock::now();
+
+		pageStore store;
+		archive arc;
+		threadPool pool(options.jobs, "explore", false, options.numa);
+		// The root and one machine per worker, side by side on separate cache lines
+		machineArena arena(pool.size() + 1);
+		{
+			const machineArena::handle root = arena.acquire(options.seed);
+			root->loadRom(rom);
+			cell first;
+			first.key = computeCellKey(*root, options.cellKey);
+			first.state = snapshot::capture(store, *root);
+			root->packScreen(first.framebuffer);
+			addCell(arc, std::move(first));
+		}
+
+		std::atomic<int> nextRollout{ 0 };
+		std::atomic<uint64_t> instructions{ 0 };
+		std::mutex mergeLock;
+		std::unordered_set<uint64_t> screens;
+		uint8_t covered[4096] = {};
+		// Revisit counts per worker, folded into the cells once the workers are done
+		std::vector<std::unordered_map<uint64_t, uint32_t>> seenBy(pool.size());
+
+		// Created here: the arena is not synchronized, the workers only use their own slot
+		std::vector<machineArena::handle> machines;
+		for (unsigned int w = 0; w < pool.size(); ++w)
+		{
+			machines.push_back(arena.acquire(options.seed + w));
+		}
+		for (unsigned int w = 0; w < pool.size(); ++w)
+		{
+			pool.submit([&, w] {
+				// A worker pinned by --numa runs on a machine in an arena on its own node
+				std::unique_ptr<machineArena> nodeArena;
+				machineArena::handle onNode;
+				if (threadPool::pinnedNode() >= 0)
+				{
+					nodeArena = std::make_unique<machineArena>(1, arenaOptions{ false, threadPool::pinnedNode() });
+					onNode = nodeArena->acquire(options.seed + w);
+				}
+				machine* m = onNode ? onNode.get() : machines[w].get();
+				m->recordHistory = false;
+				m->faults.maxFirstLogsPerInterval = 0;
+				std::minstd_rand rng(options.seed * 7919u + w + 1u);
+				std::unordered_set<uint64_t> localScreens;
+				std::vector<uint8_t> localCovered(4096, 0);
+				uint64_t localInstructions = 0;
+				std::unordered_map<uint64_t, uint32_t>& localSeen = seenBy[w];
+
+				while (nextRollout.fetch_add(1, std::memory_order_relaxed) < options.rollouts)
+				{
+					snapshot from;
+					int depth = 0;
+					{
+						std::unique_lock<std::shared_mutex> guard(arc.lock);
+						const std::size_t chosen = fromRootOnly ? 0 : selectCell(arc, rng);
+						markChosen(arc, chosen);
+						from = arc.cells[chosen].state;
+						depth = arc.cells[chosen].depth;
+					}
+					from.restore(*m);
+
+					int action = static_cast<int>(rng() % 17);
+					for (int step = 0; step < options.actionsPerRollout; ++step)
+					{
+						// Sticky actions: mostly keep pressing the same key
+						if (rng() % 4 == 0)
+						{
+							action = static_cast<int>(rng() % 17);
+						}
+						memset(m->keypad, 0, sizeof(m->keypad));
+						if (action > 0)
+						{
+							m->keypad[action - 1] = 1;
+						}
+						for (int f = 0; f < options.framesPerAction; ++f)
+						{
+							localInstructions += runCovered(*m, options.cyclesPerFrame, localCovered.data());
+							m->tickTimers();
+						}
+						depth += options.framesPerAction;
+
+						uint8_t packed[256];
+						m->packScreen(packed);
+						localScreens.insert(screenHash(packed));
+
+						const uint64_t key = computeCellKey(*m, options.cellKey);
+						bool wanted = false;
+						{
+							std::shared_lock<std::shared_mutex> guard(arc.lock);
+							auto it = arc.index.find(key);
+							wanted = it == arc.index.end() || depth < arc.cells[it->second].depth;
+							if (it != arc.index.end())
+							{
+								++localSeen[key];
+							}
+						}
+						if (!wanted)
+							continue;
+
+						// Capture outside the lock, then re-check: another worker may have got there first
+						cell found;
+						found.key = key;
+						found.depth = depth;
+						found.state = snapshot::capture(store, *m, &from);
+						memcpy(found.framebuffer, packed, sizeof(packed));
+
+						std::unique_lock<std::shared_mutex> guard(arc.lock);
+						auto it = arc.index.find(key);
+						if (it == arc.index.end())
+						{
+							addCell(arc, std::move(found));
+						}
+						else if (depth < arc.cells[it->second].depth)
+						{
+							// Shorter route to a known cell: keep it, but keep the cell's history
+							cell& existing = arc.cells[it->second];
+							existing.state = std::move(found.state);
+							existing.depth = depth;
+						}
+					}
+				}
+
+				std::lock_guard<std::mutex> guard(mergeLock);
+				screens.insert(localScreens.begin(), localScreens.end());
+				for (int pc = 0; pc < 4096; ++pc)
+				{
+					covered[pc] |= localCovered[pc];
+				}
+				instructions += localInstructions;
+			});
+		}
+		pool.wait();
+		for (const auto& local : seenBy)
+		{
+			for (const auto& [key, count] : local)
+			{
+				arc.cells[arc.index.at(key)].seen += count;
+			}
+		}
+
+		exploreResult result;
+		result.cells = arc.cells.size();
+		result.screens = screens.size();
+		memcpy(result.covered, covered, sizeof(covered));
+		result.pcsCovered = static_cast<std::size_t>(std::count(covered, covered + 4096, 1));
+		for (const cell& c : arc.cells)
+		{
+			result.maxDepth = std::max(result.maxDepth, c.depth);
+		}
+		result.instructions = instructions.load();
+		result.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		// Keep the deepest cells for the report
+		std::sort(arc.cells.begin(), arc.cells.end(), [](const cell& a, const cell& b) { return a.depth > b.depth; });
+		for (std::size_t i = 0; i < arc.cells.size() && i < 256; ++i)
+		{
+			const cell& c = arc.cells[i];
+			cellSummary summary = { c.key, c.depth, c.chosen, c.seen, {} };
+			memcpy(summary.framebuffer, c.framebuffer, sizeof(summary.framebuffer));
+			result.deepest.push_back(summary);
+		}
+		return result;
+	}
+
+	void writeCoverage(FILE* out, const uint8_t covered[4096])
+	{
+		// Executed instruction addresses as inclusive hex ranges; instructions are two
+		// bytes, so a range continues while the next one starts at most two bytes later
+		fputs("[", out);
+		bool first = true;
+		for (int pc = 0; pc < 4096; ++pc)
+		{
+			if (!covered[pc])
+				continue;
+			int end = pc;
+			while (end + 1 < 4096 && (covered[end + 1] || (end + 2 < 4096 && covered[end + 2])))
+			{
+				end += covered[end + 1] ? 1 : 2;
+			}
+			fprintf(out, "%s\"%03X-%03X\"", first ? "" : ", ", pc, end);
+			first = false;
+			pc = end;
+		}
+		fputs("]", out);
+	}
+}
+
+int runExplore(const exploreOptions& options)
+{
+	if (options.rollouts <= 0 || options.actionsPerRollout <= 0 || options.framesPerAction <= 0 || options.cyclesPerFrame <= 0)
+	{
+		LOG_ERROR("Exploration budgets must be positive");
+		return 1;
+	}
+	const std::shared_ptr<const romImage> rom = romImage::load(options.romPath);
+	if (!rom)
+	{
+		return 1;
+	}
+
+	LOG("Exploring %s: %d rollouts of %d actions", options.romPath.c_str(), options.rollouts, options.actionsPerRollout);
+	const exploreResult result = explore(options, rom, false);
+	LOG("Exploration: %zu cells, %zu screens, %zu PCs covered, deepest %d frames in %.1f ms", result.cells, result.screens,
+		result.pcsCovered, result.maxDepth, result.wallMs);
+
+	exploreResult baseline;
+	if (options.baseline)
+	{
+		baseline = explore(options, rom, true);
+		LOG("Random baseline: %zu cells, %zu screens, %zu PCs covered", baseline.cells, baseline.screens, baseline.pcsCovered);
+	}
+
+	FILE* out = fopen(options.reportPath.c_str(), "wb");
+	if (!out)
+	{
+		LOG_ERROR("Failed to open exploration report: %s", options.reportPath.c_str());
+		return 1;
+	}
+	fputs("{\n  \"rom\": ", out);
+	writeJsonString(out, options.romPath.c_str());
+	fprintf(out, ",\n  \"romHash\": \"%016llx\",\n  \"cellKey\": \"%s\",\n  \"rollouts\": %d,\n  \"wallMs\": %.3f,\n  \"instructions\": %llu,\n",
+		static_cast<unsigned long long>(rom->hash()), options.cellKey == CELL_RAM ? "ram" : "screen", options.rollouts, result.wallMs,
+		static_cast<unsigned long long>(result.instructions));
+	fprintf(out, "  \"cells\": %zu,\n  \"distinctScreens\": %zu,\n  \"maxDepthFrames\": %d,\n  \"pcCoverage\": %zu,\n  \"coveredPcs\": ",
+		result.cells, result.screens, result.maxDepth, result.pcsCovered);
+	writeCoverage(out, result.covered);
+	if (options.baseline)
+	{
+		fprintf(out, ",\n  \"baseline\": {\"cells\": %zu, \"distinctScreens\": %zu, \"maxDepthFrames\": %d, \"pcCoverage\": %zu}",
+			baseline.cells, baseline.screens, baseline.maxDepth, baseline.pcsCovered);
+	}
+	fputs(",\n  \"archive\": [\n", out);
+	for (std::size_t i = 0; i < result.deepest.size(); ++i)
+	{
+		const cellSummary& c = result.deepest[i];
+		fprintf(out, "    {\"key\": \"%016llx\", \"depthFrames\": %d, \"chosen\": %u, \"seen\": %u, \"framebuffer\": \"",
+			static_cast<unsigned long long>(c.key), c.depth, c.chosen, c.seen);
+		for (uint8_t byte : c.framebuffer)
+		{
+			fprintf(out, "%02x", byte);
+		}
+		fprintf(out, "\"}%s\n", i + 1 < result.deepest.size() ? "," : "");
+	}
+	fputs("  ]\n}\n", out);
+
+	const bool ok = ferror(out) == 0;
+	fclose(out);
+	if (ok)
+	{
+		LOG("Exploration report written to %s", options.reportPath.c_str());
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+enum cellKeyMode
+{
+	CELL_SCREEN = 0, // 8x4 grid of 8x8 blocks, lit-pixel count quantized to 2 bits each
+	CELL_RAM		 // V registers and I
+};
+
+struct exploreOptions
+{
+	std::string romPath;
+	std::string reportPath = "explore-report.json";
+	int rollouts = 50000;		   // total restore-and-explore iterations across all workers
+	int actionsPerRollout = 25;
+	int framesPerAction = 4;	   // each chosen key is held this many frames
+	int cyclesPerFrame = 700 / 60;
+	unsigned int jobs = 0;		   // 0 = one worker per hardware thread
+	bool numa = false;			   // see batchOptions::numa
+	unsigned int seed = 1;
+	cellKeyMode cellKey = CELL_SCREEN;
+	bool baseline = false;		   // also run the same budget of random play from reset, for comparison
+};
+
+// Go-Explore style exploration: keeps an archive of snapshots keyed by cell, restores
+// rarely chosen cells and explores from them with random sticky inputs. Writes a JSON
+// report with cell count, reached screens and PC coverage. Returns a process exit code.
+int runExplore(const exploreOptions& options);
@@ -0,0 +1,127 @@
+#include "fault.h"
+
+#include <cstring>
+
+const char* faultTypeName(faultType type)
+{
+	switch (type)
+	{
+		case FAULT_UNKNOWN_OPCODE:
+			return "unknown opcode";
+		case FAULT_STACK_OVERFLOW:
+			return "stack overflow";
+		case FAULT_STACK_UNDERFLOW:
+			return "stack underflow";
+		case FAULT_MEMORY_OUT_OF_RANGE:
+			return "memory out of range";
+		default:
+			return "invalid fault";
+	}
+}
+
+faultTracker::faultTracker()
+{
+	reset();
+}
+
+void faultTracker::reset()
+{
+	memset(seen, 0, sizeof(seen));
+	hotUsed = 0;
+	memset(totals, 0, sizeof(totals));
+	memset(totalsAtLastSummary, 0, sizeof(totalsAtLastSummary));
+	framesSinceSummary = 0;
+	firstLogsThisInterval = 0;
+	suppressedFirstLogs = 0;
+	haltRequested = false;
+}
+
+uint64_t faultTracker::totalAll() const
+{
+	uint64_t sum = 0;
+	for (int t = 0; t < FAULT_TYPE_COUNT; ++t)
+	{
+		sum += totals[t];
+	}
+	return sum;
+}
+
+bool faultTracker::takeHaltRequest()
+{
+	const bool halt = haltRequested;
+	haltRequested = false;
+	return halt;
+}
+
+void faultTracker::firstOccurrence(faultType type, uint16_t pc, uint16_t opcode)
+{
+	// A ROM running through data hits a new PC every cycle, so cap these too
+	if (firstLogsThisInterval >= maxFirstLogsPerInterval)
+	{
+		++suppressedFirstLogs;
+		return;
+	}
+	++firstLogsThisInterval;
+	LOG_ERROR("Fault: %s at PC 0x%03X (opcode 0x%04X)", faultTypeName(type), pc & 0xFFFu, opcode);
+}
+
+void faultTracker::countAt(faultType type, uint16_t pc)
+{
+	int smallest = 0;
+	for (int i = 0; i < hotUsed; ++i)
+	{
+		if (hot[i].pc == pc && hot[i].type == type)
+		{
+			++hot[i].count;
+			return;
+		}
+		if (hot[i].count < hot[smallest].count)
+		{
+			smallest = i;
+		}
+	}
+	if (hotUsed < hotPcSlots)
+	{
+		hot[hotUsed++] = { 1, pc, static_cast<uint8_t>(type) };
+		return;
+	}
+	hot[smallest] = { hot[smallest].count + 1, pc, static_cast<uint8_t>(type) };
+}
+
+void faultTracker::tick()
+{
+	if (++framesSinceSummary < summaryIntervalFrames)
+		return;
+
+	uint64_t newFaults = 0;
+	for (int t = 0; t < FAULT_TYPE_COUNT; ++t)
+	{
+		newFaults += totals[t] - totalsAtLastSummary[t];
+	}
+
+	if (newFaults > 0)
+	{
+		int hottest = 0;
+		for (int i = 1; i < hotUsed; ++i)
+		{
+			if (hot[i].count > hot[hottest].count)
+			{
+				hottest = i;
+			}
+		}
+
+		LOG_WARNING("%llu faults in the last %d frames (opcode %llu, stack over %llu, stack under %llu, memory %llu); hottest: %s at PC 0x%03X (%u total); %d first-occurrence logs suppressed",
+			static_cast<unsigned long long>(newFaults), framesSinceSummary,
+			static_cast<unsigned long long>(totals[FAULT_UNKNOWN_OPCODE] - totalsAtLastSummary[FAULT_UNKNOWN_OPCODE]),
+			static_cast<unsigned long long>(totals[FAULT_STACK_OVERFLOW] - totalsAtLastSummary[FAULT_STACK_OVERFLOW]),
+			static_cast<unsigned long long>(totals[FAULT_STACK_UNDERFLOW] - totalsAtLastSummary[FAULT_STACK_UNDERFLOW]),
+			static_cast<unsigned long long>(totals[FAULT_MEMORY_OUT_OF_RANGE] - totalsAtLastSummary[FAULT_MEMORY_OUT_OF_RANGE]),
+			faultTypeName(static_cast<faultType>(hot[hottest].type)), hot[hottest].pc, hot[hottest].count, suppressedFirstLogs);
+
+		memcpy(totalsAtLastSummary, totals, sizeof(totals));
+	}
+
+	framesSinceSummary = 0;
+	firstLogsThisInterval = 0;
+	suppressedFirstLogs = 0;
+}
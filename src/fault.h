@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+enum faultType
+{
+	FAULT_UNKNOWN_OPCODE = 0,
+	FAULT_STACK_OVERFLOW,
+	FAULT_STACK_UNDERFLOW,
+	FAULT_MEMORY_OUT_OF_RANGE,
+	FAULT_TYPE_COUNT
+};
+
+const char* faultTypeName(faultType type);
+
+// Counts guest faults per type. Only the first occurrence at each PC is logged (one bit
+// per PC and type remembers which were seen); repeats are counted in a small table of
+// the busiest PCs and reported in periodic summaries. About 2.3 KB in all.
+class faultTracker
+{
+public:
+	faultTracker();
+
+	inline void raise(faultType type, uint16_t pc, uint16_t opcode)
+	{
+		++totals[type];
+		const uint16_t at = pc & 0xFFFu;
+		uint64_t& word = seen[type][at >> 6];
+		const uint64_t bit = uint64_t{ 1 } << (at & 63u);
+		if (!(word & bit)) [[unlikely]]
+		{
+			word |= bit;
+			firstOccurrence(type, pc, opcode);
+		}
+		countAt(type, at);
+		haltRequested |= haltOnFault;
+	}
+
+	// Call once per emulated frame; logs a summary when new faults arrived during the interval
+	void tick();
+	void reset();
+
+	// True once after a fault was raised while haltOnFault is set
+	bool takeHaltRequest();
+	bool haltPending() const { return haltRequested; }
+
+	uint64_t total(faultType type) const { return totals[type]; }
+	uint64_t totalAll() const;
+	bool seenAt(faultType type, uint16_t pc) const { return (seen[type][(pc & 0xFFFu) >> 6] >> (pc & 63u)) & 1u; }
+
+	bool haltOnFault = false;
+	int summaryIntervalFrames = 300; // 5 seconds at 60 Hz
+	int maxFirstLogsPerInterval = 16;
+
+private:
+	void firstOccurrence(faultType type, uint16_t pc, uint16_t opcode);
+	void countAt(faultType type, uint16_t pc);
+
+	// Space-saving counters: a PC not in the table replaces the smallest entry and
+	// inherits its count, so the busiest PCs stay in and their counts are upper bounds
+	struct hotPc
+	{
+		uint32_t count;
+		uint16_t pc;
+		uint8_t type;
+	};
+	static constexpr int hotPcSlots = 16;
+
+	uint64_t seen[FAULT_TYPE_COUNT][4096 / 64];
+	hotPc hot[hotPcSlots];
+	int hotUsed = 0;
+	uint64_t totals[FAULT_TYPE_COUNT];
+	uint64_t totalsAtLastSummary[FAULT_TYPE_COUNT];
+	int framesSinceSummary = 0;
+	int firstLogsThisInterval = 0;
+	int suppressedFirstLogs = 0;
+	bool haltRequested = false;
+};
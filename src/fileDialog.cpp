@@ -0,0 +1,138 @@
+#include "fileDialog.h"
+
+#include <nfd.h>
+#include <thread>
+
+#include "trace/startup.h"
+#include "trace/trace.h"
+
+namespace
+{
+	std::string lastError()
+	{
+		const char* error = NFD_GetError();
+		return error ? error : "unknown error";
+	}
+}
+
+fileDialog::fileDialog() : state(std::make_shared<sharedState>())
+{
+}
+
+fileDialog::~fileDialog()
+{
+	// The worker finishes a dialog that is still up, then calls NFD_Quit and exits
+	{
+		std::lock_guard<std::mutex> guard(state->lock);
+		state->closing = true;
+	}
+	state->wake.notify_one();
+#ifdef __APPLE__
+	if (state->nfdReady)
+	{
+		NFD_Quit();
+	}
+#endif
+}
+
+bool fileDialog::open()
+{
+	{
+		std::lock_guard<std::mutex> guard(state->lock);
+		if (state->open)
+			return false;
+		state->open = true;
+#ifndef __APPLE__
+		if (!state->workerStarted)
+		{
+			// Detached: nothing waits on it, and the shared state keeps it valid until it returns
+			state->workerStarted = true;
+			std::thread(worker, state).detach();
+		}
+#endif
+	}
+#ifdef __APPLE__
+	// AppKit only allows dialogs on the main thread; the result still arrives through poll()
+	show(*state);
+#else
+	state->wake.notify_one();
+#endif
+	return true;
+}
+
+bool fileDialog::isOpen() const
+{
+	std::lock_guard<std::mutex> guard(state->lock);
+	return state->open;
+}
+
+bool fileDialog::poll(result& out)
+{
+	std::lock_guard<std::mutex> guard(state->lock);
+	if (state->completed.empty())
+		return false;
+	out = std::move(state->completed.front());
+	state->completed.pop_front();
+	return true;
+}
+
+void fileDialog::worker(std::shared_ptr<sharedState> shared)
+{
+	trace::setThreadName("file dialog");
+	std::unique_lock<std::mutex> guard(shared->lock);
+	for (;;)
+	{
+		shared->wake.wait(guard, [&] { return shared->open || shared->closing; });
+		if (shared->closing)
+			break;
+		guard.unlock();
+		show(*shared);
+		guard.lock();
+	}
+	if (shared->nfdReady)
+	{
+		NFD_Quit();
+	}
+}
+
+void fileDialog::show(sharedState& shared)
+{
+	result outcome;
+	// NFD_Init sets up the platform backend (COM, GTK, portal) for the calling thread,
+	// which is why every dialog runs on the same one
+	if (!shared.nfdReady)
+	{
+		const uint64_t start = trace::nowNs();
+		shared.nfdReady = NFD_Init() == NFD_OKAY;
+		startup::lateInit("file dialogs", start);
+	}
+	if (!shared.nfdReady)
+	{
+		outcome.outcome = DIALOG_ERROR;
+		outcome.error = lastError();
+	}
+	else
+	{
+		nfdu8char_t* outPath = nullptr;
+		nfdu8filteritem_t filters[1] = { { "Roms", "ch8" } };
+		nfdopendialogu8args_t args = { 0 };
+		args.filterList = filters;
+		args.filterCount = 1;
+		const nfdresult_t r = NFD_OpenDialogU8_With(&outPath, &args);
+		if (r == NFD_OKAY)
+		{
+			outcome.outcome = DIALOG_OK;
+			outcome.path = outPath;
+			NFD_FreePathU8(outPath);
+		}
+		else if (r == NFD_ERROR)
+		{
+			outcome.outcome = DIALOG_ERROR;
+			outcome.error = lastError();
+		}
+	}
+
+	std::lock_guard<std::mutex> guard(shared.lock);
+	shared.completed.push_back(std::move(outcome));
+	shared.open = false;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Native "open ROM" dialog that does not block the main loop. open() shows the dialog
+// from a worker thread; the frame loop picks up the outcome with poll(), so rendering,
+// timers and a running ROM carry on while the user browses. The worker and NFD are
+// started by the first open(), then kept for later dialogs.
+class fileDialog
+{
+public:
+	enum status
+	{
+		DIALOG_OK,
+		DIALOG_CANCEL,
+		DIALOG_ERROR
+	};
+
+	struct result
+	{
+		status outcome = DIALOG_CANCEL;
+		std::string path;  // set for DIALOG_OK
+		std::string error; // set for DIALOG_ERROR
+	};
+
+	fileDialog();
+	~fileDialog();
+
+	// Starts the dialog; false if one is already showing
+	bool open();
+	bool isOpen() const;
+	// Takes the next finished dialog's result, if any
+	bool poll(result& out);
+
+private:
+	// Shared with the worker, which may outlive this object if the app quits while the
+	// dialog is still up
+	struct sharedState
+	{
+		std::mutex lock;
+		std::condition_variable wake;
+		std::deque<result> completed;
+		bool open = false;
+		bool workerStarted = false;
+		bool closing = false;
+		bool nfdReady = false; // NFD_Init succeeded on the dialog thread
+	};
+
+	static void worker(std::shared_ptr<sharedState> state);
+	static void show(sharedState& state);
+
+	std::shared_ptr<sharedState> state;
+};
@@ -0,0 +1,139 @@
+// libFuzzer entry point for the interpreter. Built by the chip8-fuzz target when
+// configured with -DCHIP8_FUZZ=ON; with Clang it links libFuzzer, otherwise
+// CHIP8_FUZZ_MAIN adds a driver that runs files (or stdin) for AFL and crash replay.
+//
+// Input layout:
+//   byte 0        number of key-stream bytes k, taken from the end of the input
+//   bytes 1..n-k  ROM, loaded at 0x200
+//   last k bytes  one per frame: bit 7 = pressed, low nibble = key; later frames release all keys
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "machine.h"
+#include "snapshot/pageStore.h"
+#include "snapshot/snapshot.h"
+
+namespace
+{
+	constexpr int fuzzFrames = 32;
+	constexpr int fuzzCyclesPerFrame = 16;
+
+	struct fuzzState
+	{
+		machine m{1};
+		pageStore store;
+		snapshot pristine;
+
+		fuzzState()
+		{
+			m.recordHistory = false;
+			// Garbage ROMs fault on most cycles; count them, never log or halt
+			m.faults.maxFirstLogsPerInterval = 0;
+			m.faults.haltOnFault = false;
+			pristine = snapshot::capture(store, m);
+		}
+	};
+
+	fuzzState& state()
+	{
+		static fuzzState s;
+		return s;
+	}
+
+	void check(bool condition)
+	{
+		if (!condition)
+		{
+			abort();
+		}
+	}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	if (size < 1)
+		return 0;
+
+	fuzzState& s = state();
+	machine& m = s.m;
+
+	// Reset by restoring the pristine snapshot instead of constructing a machine. The
+	// snapshot does not cover the fault tracker: clear it too, so each input starts
+	// with no PCs seen and an empty hot table, whatever ran before it.
+	s.pristine.restore(m);
+	m.faults.reset();
+
+	const size_t keyBytes = data[0] < size - 1 ? data[0] : size - 1;
+	const uint8_t* rom = data + 1;
+	size_t romSize = size - 1 - keyBytes;
+	const uint8_t* keys = rom + romSize;
+	if (romSize > sizeof(m.memory) - machine::entryPoint)
+	{
+		romSize = sizeof(m.memory) - machine::entryPoint;
+	}
+	memcpy(m.memory + machine::entryPoint, rom, romSize);
+	m.invalidateSharedCode();
+	m.rehash();
+
+	for (int frame = 0; frame < fuzzFrames; ++frame)
+	{
+		memset(m.keypad, 0, sizeof(m.keypad));
+		if (static_cast<size_t>(frame) < keyBytes)
+		{
+			m.keypad[keys[frame] & 0x0Fu] = keys[frame] >> 7;
+		}
+		m.runCycles(fuzzCyclesPerFrame);
+		m.tickTimers();
+	}
+
+	// Invariants the interpreter promises for any input
+	check(m.sp <= machine::stackDepth);
+#ifdef CHIP8_STATE_HASH
+	// The incremental hash must match one recomputed from scratch
+	const uint64_t incremental = m.stateHash();
+	m.rehash();
+	check(m.stateHash() == incremental);
+#endif
+	return 0;
+}
+
+#ifdef CHIP8_FUZZ_MAIN
+static bool runFile(FILE* in)
+{
+	std::vector<uint8_t> bytes;
+	uint8_t buffer[4096];
+	size_t got;
+	while ((got = fread(buffer, 1, sizeof(buffer), in)) > 0)
+	{
+		bytes.insert(bytes.end(), buffer, buffer + got);
+	}
+	LLVMFuzzerTestOneInput(bytes.data(), bytes.size());
+	return ferror(in) == 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		return runFile(stdin) ? 0 : 1;
+	}
+	for (int i = 1; i < argc; ++i)
+	{
+		FILE* in = fopen(argv[i], "rb");
+		if (!in)
+		{
+			LOG_ERROR("Failed to open %s", argv[i]);
+			return 1;
+		}
+		const bool ok = runFile(in);
+		fclose(in);
+		if (!ok)
+			return 1;
+	}
+	return 0;
+}
+#endif
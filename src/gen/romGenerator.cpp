@@ -0,0 +1,395 @@
+#include "gen/romGenerator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+#include "machine.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	// Memory ops only address 0xE00-0xFFF, which generated code never reaches
+	constexpr uint16_t scratchBase = 0xE00;
+	constexpr std::size_t maxRomSize = scratchBase - machine::entryPoint;
+	constexpr int maxInstructions = 400; // slots expand to at most 3 words, so this stays under maxRomSize
+	constexpr int leafCount = 8;		 // call depth is at most 1 + leafCount, well inside the 16-entry stack
+	constexpr uint8_t counterRegister = 0xD;
+	constexpr uint8_t bodyRegisters = 0xC; // body writes only V0-VB
+
+	struct generatorRng
+	{
+		std::mt19937 engine;
+
+		uint32_t below(uint32_t n) { return engine() % n; }
+		bool chance(double p) { return static_cast<double>(engine() >> 8) * (1.0 / 16777216.0) < p; }
+		uint8_t reg() { return static_cast<uint8_t>(below(bodyRegisters)); }
+		uint8_t anyReg() { return static_cast<uint8_t>(below(16)); }
+		uint8_t byte() { return static_cast<uint8_t>(below(256)); }
+	};
+
+	enum fixupKind
+	{
+		FIX_NONE = 0,
+		FIX_SLOT,	  // 1nnn to the first word of a body slot
+		FIX_LEAF,	  // 2nnn to a leaf subroutine
+		FIX_SELF_MOD  // Annn at the immediate byte of a 7xkk word
+	};
+
+	struct word
+	{
+		uint16_t value;
+		fixupKind fixup = FIX_NONE;
+		int target = 0;
+	};
+
+	class program
+	{
+	public:
+		std::vector<word> words;
+
+		int here() const { return static_cast<int>(words.size()); }
+		static uint16_t address(int index) { return static_cast<uint16_t>(machine::entryPoint + 2 * index); }
+		void emit(uint16_t value, fixupKind fixup = FIX_NONE, int target = 0) { words.push_back({ value, fixup, target }); }
+	};
+
+	void emitAlu(program& p, generatorRng& rng)
+	{
+		const uint8_t x = rng.reg();
+		switch (rng.below(16))
+		{
+			case 0:
+			case 1:
+				p.emit(static_cast<uint16_t>(0x6000u | x << 8 | rng.byte()));
+				break;
+			case 2:
+			case 3:
+			case 4:
+				p.emit(static_cast<uint16_t>(0x7000u | x << 8 | rng.byte()));
+				break;
+			case 5:
+				// Timers stay cheap and deterministic: delay/sound set, delay read
+				p.emit(static_cast<uint16_t>(0xF000u | x << 8 | (rng.below(2) ? 0x15u : 0x07u)));
+				break;
+			default:
+			{
+				static constexpr uint8_t aluOps[] = { 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0xE };
+				// One draw per statement: argument evaluation order would differ between compilers
+				const uint8_t y = rng.anyReg();
+				const uint8_t op = aluOps[rng.below(sizeof(aluOps))];
+				p.emit(static_cast<uint16_t>(0x8000u | x << 8 | y << 4 | op));
+				break;
+			}
+		}
+	}
+
+	void emitDraw(program& p, generatorRng& rng)
+	{
+		const uint32_t kind = rng.below(16);
+		if (kind == 0)
+		{
+			p.emit(0x00E0);
+			return;
+		}
+		uint8_t height;
+		if (kind < 6)
+		{
+			// Font glyph of a register's low nibble
+			p.emit(static_cast<uint16_t>(0xF029u | rng.anyReg() << 8));
+			height = static_cast<uint8_t>(1 + rng.below(5));
+		}
+		else
+		{
+			// Any bytes make a sprite; read them from the start of the program
+			p.emit(static_cast<uint16_t>(0xA000u | (machine::entryPoint + rng.below(256))));
+			height = static_cast<uint8_t>(1 + rng.below(15));
+		}
+		const uint8_t x = rng.anyReg();
+		const uint8_t y = rng.anyReg();
+		p.emit(static_cast<uint16_t>(0xD000u | x << 8 | y << 4 | height));
+	}
+
+	void emitMemory(program& p, generatorRng& rng)
+	{
+		// I is reloaded first, so even after Fx1E (+255 at most) every access stays in 0xE00-0xFFF
+		p.emit(static_cast<uint16_t>(0xA000u | (scratchBase + rng.below(0xF0))));
+		switch (rng.below(4))
+		{
+			case 0:
+				p.emit(static_cast<uint16_t>(0xF033u | rng.anyReg() << 8));
+				break;
+			case 1:
+				p.emit(static_cast<uint16_t>(0xF055u | rng.anyReg() << 8));
+				break;
+			case 2:
+				p.emit(static_cast<uint16_t>(0xF065u | rng.reg() << 8));
+				break;
+			default:
+				p.emit(static_cast<uint16_t>(0xF01Eu | rng.anyReg() << 8));
+				p.emit(static_cast<uint16_t>(0xF055u | rng.reg() << 8));
+				break;
+		}
+	}
+
+	void emitBranch(program& p, generatorRng& rng, int slot, int slotCount)
+	{
+		if (rng.below(3) == 0)
+		{
+			// Forward jump over up to 8 slots; slotCount is the loop tail
+			const int target = std::min(slotCount, slot + 1 + static_cast<int>(rng.below(8)));
+			p.emit(0x1000, FIX_SLOT, target);
+			return;
+		}
+		const uint8_t x = rng.anyReg();
+		const uint8_t y = rng.anyReg();
+		switch (rng.below(6))
+		{
+			case 0:
+				p.emit(static_cast<uint16_t>(0x3000u | x << 8 | rng.byte()));
+				break;
+			case 1:
+				p.emit(static_cast<uint16_t>(0x4000u | x << 8 | rng.byte()));
+				break;
+			case 2:
+				p.emit(static_cast<uint16_t>(0x5000u | x << 8 | y << 4));
+				break;
+			case 3:
+				p.emit(static_cast<uint16_t>(0x9000u | x << 8 | y << 4));
+				break;
+			case 4:
+				p.emit(static_cast<uint16_t>(0xE09Eu | x << 8));
+				break;
+			default:
+				p.emit(static_cast<uint16_t>(0xE0A1u | x << 8));
+				break;
+		}
+	}
+
+	// 70% the requested category, the rest spread over all four
+	workloadMix pickCategory(workloadMix mix, generatorRng& rng)
+	{
+		if (rng.below(10) < 7)
+			return mix;
+		return static_cast<workloadMix>(rng.below(MIX_COUNT));
+	}
+}
+
+const char* workloadMixName(workloadMix mix)
+{
+	switch (mix)
+	{
+		case MIX_ALU:
+			return "alu";
+		case MIX_DRAW:
+			return "draw";
+		case MIX_MEMORY:
+			return "memory";
+		case MIX_CALL:
+			return "call";
+		case MIX_ALL:
+			return "all";
+	}
+	return "unknown";
+}
+
+bool parseWorkloadMix(const char* name, workloadMix& mix)
+{
+	static constexpr workloadMix mixes[] = { MIX_ALU, MIX_DRAW, MIX_MEMORY, MIX_CALL, MIX_ALL };
+	for (workloadMix candidate : mixes)
+	{
+		if (strcmp(name, workloadMixName(candidate)) == 0)
+		{
+			mix = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+std::vector<uint8_t> generateRom(const romGenOptions& options)
+{
+	generatorRng rng{ std::mt19937(options.seed) };
+	const int slotCount = std::clamp(options.instructions, 1, maxInstructions);
+	const int iterations = std::clamp(options.iterations, 1, 255);
+	const workloadMix mix = options.mix < MIX_COUNT ? options.mix : MIX_ALU;
+
+	program p;
+	p.emit(static_cast<uint16_t>(0x6000u | counterRegister << 8));
+	for (uint8_t r = 0; r < bodyRegisters; ++r)
+	{
+		p.emit(static_cast<uint16_t>(0x6000u | r << 8 | rng.byte()));
+	}
+
+	std::vector<int> slotStart(static_cast<std::size_t>(slotCount) + 1);
+	std::vector<int> immediates; // 7xkk words that make up a slot on their own
+	bool forceSingle = false;	 // the previous slot was a skip
+	for (int slot = 0; slot < slotCount; ++slot)
+	{
+		slotStart[static_cast<std::size_t>(slot)] = p.here();
+		if (forceSingle)
+		{
+			// A skip jumps exactly one word, so never land it inside a multi-word slot
+			emitAlu(p, rng);
+			forceSingle = false;
+		}
+		else if (slot + 1 < slotCount && rng.chance(options.branchDensity))
+		{
+			emitBranch(p, rng, slot, slotCount);
+			forceSingle = (p.words.back().value & 0xF000u) != 0x1000u;
+		}
+		else if (rng.chance(options.selfModifyRate))
+		{
+			p.emit(static_cast<uint16_t>(0x6000u | rng.byte()));
+			p.emit(0xA000, FIX_SELF_MOD);
+			p.emit(0xF055);
+		}
+		else
+		{
+			switch (pickCategory(mix, rng))
+			{
+				case MIX_DRAW:
+					emitDraw(p, rng);
+					break;
+				case MIX_MEMORY:
+					emitMemory(p, rng);
+					break;
+				case MIX_CALL:
+					p.emit(0x2000, FIX_LEAF, static_cast<int>(rng.below(leafCount)));
+					break;
+				default:
+					emitAlu(p, rng);
+					break;
+			}
+		}
+		if (p.here() - slotStart[static_cast<std::size_t>(slot)] == 1 && (p.words.back().value & 0xF000u) == 0x7000u)
+		{
+			immediates.push_back(p.here() - 1);
+		}
+	}
+
+	// Loop tail, then the halt
+	slotStart[static_cast<std::size_t>(slotCount)] = p.here();
+	p.emit(static_cast<uint16_t>(0x7001u | counterRegister << 8));
+	p.emit(static_cast<uint16_t>(0x3000u | counterRegister << 8 | iterations));
+	p.emit(static_cast<uint16_t>(0x1000u | program::address(slotStart[0])));
+	p.emit(static_cast<uint16_t>(0x1000u | program::address(p.here())));
+
+	// Leaves: a few ALU ops, maybe a call further down the DAG, then return
+	std::vector<int> leafStart(leafCount);
+	for (int leaf = 0; leaf < leafCount; ++leaf)
+	{
+		leafStart[static_cast<std::size_t>(leaf)] = p.here();
+		const int length = 2 + static_cast<int>(rng.below(5));
+		for (int i = 0; i < length; ++i)
+		{
+			emitAlu(p, rng);
+		}
+		if (leaf + 1 < leafCount && rng.below(2))
+		{
+			p.emit(0x2000, FIX_LEAF, leaf + 1 + static_cast<int>(rng.below(static_cast<uint32_t>(leafCount - leaf - 1))));
+		}
+		p.emit(0x00EE);
+	}
+
+	std::vector<uint8_t> bytes;
+	bytes.reserve(p.words.size() * 2);
+	for (const word& w : p.words)
+	{
+		uint16_t value = w.value;
+		switch (w.fixup)
+		{
+			case FIX_SLOT:
+				value |= program::address(slotStart[static_cast<std::size_t>(w.target)]);
+				break;
+			case FIX_LEAF:
+				value |= program::address(leafStart[static_cast<std::size_t>(w.target)]);
+				break;
+			case FIX_SELF_MOD:
+				// Without a 7xkk to rewrite, the store lands in scratch memory instead
+				value |= immediates.empty() ? scratchBase
+											: static_cast<uint16_t>(program::address(immediates[rng.below(static_cast<uint32_t>(immediates.size()))]) + 1);
+				break;
+			default:
+				break;
+		}
+		bytes.push_back(static_cast<uint8_t>(value >> 8));
+		bytes.push_back(static_cast<uint8_t>(value));
+	}
+	if (bytes.size() > maxRomSize)
+	{
+		bytes.resize(maxRomSize); // unreachable with maxInstructions; keeps the scratch area out of the image
+	}
+	return bytes;
+}
+
+static bool writeFile(const fs::path& path, const uint8_t* data, std::size_t size)
+{
+	FILE* out = fopen(path.string().c_str(), "wb");
+	if (!out)
+	{
+		LOG_ERROR("Failed to open %s", path.string().c_str());
+		return false;
+	}
+	const bool ok = fwrite(data, 1, size, out) == size;
+	fclose(out);
+	return ok;
+}
+
+int runGenerate(const generateOptions& options)
+{
+	if (options.outputDir.empty() || options.count <= 0)
+	{
+		LOG_ERROR("--generate needs an output directory and a positive --count");
+		return 1;
+	}
+
+	const fs::path dir(options.outputDir);
+	std::error_code ec;
+	fs::create_directories(dir / "fuzz", ec);
+	if (ec)
+	{
+		LOG_ERROR("Failed to create %s: %s", (dir / "fuzz").string().c_str(), ec.message().c_str());
+		return 1;
+	}
+
+	FILE* manifest = fopen((dir / "manifest.txt").string().c_str(), "wb");
+	if (!manifest)
+	{
+		LOG_ERROR("Failed to open %s", (dir / "manifest.txt").string().c_str());
+		return 1;
+	}
+	fprintf(manifest, "# Generated workloads: <rom> <frames>\n");
+
+	std::size_t totalBytes = 0;
+	bool ok = true;
+	for (int i = 0; i < options.count && ok; ++i)
+	{
+		romGenOptions rom = options.rom;
+		rom.seed = options.rom.seed + static_cast<uint32_t>(i);
+		rom.mix = options.mix == MIX_ALL ? static_cast<workloadMix>(i % MIX_COUNT) : options.mix;
+		const std::vector<uint8_t> bytes = generateRom(rom);
+
+		char name[64];
+		snprintf(name, sizeof(name), "%s-%u", workloadMixName(rom.mix), rom.seed);
+		ok = writeFile(dir / (std::string(name) + ".ch8"), bytes.data(), bytes.size());
+
+		// Fuzz seed: a zero-length key stream, then the ROM
+		std::vector<uint8_t> seed(bytes.size() + 1, 0);
+		memcpy(seed.data() + 1, bytes.data(), bytes.size());
+		ok = ok && writeFile(dir / "fuzz" / name, seed.data(), seed.size());
+
+		fprintf(manifest, "%s.ch8 %d\n", name, options.frames);
+		totalBytes += bytes.size();
+	}
+	ok = ferror(manifest) == 0 && ok;
+	fclose(manifest);
+	if (!ok)
+	{
+		return 1;
+	}
+	LOG("Generated %d ROMs (%zu bytes) in %s", options.count, totalBytes, options.outputDir.c_str());
+	return 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum workloadMix
+{
+	MIX_ALU = 0,	// 6xkk/7xkk/8xy*
+	MIX_DRAW,		// Annn + Dxyn, occasional 00E0/Fx29
+	MIX_MEMORY,		// Fx33/Fx55/Fx65/Fx1E over a scratch area
+	MIX_CALL,		// 2nnn into a DAG of leaf subroutines
+	MIX_COUNT,
+	MIX_ALL = MIX_COUNT // generateCorpus cycles through every mix
+};
+
+struct romGenOptions
+{
+	workloadMix mix = MIX_ALU;
+	uint32_t seed = 1;
+	int instructions = 256;		// loop body length
+	int iterations = 200;		// body repetitions before the program halts, 1..255
+	double branchDensity = 0.1; // share of body slots that are skips or forward jumps
+	double selfModifyRate = 0.0; // share of body slots that rewrite a 7xkk immediate in the body
+};
+
+const char* workloadMixName(workloadMix mix);
+bool parseWorkloadMix(const char* name, workloadMix& mix);
+
+// Emits a program that runs `iterations` passes over a generated body and then parks
+// on a self-jump (1nnn to itself), the usual CHIP-8 "halt". Every branch is a skip or
+// a forward jump inside the body, calls go down a DAG of leaf subroutines, memory ops
+// stay inside a scratch area and self-modification only rewrites 7xkk immediates, so
+// any seed gives a valid program that terminates. Cxkk and Fx0A are never emitted,
+// but branches may skip on Ex9E/ExA1, so a run depends only on the seed and the key
+// state. Uses its own mt19937 and plain modulo draws so a seed produces the same bytes
+// on every platform.
+std::vector<uint8_t> generateRom(const romGenOptions& options);
+
+struct generateOptions
+{
+	std::string outputDir;
+	int count = 16;
+	int frames = 600; // written into the batch manifest
+	romGenOptions rom;
+	workloadMix mix = MIX_ALL;
+};
+
+// Entry point for --generate: writes <dir>/<mix>-<seed>.ch8 for `count` seeds, a batch
+// manifest (<dir>/manifest.txt) and libFuzzer seeds (<dir>/fuzz/, with the key-stream
+// length byte the fuzz target expects). Returns a process exit code.
+int runGenerate(const generateOptions& options);
@@ -4,9 +4,11 @@
 #include "raygui.h"
 #include "chip8.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cmath>
 #include <string>
 #include <sstream>
-#include <nfd.h>
 
 gui::gui()
 {
@@ -17,13 +19,27 @@ void gui::run(chip8* instance)
 	ClearBackground(BLACK);
 	if (instance->state == MENU)
 	{
+		libraryAvailable = instance->library != nullptr;
+		if (showLibrary && libraryAvailable)
+		{
+			drawLibrary(instance);
+			return;
+		}
 
-		mainMenuResult menuResult = drawMainMenu(showFileDialog, instance->filepath);
+		mainMenuResult menuResult = drawMainMenu(instance->romDialog.isOpen(), instance->sessionResumable);
 
-		if (menuResult == MENU_LOAD && !instance->filepath.empty())
+		// The choice arrives later through chip8::run, which opens the ROM
+		if (menuResult == MENU_LOAD)
+		{
+			instance->romDialog.open();
+		}
+		if (menuResult == MENU_LIBRARY)
 		{
-			instance->loadRom(instance->filepath);
-			instance->state = chip8States::RUNNING; // Set state to RUNNING after loading ROM
+			showLibrary = true;
+		}
+		if (menuResult == MENU_RESUME && !instance->resumeSession())
+		{
+			instance->sessionResumable = false;
 		}
 		if (menuResult == MENU_QUIT)
 		{
@@ -32,7 +48,7 @@ void gui::run(chip8* instance)
 	}
 }
 
-mainMenuResult gui::drawMainMenu(bool& showFileDialog, std::string& selectedFile)
+mainMenuResult gui::drawMainMenu(bool fileDialogOpen, bool sessionResumable)
 {
 
 	ClearBackground(RAYWHITE);
@@ -43,64 +59,42 @@ mainMenuResult gui::drawMainMenu(bool& showFileDialog, std::string& selectedFile
 	// Center menu on screen
 	int screenWidth = GetScreenWidth();
 	int screenHeight = GetScreenHeight();
-	Rectangle menuBox = { screenWidth / 2.0f - 100, screenHeight / 2.0f - 100, 240, 180 };
+	Rectangle menuBox = { screenWidth / 2.0f - 100, screenHeight / 2.0f - 100, 240, sessionResumable ? 220.0f : 180.0f };
 
 	GuiPanel(menuBox, "Main Menu");
 
 	float btnY = menuBox.y + 40;
+	if (sessionResumable)
+	{
+		if (GuiButton({ menuBox.x + 60, btnY, 120, 30 }, "Resume"))
+		{
+			result = MENU_RESUME;
+		}
+		btnY += 40;
+	}
+	if (fileDialogOpen)
+	{
+		GuiDisable();
+	}
 	if (GuiButton({ menuBox.x + 60, btnY, 120, 30 }, "Load ROM"))
 	{
-		showFileDialog = true;
 		result = MENU_LOAD;
-		ClearBackground(BLACK);
 	}
+	GuiEnable();
 	btnY += 40;
-	if (GuiButton({ menuBox.x + 60, btnY, 120, 30 }, "Quit"))
+	if (!libraryAvailable)
 	{
-		result = MENU_QUIT;
+		GuiDisable();
 	}
-
-	// Use filedialog.h for file selection
-	static char filePath[1024] = { 0 };
-	static bool fileDialogOpen = false;
-
-	if (showFileDialog)
+	if (GuiButton({ menuBox.x + 60, btnY, 120, 30 }, "ROM Library"))
 	{
-		fileDialogOpen = true;
-		showFileDialog = false; // Only open once per button press
+		result = MENU_LIBRARY;
 	}
-
-	if (fileDialogOpen)
+	GuiEnable();
+	btnY += 40;
+	if (GuiButton({ menuBox.x + 60, btnY, 120, 30 }, "Quit"))
 	{
-
-		NFD_Init();
-
-		nfdu8char_t* outPath;
-		nfdu8filteritem_t filters[1] = { { "Roms", "ch8" } };
-		nfdopendialogu8args_t args = { 0 };
-		args.filterList = filters;
-		args.filterCount = 1;
-		nfdresult_t result = NFD_OpenDialogU8_With(&outPath, &args);
-		if (result == NFD_OKAY)
-		{
-			const char* path = outPath;
-			LOG("Rom Path: %s", path);
-			selectedFile = outPath; // Store the selected file path
-			NFD_FreePathU8(outPath);
-		}
-		else if (result == NFD_CANCEL)
-		{
-			LOG("User pressed cancel.");
-		}
-		else
-		{
-			LOG_ERROR("gui::drawMainMenu Error: &s", NFD_GetError());
-		}
-
-		showFileDialog = false;
-		fileDialogOpen = false;
-
-		NFD_Quit();
+		result = MENU_QUIT;
 	}
 
 	return result;
@@ -128,6 +122,7 @@ void gui::drawChip8DebugWindow(const chip8& cpu, bool* showWindow)
 	GuiLabel({ x + 200, y, 180, 20 }, TextFormat("Delay Timer: %d", cpu.delayTimer));
 	y += 25;
 	GuiLabel({ x, y, 180, 20 }, TextFormat("Sound Timer: %d", cpu.soundTimer));
+	GuiLabel({ x + 200, y, 180, 20 }, TextFormat("Faults: %llu", static_cast<unsigned long long>(cpu.faults.totalAll())));
 
 	y += 30;
 	GuiLabel({ x, y, 360, 20 }, "V Registers:");
@@ -196,9 +191,9 @@ void gui::drawChip8DebugWindow(const chip8& cpu, bool* showWindow)
 		float innerY = panelBounds.y + scroll.y;
 
 		// Optionally compute a visible range to avoid drawing everything
-		int firstVisible = (int)std::floorf((-scroll.y) / rowHeight) - 1;
+		int firstVisible = (int)std::floor((-scroll.y) / rowHeight) - 1;
 		firstVisible = std::max(0, firstVisible);
-		int lastVisible = (int)std::ceilf((-scroll.y + panelBounds.height) / rowHeight) + 1;
+		int lastVisible = (int)std::ceil((-scroll.y + panelBounds.height) / rowHeight) + 1;
 		lastVisible = std::min(count, lastVisible);
 
 		for (int i = firstVisible; i < lastVisible; ++i)
@@ -210,6 +205,73 @@ void gui::drawChip8DebugWindow(const chip8& cpu, bool* showWindow)
 	EndScissorMode();
 }
 
+void gui::drawPerfHud(const chip8& cpu, bool* showWindow)
+{
+	if (!showWindow || !(*showWindow))
+		return;
+
+	const perfMetrics& metrics = cpu.metrics;
+	Rectangle hudBox = { GetScreenWidth() - 300.0f, 0, 300, 330 };
+
+	GuiPanel(hudBox, "Performance");
+
+	float y = hudBox.y + 30;
+	float x = hudBox.x + 15;
+
+	const int targetIps = cpu.getInstructionsPerSecond();
+	const double ips = metrics.instructionsPerSecond();
+	GuiLabel({ x, y, 270, 20 }, TextFormat("IPS: %.0f / %d (%.0f%%)", ips, targetIps, targetIps ? 100.0 * ips / targetIps : 0.0));
+	y += 20;
+	GuiLabel({ x, y, 270, 20 }, TextFormat("Frame: %.2f ms (avg %.2f ms)", metrics.lastFrameMs(), metrics.averageFrameMs()));
+	y += 20;
+	GuiLabel({ x, y, 270, 20 }, TextFormat("Emu %.1f%%  Render %.1f%%  GUI %.1f%%  Present %.1f%%",
+		metrics.stagePercent(STAGE_EMULATION), metrics.stagePercent(STAGE_RENDER),
+		metrics.stagePercent(STAGE_GUI), metrics.stagePercent(STAGE_PRESENT)));
+	y += 20;
+	GuiLabel({ x, y, 270, 20 }, TextFormat("Draw calls: %d", metrics.drawCallsLastFrame()));
+	y += 20;
+	const size_t historyBytes = cpu.opcode_history.capacity() * sizeof(uint16_t);
+	GuiLabel({ x, y, 270, 20 }, TextFormat("Trace buffers: %.1f KB (history %.1f KB)",
+		(historyBytes + trace::bufferBytes()) / 1024.0, historyBytes / 1024.0));
+	y += 28;
+
+	// Frame time graph, oldest frame on the left; the line marks the 16.6 ms budget
+	const float graphHeight = 60.0f;
+	const float graphMaxMs = 33.3f;
+	const float barWidth = 270.0f / perfMetrics::historyFrames;
+	DrawRectangle((int)x, (int)y, 270, (int)graphHeight, Fade(BLACK, 0.6f));
+	for (int i = 0; i < perfMetrics::historyFrames; ++i)
+	{
+		const float ms = std::min(metrics.frameMsAt(i), graphMaxMs);
+		const float h = graphHeight * ms / graphMaxMs;
+		DrawRectangle((int)(x + i * barWidth), (int)(y + graphHeight - h), std::max(1, (int)barWidth), (int)h, ms > 17.0f ? RED : GREEN);
+	}
+	const float budgetY = y + graphHeight - graphHeight * 16.6f / graphMaxMs;
+	DrawLine((int)x, (int)budgetY, (int)x + 270, (int)budgetY, YELLOW);
+	y += graphHeight + 8;
+
+	// Rolling histogram of the same frames
+	int maxCount = 1;
+	for (int b = 0; b < perfMetrics::histogramBuckets; ++b)
+	{
+		maxCount = std::max(maxCount, metrics.histogramCount(b));
+	}
+	const float bucketWidth = 270.0f / perfMetrics::histogramBuckets;
+	const float histHeight = 60.0f;
+	for (int b = 0; b < perfMetrics::histogramBuckets; ++b)
+	{
+		const float h = histHeight * metrics.histogramCount(b) / maxCount;
+		DrawRectangle((int)(x + b * bucketWidth + 1), (int)(y + histHeight - h), (int)bucketWidth - 2, (int)h, SKYBLUE);
+	}
+	y += histHeight + 2;
+	for (int b = 0; b < perfMetrics::histogramBuckets; ++b)
+	{
+		const bool last = b == perfMetrics::histogramBuckets - 1;
+		GuiLabel({ x + b * bucketWidth, y, bucketWidth, 20 },
+			TextFormat(last ? "%.0f+" : "<%.0f", (b + (last ? 0 : 1)) * perfMetrics::histogramBucketMs));
+	}
+}
+
 void gui::fileDialogBox(bool& showFileDialog, std::string& selectedFile)
 {
 	int screenWidth = GetScreenWidth();
@@ -234,23 +296,32 @@ void gui::drawpauseMenu(chip8* instance)
 	// Centered pause panel
 	int sw = GetScreenWidth();
 	int sh = GetScreenHeight();
-	Rectangle box = { sw / 2.0f - 120, sh / 2.0f - 90, 240, 160 };
+	Rectangle box = { sw / 2.0f - 120, sh / 2.0f - 110, 240, 200 };
 	GuiPanel(box, "Paused");
 
-	static bool showFileDialog = false;
-	static bool fileDialogOpen = false;
-
 	float btnY = box.y + 40;
-	// Load ROM button
+	// Load ROM button; the paused screen keeps drawing while the dialog is up
+	if (instance->romDialog.isOpen())
+	{
+		GuiDisable();
+	}
 	if (GuiButton({ box.x + 60, btnY, 120, 30 }, "Load ROM"))
 	{
-		showFileDialog = true;
+		instance->romDialog.open();
+	}
+	GuiEnable();
+	btnY += 40;
+	// restart button: back to the ROM's load-time state, no file access
+	if (GuiButton({ box.x + 60, btnY, 120, 30 }, "Restart ROM"))
+	{
+		instance->resetChip8();
+		instance->state = chip8States::RUNNING;
 	}
 	btnY += 40;
 	// return to menu button
 	if (GuiButton({ box.x + 60, btnY, 120, 30 }, "Return To Menu"))
 	{
-		instance->resetChip8();
+		instance->reset();
 		instance->state = chip8States::MENU;
 	}
 	btnY += 40;
@@ -259,37 +330,163 @@ void gui::drawpauseMenu(chip8* instance)
 	{
 		instance->state = chip8States::QUIT;
 	}
+}
+
+void gui::drawLibrary(chip8* instance)
+{
+	ClearBackground(RAYWHITE);
+	const romLibrary& library = *instance->library;
+	const std::shared_ptr<const std::vector<romEntry>> entries = library.entries();
+
+	Rectangle box = { 10, 10, GetScreenWidth() - 20.0f, GetScreenHeight() - 20.0f };
+	GuiPanel(box, library.scanning() ? TextFormat("ROM Library - %zu ROMs (scanning, %zu files checked)", entries->size(), library.filesScanned())
+									 : TextFormat("ROM Library - %zu ROMs", entries->size()));
 
-	// Handle file dialog
-	if (showFileDialog)
+	GuiLabel({ box.x + 10, box.y + 34, 50, 24 }, "Filter:");
+	if (GuiTextBox({ box.x + 60, box.y + 34, 300, 24 }, libraryFilter, sizeof(libraryFilter) - 1, libraryFilterEdit))
 	{
-		fileDialogOpen = true;
-		showFileDialog = false;
+		libraryFilterEdit = !libraryFilterEdit;
+	}
+	if (GuiButton({ box.x + box.width - 90, box.y + 34, 80, 24 }, "Back"))
+	{
+		showLibrary = false;
+		releaseThumbnailsAfterFrame = true;
+		return;
 	}
 
-	if (fileDialogOpen)
+	if (entries != libraryShown || libraryFilterApplied != libraryFilter)
 	{
-		NFD_Init();
-		nfdu8char_t* outPath = nullptr;
-		nfdu8filteritem_t filters[1] = { { "Roms", "ch8" } };
-		nfdopendialogu8args_t args = { 0 };
-		args.filterList = filters;
-		args.filterCount = 1;
-		nfdresult_t r = NFD_OpenDialogU8_With(&outPath, &args);
-		if (r == NFD_OKAY)
+		std::string needle = libraryFilter;
+		std::transform(needle.begin(), needle.end(), needle.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+		libraryRows.clear();
+		for (std::size_t i = 0; i < entries->size(); ++i)
 		{
-			instance->filepath = outPath;
-			NFD_FreePathU8(outPath);
-			// Reset, load, and resume
-			instance->resetChip8();
-			instance->loadRom(instance->filepath);
-			instance->state = chip8States::RUNNING;
+			if (!needle.empty())
+			{
+				std::string haystack = (*entries)[i].displayName() + '\n' + (*entries)[i].path;
+				std::transform(haystack.begin(), haystack.end(), haystack.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+				if (haystack.find(needle) == std::string::npos)
+					continue;
+			}
+			libraryRows.push_back(i);
 		}
-		else if (r == NFD_ERROR)
+		libraryShown = entries;
+		libraryFilterApplied = libraryFilter;
+	}
+
+	// Virtualized list: only the rows inside the scroll view are drawn
+	const float rowHeight = 40.0f;
+	const float textX = 76.0f; // right of the 64x32 preview
+	Rectangle panelBounds = { box.x + 10, box.y + 66, box.width - 20, box.height - 76 };
+	Rectangle content = { 0, 0, panelBounds.width - 14, libraryRows.size() * rowHeight };
+	Rectangle view = { 0 };
+	GuiScrollPanel(panelBounds, nullptr, content, &libraryScroll, &view);
+
+	const Vector2 mouse = GetMousePosition();
+	std::size_t chosen = libraryRows.size();
+	BeginScissorMode((int)view.x, (int)view.y, (int)view.width, (int)view.height);
+	{
+		const int firstVisible = std::max(0, (int)std::floor(-libraryScroll.y / rowHeight));
+		const int lastVisible = std::min((int)libraryRows.size(), (int)std::ceil((-libraryScroll.y + view.height) / rowHeight) + 1);
+		thumbnailCache* thumbnails = instance->libraryThumbnails();
+		// Rather than track use, drop them all when the visible rows might not fit. Done
+		// before any row is drawn: nothing in this frame's batch uses them yet.
+		if (thumbnailTextures.size() + static_cast<std::size_t>(std::max(0, lastVisible - firstVisible)) > maxThumbnailTextures)
 		{
-			LOG_ERROR("PauseMenu: %s", NFD_GetError());
+			releaseThumbnails();
 		}
-		fileDialogOpen = false;
-		NFD_Quit();
+		if (thumbnails)
+		{
+			// Latest request is generated first: queue the next page as a prefetch, then the
+			// visible rows bottom-up so the top of the view fills in first
+			uint8_t unused[thumbnailCache::pixelBytes];
+			const int prefetchEnd = std::min((int)libraryRows.size(), lastVisible + (lastVisible - firstVisible));
+			for (int i = prefetchEnd - 1; i >= firstVisible; --i)
+			{
+				const romEntry& entry = (*entries)[libraryRows[i]];
+				if (!thumbnailTextures.count(entry.hash))
+				{
+					thumbnails->request(entry, unused);
+				}
+			}
+		}
+		for (int i = firstVisible; i < lastVisible; ++i)
+		{
+			const romEntry& entry = (*entries)[libraryRows[i]];
+			const Rectangle row = { panelBounds.x + libraryScroll.x, panelBounds.y + libraryScroll.y + i * rowHeight, content.width, rowHeight };
+			const bool hovered = CheckCollisionPointRec(mouse, row) && CheckCollisionPointRec(mouse, view);
+			if (hovered)
+			{
+				DrawRectangleRec(row, Fade(SKYBLUE, 0.5f));
+				if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+				{
+					chosen = static_cast<std::size_t>(i);
+				}
+			}
+			const Rectangle preview = { row.x + 6, row.y + 4, 64, 32 };
+			const Texture2D* texture = thumbnails ? thumbnailTexture(*thumbnails, entry) : nullptr;
+			if (texture)
+			{
+				DrawTexture(*texture, (int)preview.x, (int)preview.y, WHITE);
+			}
+			else
+			{
+				DrawRectangleLinesEx(preview, 1, LIGHTGRAY);
+			}
+			GuiLabel({ row.x + textX, row.y, row.width * 0.6f - textX, rowHeight }, entry.displayName().c_str());
+			GuiLabel({ row.x + row.width * 0.6f, row.y, row.width * 0.25f, rowHeight }, entry.known ? entry.metadata.platform.c_str() : "-");
+			if (entry.known && entry.metadata.tickrate > 0)
+			{
+				GuiLabel({ row.x + row.width * 0.85f, row.y, row.width * 0.15f, rowHeight }, TextFormat("%d/frame", entry.metadata.tickrate));
+			}
+		}
+	}
+	EndScissorMode();
+
+	if (chosen < libraryRows.size())
+	{
+		const romEntry entry = (*entries)[libraryRows[chosen]];
+		if (instance->openLibraryEntry(entry))
+		{
+			instance->state = chip8States::RUNNING;
+			showLibrary = false;
+			releaseThumbnailsAfterFrame = true;
+		}
+	}
+}
+
+const Texture2D* gui::thumbnailTexture(thumbnailCache& thumbnails, const romEntry& entry)
+{
+	const auto known = thumbnailTextures.find(entry.hash);
+	if (known != thumbnailTextures.end())
+		return &known->second;
+
+	uint8_t packed[thumbnailCache::pixelBytes];
+	if (!thumbnails.request(entry, packed))
+		return nullptr;
+	uint8_t pixels[64 * 32];
+	for (int i = 0; i < 64 * 32; ++i)
+	{
+		pixels[i] = (packed[i / 8] >> (7 - i % 8)) & 1 ? 255 : 0;
+	}
+	Image image = { pixels, 64, 32, 1, PIXELFORMAT_UNCOMPRESSED_GRAYSCALE };
+	return &thumbnailTextures.emplace(entry.hash, LoadTextureFromImage(image)).first->second;
+}
+
+void gui::releaseThumbnails()
+{
+	for (const auto& [hash, texture] : thumbnailTextures)
+	{
+		UnloadTexture(texture);
+	}
+	thumbnailTextures.clear();
+}
+
+void gui::afterFrame()
+{
+	if (releaseThumbnailsAfterFrame)
+	{
+		releaseThumbnails();
+		releaseThumbnailsAfterFrame = false;
 	}
 }
@@ -1,14 +1,23 @@
 #pragma once
 #include "raygui.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 class chip8;
+class thumbnailCache;
+struct romEntry;
 // Simple main menu state
 enum mainMenuResult
 {
 	MENU_NONE,
 	MENU_LOAD,
+	MENU_LIBRARY,
+	MENU_RESUME,
 	MENU_SETTINGS,
 	MENU_ABOUT,
 	MENU_QUIT
@@ -19,12 +28,35 @@ class gui
 public:
 	gui();
 	void run(chip8* instance);
-	mainMenuResult drawMainMenu(bool& showFileDialog, std::string& selectedFile);
+	mainMenuResult drawMainMenu(bool fileDialogOpen, bool sessionResumable);
 	void drawChip8DebugWindow(const chip8& cpu, bool* showWindow);
+	void drawPerfHud(const chip8& cpu, bool* showWindow);
 	void fileDialogBox(bool& showFileDialog, std::string& selectedFile);
 	void drawpauseMenu(chip8* instance);
+	void drawLibrary(chip8* instance);
+	// Frees the library's preview textures; must run before the window closes
+	void releaseThumbnails();
+	// Call after EndDrawing: frees preview textures the closing browser still drew from
+	void afterFrame();
 
 private:
-	bool showFileDialog = false; // Toggle for file dialog
+	const Texture2D* thumbnailTexture(thumbnailCache& thumbnails, const romEntry& entry);
+
 	bool menuDrawn = false;
+
+	// ROM library browser
+	bool libraryAvailable = false;
+	bool showLibrary = false;
+	Vector2 libraryScroll = { 0, 0 };
+	char libraryFilter[64] = { 0 };
+	bool libraryFilterEdit = false;
+	// Rows matching the filter, rebuilt only when the scan publishes or the filter changes
+	std::shared_ptr<const std::vector<romEntry>> libraryShown;
+	std::string libraryFilterApplied;
+	std::vector<std::size_t> libraryRows;
+	// Preview textures by ROM hash, uploaded once each thumbnail is ready
+	std::unordered_map<uint64_t, Texture2D> thumbnailTextures;
+	static constexpr std::size_t maxThumbnailTextures = 512;
+	// Unloading mid-frame would free textures the frame's draw batch still uses
+	bool releaseThumbnailsAfterFrame = false;
 };
\ No newline at end of file
@@ -0,0 +1,608 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "machine.h"
+
+//
+// Opcode semantics shared by every execution backend.
+//
+// executeOpcode works on anything that exposes the guest state under machine's
+// member names (memory, V, I, pc, stack, sp, timers, screen[x][y], draw_flag,
+// keypad, faults.raise, quirks) plus randomByte(). Stores to memory and the framebuffer go
+// through writeMemory(), togglePixel() and clearScreen() so the backend can track
+// them. machine uses it directly; the lockstep engine instantiates it on a per-lane
+// view of its struct-of-arrays state, so the scalar fallback is bit-identical to
+// the reference interpreter by construction.
+//
+
+namespace interpreter
+{
+	inline uint8_t getVxRegistry(const uint16_t opcode)
+	{
+		// And bitwise operation to extract the Vx register from the opcode then bit shifting right by 8 bits
+		return (opcode & 0x0F00u) >> 8u; // Extract Vx from opcode
+	}
+
+	inline uint8_t getVyRegistry(const uint16_t opcode)
+	{
+		// And bitwise operation to extract the Vy register from the opcode then bit shifting right by 4 bits
+		return (opcode & 0x00F0u) >> 4u; // Extract Vx from opcode
+	}
+
+	// Executes one already-fetched opcode; pc has already been advanced past it
+	template <typename Machine>
+	void executeOpcode(Machine& m, uint16_t opcode)
+	{
+		// LOG("Opcode: 0x%x", opcode);
+		//  Decode and execute the opcode
+		switch (opcode & 0xF000)
+		{
+			case 0x0000: // 0x00E0, 0x00EE
+				switch (opcode & 0x00FF)
+				{
+					case 0x00E0:
+					{
+						// Clears the screen.
+						m.clearScreen();
+						m.draw_flag = true;
+						break;
+					}
+					case 0x00EE:
+					{
+						if (m.sp == 0) [[unlikely]]
+						{
+							m.faults.raise(FAULT_STACK_UNDERFLOW, m.pc - 2, opcode);
+						}
+						// Saturates at 0: an underflowing return reads stack[0] instead of stack[-1]
+						m.sp -= (m.sp != 0);
+						m.pc = m.stack[m.sp]; // Set program counter to the address at the top of the stack
+						break;
+					}
+					default:
+					{
+						/* SYS addr */
+						m.faults.raise(FAULT_UNKNOWN_OPCODE, m.pc - 2, opcode);
+						break;
+					}
+				}
+				break;
+			/* JP addr */
+			case 0x1000:
+			{
+				// gets the address from the opcode (the lowest 12 bits) and sets the program counter to that address. stack is not required for this operation.
+				uint16_t address = opcode & 0x0FFFu;
+				m.pc = address;
+				break;
+			}
+			/* CALL addr */
+			case 0x2000:
+			{
+				uint16_t address = opcode & 0x0FFFu;
+
+				if (m.sp >= machine::stackDepth) [[unlikely]]
+				{
+					m.faults.raise(FAULT_STACK_OVERFLOW, m.pc - 2, opcode);
+				}
+				// sp stays within [0, stackDepth]: a full stack overwrites its top slot instead of writing past it
+				const uint8_t full = m.sp >> 4u;
+				m.stack[m.sp - full] = m.pc;
+				m.sp += 1u - full;
+				m.pc = address;
+				break;
+			}
+			/* SE Vx, byte */
+			case 0x3000:
+			{
+				const uint8_t Vx = getVxRegistry(opcode);
+				uint8_t byte = opcode & 0x00FFu;
+
+				if (m.V[Vx] == byte)
+				{
+					m.pc += 2; // Skip the next instruction if Vx == byte
+				}
+
+				break;
+			}
+			/* SNE Vx, byte */
+			case 0x4000:
+			{
+				const uint8_t Vx = getVxRegistry(opcode);
+				uint8_t byte = opcode & 0x00FFu;
+
+				if (m.V[Vx] != byte)
+				{
+					m.pc += 2; // Skip the next instruction if Vx != byte
+				}
+				break;
+			}
+			/* SE Vx, Vy */
+			case 0x5000:
+			{
+				const uint8_t Vx = getVxRegistry(opcode);
+				const uint8_t Vy = getVyRegistry(opcode);
+
+				if (m.V[Vx] == m.V[Vy])
+				{
+					m.pc += 2; // Skip the next instruction if Vx == Vy
+				}
+				break;
+			}
+			/* LD Vx, byte */
+			case 0x6000:
+			{
+				const uint8_t Vx = getVxRegistry(opcode);
+				uint8_t byte = opcode & 0x00FFu;
+				m.V[Vx] = byte; // Load byte into Vx
+				break;
+			}
+			/* ADD Vx, byte */
+			case 0x7000:
+			{
+				const uint8_t Vx = getVxRegistry(opcode);
+				uint8_t byte = opcode & 0x00FFu;
+				m.V[Vx] += byte; // Add byte to Vx
+				break;
+			}
+			case 0x8000:
+				switch (opcode & 0x000F)
+				{
+					/* LD Vx, Vy */
+					case 0x0:
+					{
+						const uint8_t Vx = getVxRegistry(opcode);
+						const uint8_t Vy = getVyRegistry(opcode);
+						m.V[Vx] = m.V[Vy]; // Load value of Vy into Vx
+						break;
+					}
+					/* OR Vx, Vy */
+					case 0x1:
+					{
+						const uint8_t Vx = getVxRegistry(opcode);
+						const uint8_t Vy = getVyRegistry(opcode);
+						m.V[Vx] |= m.V[Vy]; // Bitwise OR Vx and Vy
+						if (m.quirks.logicResetsVf)
+						{
+							m.V[0xF] = 0;
+						}
+						break;
+					}
+					/* AND Vx, Vy */
+					case 0x2:
+					{
+						const uint8_t Vx = getVxRegistry(opcode);
+						const uint8_t Vy = getVyRegistry(opcode);
+						m.V[Vx] &= m.V[Vy]; // Bitwise AND Vx and Vy
+						if (m.quirks.logicResetsVf)
+						{
+							m.V[0xF] = 0;
+						}
+						break;
+					}
+					/* XOR Vx, Vy */
+					case 0x3:
+					{
+						const uint8_t Vx = getVxRegistry(opcode);
+						const uint8_t Vy = getVyRegistry(opcode);
+						m.V[Vx] ^= m.V[Vy]; // Bitwise XOR Vx and Vy
+						if (m.quirks.logicResetsVf)
+						{
+							m.V[0xF] = 0;
+						}
+						break;
+					}
+					/* ADD Vx, Vy */
+					case 0x4:
+					{
+						const uint8_t Vx = getVxRegistry(opcode);
+						const uint8_t Vy = getVyRegistry(opcode);
+						uint16_t sum = m.V[Vx] + m.V[Vy];
+						uint8_t carry = (sum > 0xFF) ? 1 : 0;
+
+						m.V[Vx] = static_cast<uint8_t>(sum & 0xFF); // Store the result in Vx, keeping it within 8 bits
+						m.V[0xF] = carry;							  // Set carry flag if overflow occurs
+						break;
+					}
+					/* SUB Vx, Vy */
+					case 0x5:
+					{
+						const uint8_t Vx = getVxRegistry(opcode);
+						const uint8_t Vy = getVyRegistry(opcode);
+						const uint8_t origX = m.V[Vx];
+						const uint8_t origY = m.V[Vy];
+						const uint8_t carry = (origY > origX) ? 0 : 1;
+						m.V[Vx] = origX - origY; // Subtract Vy from Vx#
+						m.V[0xF] = carry;		   // Set the carry flag if Vx > Vy
+
+						break;
+					}
+					/* SHR Vx */
+					case 0x6:
+					{
+						const uint8_t Vx = getVxRegistry(opcode);
+						const uint8_t origX = m.quirks.shiftUsesVy ? m.V[getVyRegistry(opcode)] : m.V[Vx];
+
+						const uint8_t carry = origX & 0x1u;
+						m.V[Vx] = origX >> 1; // Shift Vx right by 1 bit (division by 2)
+						m.V[0xF] = carry;		// Set the carry flag to the least significant bit
+
+						break;
+					}
+					/* SUBN Vx, Vy */
+					case 0x7:
+					{
+						const uint8_t Vx = getVxRegistry(opcode);
+						const uint8_t Vy = getVyRegistry(opcode);
+						const uint8_t carry = (m.V[Vx] > m.V[Vy]) ? 0 : 1;
+
+						m.V[Vx] = static_cast<uint8_t>(m.V[Vy] - m.V[Vx]); // Subtract Vx from Vy
+						m.V[0xF] = carry;								 // Set the carry flag if Vy > Vx
+						break;
+					}
+					/* SHL Vx */
+					case 0xE:
+					{
+						const uint8_t Vx = getVxRegistry(opcode);
+						const uint8_t origX = m.quirks.shiftUsesVy ? m.V[getVyRegistry(opcode)] : m.V[Vx];
+						const uint8_t carry = (origX & 0x80u) >> 7u;
+
+						m.V[Vx] = static_cast<uint8_t>(origX << 1); // Shift Vx left by 1 bit (multiplication by 2)
+						m.V[0xF] = carry; // Set the carry flag to the most significant bit
+						break;
+					}
+					default:
+						m.faults.raise(FAULT_UNKNOWN_OPCODE, m.pc - 2, opcode);
+						break;
+				}
+				break;
+			/* SNE Vx, Vy */
+			case 0x9000:
+			{
+				const uint8_t Vx = getVxRegistry(opcode);
+				const uint8_t Vy = getVyRegistry(opcode);
+				if (m.V[Vx] != m.V[Vy])
+				{
+					m.pc += 2; // Skip the next instruction if Vx != Vy
+				}
+				break;
+			}
+			/* LD I, addr */
+			case 0xA000:
+			{
+				const uint16_t address = opcode & 0x0FFFu;
+				m.I = address; // Load the address into the index register I
+				break;
+			}
+			/* JP V0, addr */
+			case 0xB000:
+			{
+				const uint16_t address = opcode & 0x0FFFu;
+				// Jump to the address plus V0, or plus Vx on CHIP-48 style interpreters
+				m.pc = address + m.V[m.quirks.jumpUsesVx ? getVxRegistry(opcode) : 0];
+				break;
+			}
+			/* RND Vx, byte */
+			case 0xC000:
+			{
+				const uint8_t Vx = getVxRegistry(opcode);
+				uint8_t byte = opcode & 0x00FFu;
+				m.V[Vx] = m.randomByte() & byte; // Generate a random byte and AND it with the byte from the opcode
+				break;
+			}
+			/* DRW Vx, Vy, nibble */
+			case 0xD000:
+			{
+				uint8_t Vx = getVxRegistry(opcode);
+				uint8_t Vy = getVyRegistry(opcode);
+				uint8_t height = opcode & 0x000Fu; // Get the height of the sprite to draw
+
+				if (m.I + height > machine::addressMask + 1u) [[unlikely]]
+				{
+					m.faults.raise(FAULT_MEMORY_OUT_OF_RANGE, m.pc - 2, opcode);
+				}
+
+				m.V[0xF] = 0; // Clear the collision flag
+				// With clipping, rows and columns past the edge are dropped; the start position still wraps
+				const uint8_t lastCol = m.quirks.clipSprites ? static_cast<uint8_t>(std::min(8, 64 - m.V[Vx] % 64)) : 8;
+				if (m.quirks.clipSprites)
+				{
+					height = static_cast<uint8_t>(std::min<int>(height, 32 - m.V[Vy] % 32));
+				}
+				for (uint8_t row = 0; row < height; ++row)
+				{
+					uint8_t spriteRow = m.memory[(m.I + row) & machine::addressMask]; // Get the sprite row from memory
+					for (uint8_t col = 0; col < lastCol; ++col)
+					{
+						if ((spriteRow & (0x80 >> col)) != 0) // Check if the pixel is set
+						{
+							uint8_t x = (m.V[Vx] + col) % 64; // Wrap around the screen width
+							uint8_t y = (m.V[Vy] + row) % 32; // Wrap around the screen height
+
+							if (m.screen[x][y] == 1) // Check for collision
+							{
+								m.V[0xF] = 1; // Set collision flag
+							}
+							m.togglePixel(x, y); // Toggle the pixel on the display
+						}
+					}
+				}
+				m.draw_flag = true; // Indicate that the screen needs to be redrawn
+				break;
+			}
+			case 0xE000:
+				switch (opcode & 0x00FF)
+				{
+					/* SKP Vx */
+					case 0x9E:
+					{
+						const uint8_t key = m.V[getVxRegistry(opcode)] & 0x0Fu;
+						if (m.keypad[key])
+						{
+							m.pc += 2; // Skip the next instruction if the key in Vx is pressed
+						}
+						break;
+					}
+					/* SKNP Vx */
+					case 0xA1:
+					{
+						const uint8_t key = m.V[getVxRegistry(opcode)] & 0x0Fu;
+						if (!m.keypad[key])
+						{
+							m.pc += 2; // Skip the next instruction if the key in Vx is pressed
+						}
+						break;
+					}
+					default:
+						m.faults.raise(FAULT_UNKNOWN_OPCODE, m.pc - 2, opcode);
+						break;
+				}
+				break;
+			case 0xF000:
+				switch (opcode & 0x00FF)
+				{
+					/* LD Vx, DT */
+					case 0x07:
+					{
+						m.V[getVxRegistry(opcode)] = m.delayTimer; // Load the value of the delay timer into Vx
+						break;
+					}
+					/* LD Vx, K */
+					case 0x0A:
+					{
+						uint8_t Vx = getVxRegistry(opcode);
+						if (m.keypad[0])
+						{
+							m.V[Vx] = 0;
+						}
+						else if (m.keypad[1])
+						{
+							m.V[Vx] = 1;
+						}
+						else if (m.keypad[2])
+						{
+							m.V[Vx] = 2;
+						}
+						else if (m.keypad[3])
+						{
+							m.V[Vx] = 3;
+						}
+						else if (m.keypad[4])
+						{
+							m.V[Vx] = 4;
+						}
+						else if (m.keypad[5])
+						{
+							m.V[Vx] = 5;
+						}
+						else if (m.keypad[6])
+						{
+							m.V[Vx] = 6;
+						}
+						else if (m.keypad[7])
+						{
+							m.V[Vx] = 7;
+						}
+						else if (m.keypad[8])
+						{
+							m.V[Vx] = 8;
+						}
+						else if (m.keypad[9])
+						{
+							m.V[Vx] = 9;
+						}
+						else if (m.keypad[10])
+						{
+							m.V[Vx] = 10;
+						}
+						else if (m.keypad[11])
+						{
+							m.V[Vx] = 11;
+						}
+						else if (m.keypad[12])
+						{
+							m.V[Vx] = 12;
+						}
+						else if (m.keypad[13])
+						{
+							m.V[Vx] = 13;
+						}
+						else if (m.keypad[14])
+						{
+							m.V[Vx] = 14;
+						}
+						else if (m.keypad[15])
+						{
+							m.V[Vx] = 15;
+						}
+						else
+						{
+							m.pc -= 2;
+						}
+						break;
+					}
+					/* LD DT, Vx */
+					case 0x15:
+					{
+						m.delayTimer = m.V[getVxRegistry(opcode)]; // Load the value of Vx into the delay timer
+						break;
+					}
+					/* LD ST, Vx */
+					case 0x18:
+					{
+						m.soundTimer = m.V[getVxRegistry(opcode)];
+						break;
+					}
+					/* ADD I, Vx */
+					case 0x1E:
+					{
+						m.I += m.V[getVxRegistry(opcode)]; // Add the value of Vx to the index register I
+						break;
+					}
+					/* LD F, Vx */
+					case 0x29:
+					{
+						uint8_t key = m.V[getVxRegistry(opcode)];
+
+						m.I = machine::fontSetStartAddress + (key * 5); // Set I to the address of the font character corresponding to Vx
+						break;
+					}
+					/* LD B, Vx */
+					case 0x33:
+					{
+						// takes the decimal value of Vx, and places the hundreds digit in memory at location in I, the tens digit at location I+1, and the ones digit at location I+2.
+						uint8_t value = m.V[getVxRegistry(opcode)];
+						if (m.I + 2u > machine::addressMask) [[unlikely]]
+						{
+							m.faults.raise(FAULT_MEMORY_OUT_OF_RANGE, m.pc - 2, opcode);
+						}
+						m.writeMemory((m.I + 2u) & machine::addressMask, value % 10);
+						value /= 10;
+						m.writeMemory((m.I + 1u) & machine::addressMask, value % 10);
+						value /= 10;
+						m.writeMemory(m.I & machine::addressMask, value % 10);
+						break;
+					}
+					/* LD [I], Vx */
+					case 0x55:
+					{
+						const uint8_t Vx = getVxRegistry(opcode);
+						if (m.I + Vx > machine::addressMask) [[unlikely]]
+						{
+							m.faults.raise(FAULT_MEMORY_OUT_OF_RANGE, m.pc - 2, opcode);
+						}
+						for (uint8_t i = 0; i <= Vx; ++i)
+						{
+							m.writeMemory((m.I + i) & machine::addressMask, m.V[i]); // Store the values of V0 to Vx in memory starting at address I
+						}
+						if (m.quirks.loadStoreIncrementsI)
+						{
+							m.I = static_cast<uint16_t>(m.I + Vx + 1u);
+						}
+						break;
+					}
+					/* LD Vx, [I] */
+					case 0x65:
+					{
+						const uint8_t Vx = getVxRegistry(opcode);
+						if (m.I + Vx > machine::addressMask) [[unlikely]]
+						{
+							m.faults.raise(FAULT_MEMORY_OUT_OF_RANGE, m.pc - 2, opcode);
+						}
+						for (uint8_t i = 0; i <= Vx; ++i)
+						{
+							m.V[i] = m.memory[(m.I + i) & machine::addressMask]; // Store the values of V0 to Vx in memory starting at address I
+						}
+						if (m.quirks.loadStoreIncrementsI)
+						{
+							m.I = static_cast<uint16_t>(m.I + Vx + 1u);
+						}
+						break;
+					}
+					default:
+					{
+						m.faults.raise(FAULT_UNKNOWN_OPCODE, m.pc - 2, opcode);
+						break;
+					}
+				}
+				break;
+			default:
+				m.faults.raise(FAULT_UNKNOWN_OPCODE, m.pc - 2, opcode);
+				break;
+		}
+	}
+
+	// Copies a ROM to the entry point. What does not fit is dropped (and logged), as the
+	// original loader did; false only for an empty ROM.
+	inline bool copyRom(uint8_t (&memory)[4096], const uint8_t* data, std::size_t size)
+	{
+		const std::size_t capacity = sizeof(memory) - static_cast<std::size_t>(machine::entryPoint);
+		if (size == 0)
+		{
+			LOG_ERROR("ROM is empty");
+			return false;
+		}
+		if (size > capacity)
+		{
+			LOG_ERROR("ROM truncated: %zu bytes didn't fit", size - capacity);
+		}
+		memcpy(memory + machine::entryPoint, data, std::min(size, capacity));
+		return true;
+	}
+
+	// 64-bit FNV-1a over all guest-visible state. `V` and `stack` only need operator[],
+	// so the lockstep engine can pass a lane's columns; 16-bit values are mixed low byte
+	// first so digests match across backends and hosts.
+	template <typename Registers, typename Stack>
+	uint64_t stateDigest(const uint8_t (&memory)[4096], const Registers& V, uint16_t I, uint16_t pc, const Stack& stack,
+		uint8_t sp, uint8_t delayTimer, uint8_t soundTimer, const uint8_t (&screen)[64][32])
+	{
+		uint64_t hash = 0xCBF29CE484222325ull;
+		auto mix = [&hash](const uint8_t* bytes, std::size_t size) {
+			for (std::size_t i = 0; i < size; ++i)
+			{
+				hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+			}
+		};
+		auto mix16 = [&mix](uint16_t value) {
+			const uint8_t bytes[2] = { static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8) };
+			mix(bytes, 2);
+		};
+
+		mix(memory, sizeof(memory));
+		for (int r = 0; r < 16; ++r)
+		{
+			const uint8_t value = V[r];
+			mix(&value, 1);
+		}
+		mix16(I);
+		mix16(pc);
+		for (int s = 0; s < 16; ++s)
+		{
+			mix16(stack[s]);
+		}
+		mix(&sp, 1);
+		mix(&delayTimer, 1);
+		mix(&soundTimer, 1);
+		mix(&screen[0][0], sizeof(screen));
+		return hash;
+	}
+
+	// Packs a 64x32 screen row-major, 8 pixels per byte, MSB first
+	inline void packScreen(const uint8_t (&screen)[64][32], uint8_t out[256])
+	{
+		for (int y = 0; y < 32; ++y)
+		{
+			for (int byte = 0; byte < 8; ++byte)
+			{
+				uint8_t packed = 0;
+				for (int bit = 0; bit < 8; ++bit)
+				{
+					packed = static_cast<uint8_t>((packed << 1) | (screen[byte * 8 + bit][y] & 1u));
+				}
+				out[y * 8 + byte] = packed;
+			}
+		}
+	}
+}
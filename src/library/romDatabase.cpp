@@ -0,0 +1,129 @@
+#include "library/romDatabase.h"
+
+#include <cctype>
+#include <filesystem>
+
+#include "util/json.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	// Database quirk names are phrased the other way round from ours in places:
+	// "shift" means shift Vx in place, "wrap" means sprites wrap. memoryIncrementByX
+	// (I += x rather than x + 1) has no switch here and is treated as incrementing.
+	void applyDatabaseQuirks(const jsonValue& quirks, quirkProfile& profile)
+	{
+		auto flag = [&quirks](const char* name, bool& value) {
+			const jsonValue* v = quirks.find(name);
+			if (!v || v->type != jsonValue::JSON_BOOL)
+				return false;
+			value = v->boolean;
+			return true;
+		};
+		bool value = false;
+		if (flag("shift", value))
+			profile.shiftUsesVy = !value;
+		if (flag("memoryLeaveIUnchanged", value))
+			profile.loadStoreIncrementsI = !value;
+		if (flag("jump", value))
+			profile.jumpUsesVx = value;
+		if (flag("logic", value))
+			profile.logicResetsVf = value;
+		if (flag("wrap", value))
+			profile.clipSprites = !value;
+	}
+
+	uint64_t fileStampOf(const fs::path& path)
+	{
+		std::error_code ec;
+		const uint64_t size = fs::file_size(path, ec);
+		const auto modified = fs::last_write_time(path, ec).time_since_epoch().count();
+		return ec ? 0 : (size * 0x100000001B3ull) ^ static_cast<uint64_t>(modified);
+	}
+}
+
+bool romDatabase::load(const std::string& directory)
+{
+	const fs::path programsPath = fs::path(directory) / "programs.json";
+	const fs::path platformsPath = fs::path(directory) / "platforms.json";
+
+	jsonValue programs;
+	if (!loadJsonFile(programsPath.string(), programs) || !programs.isArray())
+	{
+		LOG_ERROR("ROM database: could not read %s", programsPath.string().c_str());
+		return false;
+	}
+	jsonValue platforms;
+	if (!loadJsonFile(platformsPath.string(), platforms) || !platforms.isArray())
+	{
+		LOG_WARNING("ROM database: no platforms.json, quirks will not be recommended");
+	}
+
+	// Platform id -> quirks
+	std::unordered_map<std::string, quirkProfile> platformQuirks;
+	for (const jsonValue& platform : platforms.items)
+	{
+		const jsonValue* id = platform.find("id");
+		const jsonValue* quirks = platform.find("quirks");
+		if (!id || !id->isString() || !quirks || !quirks->isObject())
+			continue;
+		quirkProfile profile;
+		applyDatabaseQuirks(*quirks, profile);
+		platformQuirks[id->string] = profile;
+	}
+
+	bySha1.clear();
+	for (const jsonValue& program : programs.items)
+	{
+		const jsonValue* title = program.find("title");
+		const jsonValue* roms = program.find("roms");
+		if (!roms || !roms->isObject())
+			continue;
+		for (const auto& [hash, rom] : roms->members)
+		{
+			romMetadata meta;
+			meta.title = title && title->isString() ? title->string : std::string();
+			if (const jsonValue* tickrate = rom.find("tickrate"); tickrate && tickrate->isNumber())
+			{
+				meta.tickrate = static_cast<int>(tickrate->number);
+			}
+			// The first listed platform is the one the ROM was written for
+			const jsonValue* romPlatforms = rom.find("platforms");
+			if (romPlatforms && romPlatforms->isArray() && !romPlatforms->items.empty() && romPlatforms->items[0].isString())
+			{
+				meta.platform = romPlatforms->items[0].string;
+				const auto known = platformQuirks.find(meta.platform);
+				if (known != platformQuirks.end())
+				{
+					meta.quirks = known->second;
+					meta.hasQuirks = true;
+				}
+				const jsonValue* overrides = rom.find("quirkyPlatforms");
+				const jsonValue* own = overrides ? overrides->find(meta.platform.c_str()) : nullptr;
+				if (own && own->isObject())
+				{
+					applyDatabaseQuirks(*own, meta.quirks);
+					meta.hasQuirks = true;
+				}
+			}
+
+			std::string key = hash;
+			for (char& c : key)
+			{
+				c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+			}
+			bySha1[key] = std::move(meta);
+		}
+	}
+
+	fileStamp = fileStampOf(programsPath) ^ (fileStampOf(platformsPath) * 31u);
+	LOG("ROM database: %zu ROM images from %s", bySha1.size(), directory.c_str());
+	return true;
+}
+
+const romMetadata* romDatabase::find(const sha1Digest& digest) const
+{
+	const auto it = bySha1.find(digest.hex());
+	return it == bySha1.end() ? nullptr : &it->second;
+}
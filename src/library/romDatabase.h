@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "quirkProfile.h"
+#include "util/sha1.h"
+
+// What the database knows about one ROM image
+struct romMetadata
+{
+	std::string title;
+	std::string platform; // database platform id, e.g. "originalChip8"
+	int tickrate = 0;	  // recommended instructions per frame, 0 = not given
+	quirkProfile quirks;
+	bool hasQuirks = false; // false when the platform is not one the database describes
+};
+
+// Lookup by SHA-1 into a checkout of the community CHIP-8 database
+// (https://github.com/chip-8/chip-8-database, the "database" directory). Reads
+// programs.json for titles, tickrates and per-ROM quirk overrides and platforms.json
+// for each platform's quirks.
+class romDatabase
+{
+public:
+	bool load(const std::string& directory);
+
+	const romMetadata* find(const sha1Digest& digest) const;
+	std::size_t size() const { return bySha1.size(); }
+	bool empty() const { return bySha1.empty(); }
+
+	// Changes whenever the database files do; the library index stores it so that
+	// metadata is looked up again after the database is updated
+	uint64_t stamp() const { return fileStamp; }
+
+private:
+	std::unordered_map<std::string, romMetadata> bySha1; // lowercase hex
+	uint64_t fileStamp = 0;
+};
@@ -0,0 +1,325 @@
+#include "library/romLibrary.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+
+#include "rom/romImage.h"
+#include "trace/trace.h"
+#include "util/byteStream.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	// Index file: magic, version, database stamp, entry count, then the entries
+	constexpr uint32_t indexMagic = 0x424C3843u; // "C8LB"
+	constexpr uint32_t indexVersion = 1;
+
+	constexpr auto publishInterval = std::chrono::milliseconds(100);
+
+	bool isRomFile(const fs::path& path)
+	{
+		std::string extension = path.extension().string();
+		for (char& c : extension)
+		{
+			c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+		}
+		return extension == ".ch8" || extension == ".c8";
+	}
+
+	void sortByName(std::vector<romEntry>& list)
+	{
+		// Lower-cased names computed once rather than in every comparison
+		std::vector<std::pair<std::string, std::size_t>> keys(list.size());
+		for (std::size_t i = 0; i < list.size(); ++i)
+		{
+			keys[i].first = list[i].displayName();
+			for (char& c : keys[i].first)
+			{
+				c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+			}
+			keys[i].second = i;
+		}
+		std::sort(keys.begin(), keys.end());
+		std::vector<romEntry> sorted;
+		sorted.reserve(list.size());
+		for (const auto& key : keys)
+		{
+			sorted.push_back(std::move(list[key.second]));
+		}
+		list = std::move(sorted);
+	}
+}
+
+std::string romEntry::displayName() const
+{
+	if (known && !metadata.title.empty())
+		return metadata.title;
+	return fs::path(path).filename().string();
+}
+
+romLibrary::romLibrary(libraryOptions options) : options(std::move(options)), published(std::make_shared<std::vector<romEntry>>())
+{
+}
+
+romLibrary::~romLibrary()
+{
+	stopping = true;
+	if (worker.joinable())
+	{
+		worker.join();
+	}
+}
+
+void romLibrary::start()
+{
+	if (worker.joinable())
+		return;
+	scanActive = true;
+	worker = std::thread([this] {
+		trace::setThreadName("library");
+		scanNow();
+	});
+}
+
+void romLibrary::scanNow()
+{
+	scanActive = true;
+	scan();
+	scanActive = false;
+}
+
+std::shared_ptr<const std::vector<romEntry>> romLibrary::entries() const
+{
+	std::lock_guard<std::mutex> guard(publishLock);
+	return published;
+}
+
+void romLibrary::publish(std::vector<romEntry> list)
+{
+	sortByName(list);
+	auto next = std::make_shared<const std::vector<romEntry>>(std::move(list));
+	std::lock_guard<std::mutex> guard(publishLock);
+	published = std::move(next);
+}
+
+void romLibrary::scan()
+{
+	TRACE_ZONE("romLibrary::scan");
+	scannedFiles = 0;
+	hashedFiles = 0;
+
+	// Show what the last run found straight away
+	std::vector<romEntry> previous;
+	uint64_t previousStamp = 0;
+	if (loadIndex(previous, previousStamp))
+	{
+		publish(previous);
+	}
+
+	if (!options.databaseDir.empty())
+	{
+		database.load(options.databaseDir);
+	}
+	const bool metadataStale = previousStamp != database.stamp();
+	auto lookup = [this](romEntry& entry) {
+		const romMetadata* meta = database.find(entry.sha1);
+		entry.known = meta != nullptr;
+		entry.metadata = meta ? *meta : romMetadata();
+	};
+
+	std::unordered_map<std::string, std::size_t> byPath;
+	for (std::size_t i = 0; i < previous.size(); ++i)
+	{
+		byPath[previous[i].path] = i;
+	}
+	std::vector<bool> visited(previous.size(), false);
+
+	std::vector<romEntry> found;
+	auto lastPublish = std::chrono::steady_clock::now();
+	for (const std::string& directory : options.directories)
+	{
+		std::error_code ec;
+		fs::recursive_directory_iterator it(directory, fs::directory_options::skip_permission_denied, ec);
+		if (ec)
+		{
+			LOG_ERROR("ROM library: cannot scan %s: %s", directory.c_str(), ec.message().c_str());
+			continue;
+		}
+		for (; it != fs::recursive_directory_iterator(); it.increment(ec))
+		{
+			if (stopping)
+				return;
+			if (ec)
+				break;
+			if (!it->is_regular_file(ec) || !isRomFile(it->path()))
+				continue;
+
+			romEntry entry;
+			entry.path = it->path().string();
+			entry.size = it->file_size(ec);
+			entry.modified = static_cast<int64_t>(it->last_write_time(ec).time_since_epoch().count());
+			const auto known = byPath.find(entry.path);
+			if (known != byPath.end() && !visited[known->second] && previous[known->second].size == entry.size &&
+				previous[known->second].modified == entry.modified)
+			{
+				visited[known->second] = true;
+				entry = std::move(previous[known->second]);
+				if (metadataStale)
+				{
+					lookup(entry);
+				}
+			}
+			else
+			{
+				if (known != byPath.end())
+				{
+					visited[known->second] = true;
+				}
+				const std::shared_ptr<const romImage> rom = romImage::load(entry.path);
+				if (!rom)
+					continue;
+				entry.hash = rom->hash();
+				entry.sha1 = sha1(rom->data(), rom->size());
+				lookup(entry);
+				++hashedFiles;
+			}
+			found.push_back(std::move(entry));
+			++scannedFiles;
+
+			// Publish progress: everything found so far plus last run's entries not reached yet
+			const auto now = std::chrono::steady_clock::now();
+			if (now - lastPublish >= publishInterval)
+			{
+				std::vector<romEntry> progress = found;
+				for (std::size_t i = 0; i < previous.size(); ++i)
+				{
+					if (!visited[i])
+					{
+						progress.push_back(previous[i]);
+					}
+				}
+				publish(std::move(progress));
+				lastPublish = now;
+			}
+		}
+	}
+
+	const std::size_t count = found.size();
+	if (!saveIndex(found))
+	{
+		LOG_ERROR("ROM library: failed to write %s", options.indexPath.c_str());
+	}
+	publish(std::move(found));
+	LOG("ROM library: %zu ROMs, %zu hashed", count, hashedFiles.load());
+}
+
+bool romLibrary::loadIndex(std::vector<romEntry>& list, uint64_t& databaseStamp) const
+{
+	std::ifstream file(options.indexPath, std::ios::binary);
+	if (!file.is_open())
+		return false;
+	const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	byteReader in(data);
+	if (in.u32() != indexMagic || in.u32() != indexVersion)
+	{
+		LOG_WARNING("ROM library: ignoring %s (not a current index)", options.indexPath.c_str());
+		return false;
+	}
+	databaseStamp = in.u64();
+	const uint32_t count = in.u32();
+	std::vector<romEntry> entries;
+	entries.reserve(std::min<uint32_t>(count, 1u << 20));
+	for (uint32_t i = 0; i < count && in.ok(); ++i)
+	{
+		romEntry e;
+		e.path = in.text();
+		e.size = in.u64();
+		e.modified = static_cast<int64_t>(in.u64());
+		e.hash = in.u64();
+		in.raw(e.sha1.bytes, sizeof(e.sha1.bytes));
+		const uint8_t flags = in.u8();
+		e.known = flags & 1u;
+		e.metadata.hasQuirks = flags & 2u;
+		e.metadata.title = in.text();
+		e.metadata.platform = in.text();
+		e.metadata.tickrate = in.u16();
+		e.metadata.quirks = quirkProfile::fromBits(in.u8());
+		entries.push_back(std::move(e));
+	}
+	if (!in.ok())
+	{
+		LOG_WARNING("ROM library: %s is truncated, rescanning", options.indexPath.c_str());
+		return false;
+	}
+	list = std::move(entries);
+	return true;
+}
+
+bool romLibrary::saveIndex(const std::vector<romEntry>& list) const
+{
+	byteWriter out;
+	out.u32(indexMagic);
+	out.u32(indexVersion);
+	out.u64(database.stamp());
+	out.u32(static_cast<uint32_t>(list.size()));
+	for (const romEntry& e : list)
+	{
+		out.text(e.path);
+		out.u64(e.size);
+		out.u64(static_cast<uint64_t>(e.modified));
+		out.u64(e.hash);
+		out.raw(e.sha1.bytes, sizeof(e.sha1.bytes));
+		out.u8(static_cast<uint8_t>((e.known ? 1u : 0u) | (e.metadata.hasQuirks ? 2u : 0u)));
+		out.text(e.metadata.title);
+		out.text(e.metadata.platform);
+		out.u16(static_cast<uint16_t>(std::clamp(e.metadata.tickrate, 0, 0xFFFF)));
+		out.u8(e.metadata.quirks.bits());
+	}
+
+	// Write beside the index and rename, so a crash never leaves half a file
+	const std::string temporary = options.indexPath + ".tmp";
+	FILE* file = fopen(temporary.c_str(), "wb");
+	if (!file)
+		return false;
+	const bool written = fwrite(out.bytes.data(), 1, out.bytes.size(), file) == out.bytes.size();
+	fclose(file);
+	std::error_code ec;
+	if (written)
+	{
+		fs::rename(temporary, options.indexPath, ec);
+	}
+	if (!written || ec)
+	{
+		fs::remove(temporary, ec);
+		return false;
+	}
+	return true;
+}
+
+int runLibraryScan(const libraryOptions& options)
+{
+	if (options.directories.empty())
+	{
+		LOG_ERROR("--scan-library needs at least one --library <dir>");
+		return 1;
+	}
+	const auto start = std::chrono::steady_clock::now();
+	romLibrary library(options);
+	library.scanNow();
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	const std::shared_ptr<const std::vector<romEntry>> entries = library.entries();
+	const std::size_t known =
+		static_cast<std::size_t>(std::count_if(entries->begin(), entries->end(), [](const romEntry& e) { return e.known; }));
+	printf("%zu ROMs (%zu in the database), %zu hashed, in %.1f ms; index %s\n", entries->size(), known, library.filesHashed(), ms,
+		options.indexPath.c_str());
+	return 0;
+}
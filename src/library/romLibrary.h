@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "library/romDatabase.h"
+#include "util/sha1.h"
+
+struct romEntry
+{
+	std::string path;
+	uint64_t size = 0;
+	int64_t modified = 0; // filesystem timestamp ticks; with size, decides whether to rehash
+	uint64_t hash = 0;	  // FNV-1a, as romImage::hash
+	sha1Digest sha1;
+	bool known = false; // found in the database
+	romMetadata metadata;
+
+	// Database title, or the file name when the ROM is unknown
+	std::string displayName() const;
+};
+
+struct libraryOptions
+{
+	std::vector<std::string> directories;
+	std::string databaseDir; // chip-8-database "database" directory; empty = no metadata
+	std::string indexPath = "rom-library.idx";
+};
+
+// Indexed collection of the ROMs under a set of directories. start() loads the binary
+// index written by the previous run, publishes it immediately and rescans on a
+// background thread; only files whose size or timestamp changed are read and hashed
+// again. Readers take the current list with entries(): a published list is never
+// modified, the scan replaces it as it goes.
+class romLibrary
+{
+public:
+	explicit romLibrary(libraryOptions options);
+	~romLibrary();
+
+	romLibrary(const romLibrary&) = delete;
+	romLibrary& operator=(const romLibrary&) = delete;
+
+	void start();
+	// Same work on the calling thread, for headless use
+	void scanNow();
+
+	// Sorted by display name
+	std::shared_ptr<const std::vector<romEntry>> entries() const;
+	bool scanning() const { return scanActive.load(std::memory_order_relaxed); }
+	std::size_t filesScanned() const { return scannedFiles.load(std::memory_order_relaxed); }
+	std::size_t filesHashed() const { return hashedFiles.load(std::memory_order_relaxed); }
+
+private:
+	void scan();
+	void publish(std::vector<romEntry> list);
+	bool loadIndex(std::vector<romEntry>& list, uint64_t& databaseStamp) const;
+	bool saveIndex(const std::vector<romEntry>& list) const;
+
+	libraryOptions options;
+	romDatabase database;
+
+	mutable std::mutex publishLock;
+	std::shared_ptr<const std::vector<romEntry>> published;
+
+	std::thread worker;
+	std::atomic<bool> stopping{ false };
+	std::atomic<bool> scanActive{ false };
+	std::atomic<std::size_t> scannedFiles{ 0 };
+	std::atomic<std::size_t> hashedFiles{ 0 };
+};
+
+// Entry point for --scan-library: scans synchronously, writes the index and prints a
+// summary. Returns a process exit code.
+int runLibraryScan(const libraryOptions& options);
@@ -0,0 +1,205 @@
+#include "library/thumbnailCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+#include "batch/threadPool.h"
+#include "library/romLibrary.h"
+#include "machine.h"
+#include "quirks/quirkDetector.h"
+#include "rom/romImage.h"
+#include "trace/trace.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	// File: magic, then the settings the preview was made with (little-endian u32 each),
+	// then the packed screen. A file made with other settings is regenerated.
+	constexpr char thumbnailMagic[4] = { 'C', '8', 'T', 'N' };
+	constexpr std::size_t headerSize = 16;
+
+	void putU32(uint8_t* out, uint32_t value)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			out[i] = static_cast<uint8_t>(value >> (i * 8));
+		}
+	}
+
+	void fillHeader(uint8_t out[headerSize], int frames, int cyclesPerFrame, uint8_t quirkBits)
+	{
+		memcpy(out, thumbnailMagic, sizeof(thumbnailMagic));
+		putU32(out + 4, static_cast<uint32_t>(frames));
+		putU32(out + 8, static_cast<uint32_t>(cyclesPerFrame));
+		putU32(out + 12, quirkBits);
+	}
+}
+
+thumbnailCache::thumbnailCache(thumbnailOptions options) : options(std::move(options))
+{
+	std::error_code ec;
+	fs::create_directories(this->options.directory, ec);
+	const unsigned int jobs = this->options.jobs ? this->options.jobs : std::max(1u, std::thread::hardware_concurrency() / 2);
+	pool = std::make_unique<threadPool>(jobs, "thumbnails", true);
+}
+
+thumbnailCache::~thumbnailCache()
+{
+	// Queued tasks see the flag and return without generating
+	stopping = true;
+	pool.reset();
+}
+
+bool thumbnailCache::request(const romEntry& entry, uint8_t pixels[pixelBytes])
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		const auto found = ready.find(entry.hash);
+		if (found != ready.end())
+		{
+			memcpy(pixels, found->second.pixels, pixelBytes);
+			return true;
+		}
+		if (generating.count(entry.hash) || failed.count(entry.hash))
+			return false;
+
+		const auto queuedRequest = pending.find(entry.hash);
+		if (queuedRequest != pending.end())
+		{
+			queuedRequest->second.order = ++nextOrder;
+			return false;
+		}
+		pendingRequest next;
+		next.path = entry.path;
+		next.cyclesPerFrame = entry.known && entry.metadata.tickrate > 0 ? entry.metadata.tickrate : 700 / 60;
+		next.fromDatabase = entry.known && entry.metadata.hasQuirks;
+		next.quirkBits = next.fromDatabase ? entry.metadata.quirks.bits() : options.quirks.bits();
+		next.order = ++nextOrder;
+		pending.emplace(entry.hash, std::move(next));
+	}
+	// One task per queued ROM; each task picks whichever ROM is most wanted when it runs
+	pool->submit([this] { generateNext(); });
+	return false;
+}
+
+std::size_t thumbnailCache::queued() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return pending.size() + generating.size();
+}
+
+void thumbnailCache::generateNext()
+{
+	if (stopping)
+		return;
+	TRACE_ZONE("thumbnailCache::generate");
+
+	uint64_t hash = 0;
+	pendingRequest job;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (pending.empty())
+			return;
+		const auto newest = std::max_element(pending.begin(), pending.end(),
+			[](const auto& a, const auto& b) { return a.second.order < b.second.order; });
+		hash = newest->first;
+		job = std::move(newest->second);
+		pending.erase(newest);
+		generating.insert(hash);
+	}
+
+	// Read here rather than in request(): it is a file read, and the GUI thread must not wait on it
+	quirkProfile detected;
+	if (!job.fromDatabase && !options.autoQuirksCache.empty() && lookupCachedQuirks(options.autoQuirksCache, hash, detected))
+	{
+		job.quirkBits = detected.bits();
+	}
+
+	thumbnail result;
+	bool ok = loadFromDisk(hash, job, result);
+	if (!ok)
+	{
+		// No input, at the speed and quirks the ROM would be opened with
+		const std::shared_ptr<const romImage> image = romImage::load(job.path);
+		machine m;
+		m.recordHistory = false;
+		m.faults.maxFirstLogsPerInterval = 0;
+		m.quirks = quirkProfile::fromBits(job.quirkBits);
+		ok = image && image->hash() == hash && m.loadRom(image);
+		for (int frame = 0; ok && frame < options.frames; ++frame)
+		{
+			m.runCycles(job.cyclesPerFrame);
+			m.tickTimers();
+		}
+		if (ok)
+		{
+			m.packScreen(result.pixels);
+			saveToDisk(hash, job, result);
+		}
+	}
+
+	std::lock_guard<std::mutex> guard(lock);
+	generating.erase(hash);
+	if (ok)
+	{
+		ready[hash] = result;
+	}
+	else
+	{
+		// Missing, changed since the scan, or unloadable: leave the row without a preview
+		failed.insert(hash);
+	}
+}
+
+std::string thumbnailCache::cachePath(uint64_t hash) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(hash));
+	return (fs::path(options.directory) / name).string();
+}
+
+bool thumbnailCache::loadFromDisk(uint64_t hash, const pendingRequest& job, thumbnail& out) const
+{
+	FILE* file = fopen(cachePath(hash).c_str(), "rb");
+	if (!file)
+		return false;
+	uint8_t bytes[headerSize + pixelBytes];
+	const bool complete = fread(bytes, 1, sizeof(bytes), file) == sizeof(bytes);
+	fclose(file);
+
+	uint8_t expected[headerSize];
+	fillHeader(expected, options.frames, job.cyclesPerFrame, job.quirkBits);
+	if (!complete || memcmp(bytes, expected, headerSize) != 0)
+		return false;
+	memcpy(out.pixels, bytes + headerSize, pixelBytes);
+	return true;
+}
+
+void thumbnailCache::saveToDisk(uint64_t hash, const pendingRequest& job, const thumbnail& image) const
+{
+	uint8_t bytes[headerSize + pixelBytes];
+	fillHeader(bytes, options.frames, job.cyclesPerFrame, job.quirkBits);
+	memcpy(bytes + headerSize, image.pixels, pixelBytes);
+
+	// Write beside the final name and rename, so a reader never sees half a file
+	const std::string path = cachePath(hash);
+	const std::string temporary = path + ".tmp";
+	FILE* file = fopen(temporary.c_str(), "wb");
+	if (!file)
+		return;
+	const bool written = fwrite(bytes, 1, sizeof(bytes), file) == sizeof(bytes);
+	fclose(file);
+	std::error_code ec;
+	if (written)
+	{
+		fs::rename(temporary, path, ec);
+	}
+	if (!written || ec)
+	{
+		fs::remove(temporary, ec);
+	}
+}
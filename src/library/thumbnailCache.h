@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "quirkProfile.h"
+
+class threadPool;
+struct romEntry;
+
+struct thumbnailOptions
+{
+	std::string directory = "thumbnails"; // one small file per ROM hash
+	int frames = 180;					  // how far in the preview is taken (3 s at 60 Hz)
+	unsigned int jobs = 0;				  // 0 = half the hardware threads
+	// ROMs without database quirks preview as they would open: with this (--quirks)
+	// profile, or with --quirks auto, the profile in this detection cache if it has one
+	quirkProfile quirks;
+	std::string autoQuirksCache;
+};
+
+// ROM browser previews: each ROM's screen a few seconds in, from a headless run with
+// no input. request() never blocks; misses are queued for a background pool and the
+// most recently requested ROM is generated first, so rows scrolled into view jump the
+// queue. Results are kept in memory and on disk under the ROM's content hash.
+class thumbnailCache
+{
+public:
+	static constexpr int pixelBytes = 256; // 64x32, row-major, 8 pixels per byte, MSB first
+
+	explicit thumbnailCache(thumbnailOptions options);
+	~thumbnailCache();
+
+	thumbnailCache(const thumbnailCache&) = delete;
+	thumbnailCache& operator=(const thumbnailCache&) = delete;
+
+	// Copies the thumbnail into `pixels` if it is ready; otherwise queues it (or raises
+	// its priority if already queued) and returns false
+	bool request(const romEntry& entry, uint8_t pixels[pixelBytes]);
+
+	std::size_t queued() const;
+
+private:
+	struct pendingRequest
+	{
+		std::string path;
+		int cyclesPerFrame;
+		uint8_t quirkBits;
+		bool fromDatabase; // quirkBits came from the ROM database
+		uint64_t order;	   // higher = requested more recently
+	};
+	struct thumbnail
+	{
+		uint8_t pixels[pixelBytes];
+	};
+
+	void generateNext();
+	std::string cachePath(uint64_t hash) const;
+	bool loadFromDisk(uint64_t hash, const pendingRequest& job, thumbnail& out) const;
+	void saveToDisk(uint64_t hash, const pendingRequest& job, const thumbnail& image) const;
+
+	thumbnailOptions options;
+
+	mutable std::mutex lock;
+	std::unordered_map<uint64_t, thumbnail> ready;
+	std::unordered_map<uint64_t, pendingRequest> pending;
+	std::unordered_set<uint64_t> generating;
+	std::unordered_set<uint64_t> failed; // not retried this session
+	uint64_t nextOrder = 0;
+	std::atomic<bool> stopping{ false };
+
+	std::unique_ptr<threadPool> pool; // last, so it drains before the rest is destroyed
+};
@@ -0,0 +1,520 @@
+#include "lockstep/lockstep.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "interpreter.h"
+#include "machine.h"
+
+namespace
+{
+	// Strided access to one lane's column of a [register][lane] array
+	template <typename T, int LANES>
+	struct laneColumn
+	{
+		T* base;
+		T& operator[](std::size_t index) const { return base[index * LANES]; }
+	};
+
+	template <int LANES>
+	struct laneFaultCounter
+	{
+		uint64_t* base;
+		void raise(faultType type, uint16_t, uint16_t) { ++base[type * LANES]; }
+	};
+
+	// Presents one lane of the engine under machine's member names so the
+	// shared interpreter can execute on it unchanged
+	template <int LANES>
+	struct laneView
+	{
+		lockstepEngine<LANES>& engine;
+		const int lane;
+
+		uint8_t (&memory)[4096];
+		laneColumn<uint8_t, LANES> V;
+		uint16_t& I;
+		uint16_t& pc;
+		laneColumn<uint16_t, LANES> stack;
+		uint8_t& sp;
+		uint8_t& delayTimer;
+		uint8_t& soundTimer;
+		uint8_t (&screen)[64][32];
+		bool& draw_flag;
+		uint8_t (&keypad)[16];
+		laneFaultCounter<LANES> faults;
+		const quirkProfile& quirks;
+
+		uint8_t randomByte() { return engine.laneRandomByte(lane); }
+		void writeMemory(uint16_t address, uint8_t value) { memory[address] = value; }
+		void togglePixel(uint8_t x, uint8_t y) { screen[x][y] ^= 1; }
+		void clearScreen() { memset(screen, 0, sizeof(screen)); }
+	};
+}
+
+template <int LANES>
+lockstepEngine<LANES>::lockstepEngine(unsigned int seed)
+{
+	for (int l = 0; l < LANES; ++l)
+	{
+		randGen[l].seed(seed + static_cast<unsigned int>(l));
+		randByte[l] = std::uniform_int_distribution<int>(0, 255);
+	}
+	reset();
+}
+
+template <int LANES>
+void lockstepEngine<LANES>::reset()
+{
+	for (int l = 0; l < LANES; ++l)
+	{
+		resetLane(l);
+	}
+	convergedSteps = 0;
+	divergedSteps = 0;
+}
+
+template <int LANES>
+void lockstepEngine<LANES>::resetLane(int lane)
+{
+	for (int r = 0; r < 16; ++r)
+	{
+		V[r][lane] = 0;
+		stack[r][lane] = 0;
+	}
+	I[lane] = 0;
+	pc[lane] = machine::entryPoint;
+	sp[lane] = 0;
+	delayTimer[lane] = 0;
+	soundTimer[lane] = 0;
+	draw_flag[lane] = false;
+	memset(memory[lane], 0, sizeof(memory[lane]));
+	memcpy(memory[lane] + machine::fontSetStartAddress, machine::fontSet, sizeof(machine::fontSet));
+	memset(screen[lane], 0, sizeof(screen[lane]));
+	memset(keypad[lane], 0, sizeof(keypad[lane]));
+	for (int t = 0; t < FAULT_TYPE_COUNT; ++t)
+	{
+		faultTotals[t][lane] = 0;
+	}
+}
+
+template <int LANES>
+bool lockstepEngine<LANES>::loadRom(const std::string& filepath)
+{
+	std::ifstream file(filepath, std::ios::binary);
+	if (!file.is_open())
+	{
+		LOG_ERROR("Failed to open ROM: %s", filepath.c_str());
+		return false;
+	}
+	const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return loadRom(data.data(), data.size());
+}
+
+template <int LANES>
+bool lockstepEngine<LANES>::loadRom(const uint8_t* data, std::size_t size)
+{
+	// Lane 0 validates (and logs a truncation once); the others copy what it took
+	if (!loadLaneRom(0, data, size))
+		return false;
+	const std::size_t loaded = std::min(size, sizeof(memory[0]) - static_cast<std::size_t>(machine::entryPoint));
+	for (int l = 1; l < LANES; ++l)
+	{
+		memcpy(memory[l] + machine::entryPoint, data, loaded);
+	}
+	return true;
+}
+
+template <int LANES>
+bool lockstepEngine<LANES>::loadLaneRom(int lane, const uint8_t* data, std::size_t size)
+{
+	return interpreter::copyRom(memory[lane], data, size);
+}
+
+template <int LANES>
+void lockstepEngine<LANES>::loadLaneState(int lane, const machine& m)
+{
+	for (int r = 0; r < 16; ++r)
+	{
+		V[r][lane] = m.V[r];
+		stack[r][lane] = m.stack[r];
+	}
+	I[lane] = m.I;
+	pc[lane] = m.pc;
+	sp[lane] = m.sp;
+	delayTimer[lane] = m.delayTimer;
+	soundTimer[lane] = m.soundTimer;
+	draw_flag[lane] = m.draw_flag;
+	memcpy(memory[lane], m.memory, sizeof(memory[lane]));
+	memcpy(screen[lane], m.screen, sizeof(screen[lane]));
+	memcpy(keypad[lane], m.keypad, sizeof(keypad[lane]));
+	randGen[lane] = m.randomEngine();
+}
+
+template <int LANES>
+void lockstepEngine<LANES>::storeLaneState(int lane, machine& m) const
+{
+	for (int r = 0; r < 16; ++r)
+	{
+		m.V[r] = V[r][lane];
+		m.stack[r] = stack[r][lane];
+	}
+	m.I = I[lane];
+	m.pc = pc[lane];
+	m.sp = sp[lane];
+	m.delayTimer = delayTimer[lane];
+	m.soundTimer = soundTimer[lane];
+	m.draw_flag = draw_flag[lane];
+	memcpy(m.memory, memory[lane], sizeof(m.memory));
+	memcpy(m.screen, screen[lane], sizeof(m.screen));
+	memcpy(m.keypad, keypad[lane], sizeof(m.keypad));
+	m.setRandomEngine(randGen[lane]);
+	m.invalidateSharedCode();
+	m.rehash();
+}
+
+template <int LANES>
+void lockstepEngine<LANES>::runCycles(int cycles)
+{
+	for (int i = 0; i < cycles; ++i)
+	{
+		step();
+	}
+}
+
+template <int LANES>
+void lockstepEngine<LANES>::tickTimers()
+{
+	LANE_LOOP
+	for (int l = 0; l < LANES; ++l)
+	{
+		delayTimer[l] -= (delayTimer[l] > 0);
+		soundTimer[l] -= (soundTimer[l] > 0);
+	}
+}
+
+template <int LANES>
+void lockstepEngine<LANES>::step()
+{
+	const uint16_t lead = pc[0];
+	bool converged = true;
+	for (int l = 1; l < LANES; ++l)
+	{
+		converged &= pc[l] == lead;
+	}
+
+	// PCs at 0xFFF fault on fetch, so they always take the per-lane path
+	if (converged && lead < machine::addressMask)
+	{
+		const uint8_t hi = memory[0][lead];
+		const uint8_t lo = memory[0][lead + 1];
+		// Lanes may have rewritten their own code, so the opcode has to agree too
+		for (int l = 1; l < LANES; ++l)
+		{
+			converged &= (memory[l][lead] == hi) & (memory[l][lead + 1] == lo);
+		}
+		if (converged && stepConverged(static_cast<uint16_t>((hi << 8u) | lo)))
+		{
+			++convergedSteps;
+			return;
+		}
+	}
+
+	++divergedSteps;
+	for (int l = 0; l < LANES; ++l)
+	{
+		stepLane(l);
+	}
+}
+
+// Runs opcodes that cannot fault and touch only registers (plus CALL/RET) as one loop over all lanes.
+// Returns false, leaving every lane untouched, for anything else.
+template <int LANES>
+bool lockstepEngine<LANES>::stepConverged(uint16_t opcode)
+{
+	const uint8_t x = interpreter::getVxRegistry(opcode);
+	const uint8_t y = interpreter::getVyRegistry(opcode);
+	const uint8_t byte = opcode & 0x00FFu;
+	const uint16_t address = opcode & 0x0FFFu;
+	const uint16_t next = pc[0] + 2;
+
+	uint8_t* vx = V[x];
+	const uint8_t* vy = V[y];
+	uint8_t* vf = V[0xF];
+	const uint8_t* shiftSource = quirks.shiftUsesVy ? vy : vx;
+	// Results go through a temporary so that x == F (or y == F) keeps the interpreter's write order
+	alignas(64) uint8_t result[LANES];
+	alignas(64) uint8_t carry[LANES];
+	bool setsCarry = false;
+	bool clearsFlag = false;
+
+	switch (opcode & 0xF000)
+	{
+		/* RET */
+		case 0x0000:
+		{
+			if (opcode != 0x00EE)
+				return false;
+			uint8_t shallowest = machine::stackDepth;
+			for (int l = 0; l < LANES; ++l)
+				shallowest = sp[l] < shallowest ? sp[l] : shallowest;
+			if (shallowest == 0)
+				return false;
+			for (int l = 0; l < LANES; ++l)
+			{
+				--sp[l];
+				pc[l] = stack[sp[l]][l];
+			}
+			return true;
+		}
+		/* JP addr */
+		case 0x1000:
+			LANE_LOOP
+			for (int l = 0; l < LANES; ++l)
+				pc[l] = address;
+			return true;
+		/* CALL addr */
+		case 0x2000:
+		{
+			// A full stack faults, which only the per-lane path reports
+			uint8_t deepest = 0;
+			for (int l = 0; l < LANES; ++l)
+				deepest = sp[l] > deepest ? sp[l] : deepest;
+			if (deepest >= machine::stackDepth)
+				return false;
+			for (int l = 0; l < LANES; ++l)
+			{
+				stack[sp[l]][l] = next;
+				++sp[l];
+				pc[l] = address;
+			}
+			return true;
+		}
+		/* SE Vx, byte */
+		case 0x3000:
+			LANE_LOOP
+			for (int l = 0; l < LANES; ++l)
+				pc[l] = static_cast<uint16_t>(next + ((vx[l] == byte) << 1));
+			return true;
+		/* SNE Vx, byte */
+		case 0x4000:
+			LANE_LOOP
+			for (int l = 0; l < LANES; ++l)
+				pc[l] = static_cast<uint16_t>(next + ((vx[l] != byte) << 1));
+			return true;
+		/* SE Vx, Vy */
+		case 0x5000:
+			LANE_LOOP
+			for (int l = 0; l < LANES; ++l)
+				pc[l] = static_cast<uint16_t>(next + ((vx[l] == vy[l]) << 1));
+			return true;
+		/* SNE Vx, Vy */
+		case 0x9000:
+			LANE_LOOP
+			for (int l = 0; l < LANES; ++l)
+				pc[l] = static_cast<uint16_t>(next + ((vx[l] != vy[l]) << 1));
+			return true;
+		/* LD Vx, byte */
+		case 0x6000:
+			LANE_LOOP
+			for (int l = 0; l < LANES; ++l)
+				vx[l] = byte;
+			break;
+		/* ADD Vx, byte */
+		case 0x7000:
+			LANE_LOOP
+			for (int l = 0; l < LANES; ++l)
+				vx[l] = static_cast<uint8_t>(vx[l] + byte);
+			break;
+		/* LD I, addr */
+		case 0xA000:
+			LANE_LOOP
+			for (int l = 0; l < LANES; ++l)
+				I[l] = address;
+			break;
+		case 0x8000:
+			switch (opcode & 0x000F)
+			{
+				/* LD Vx, Vy */
+				case 0x0:
+					LANE_LOOP
+					for (int l = 0; l < LANES; ++l)
+						vx[l] = vy[l];
+					break;
+				/* OR Vx, Vy */
+				case 0x1:
+					LANE_LOOP
+					for (int l = 0; l < LANES; ++l)
+						vx[l] |= vy[l];
+					clearsFlag = quirks.logicResetsVf;
+					break;
+				/* AND Vx, Vy */
+				case 0x2:
+					LANE_LOOP
+					for (int l = 0; l < LANES; ++l)
+						vx[l] &= vy[l];
+					clearsFlag = quirks.logicResetsVf;
+					break;
+				/* XOR Vx, Vy */
+				case 0x3:
+					LANE_LOOP
+					for (int l = 0; l < LANES; ++l)
+						vx[l] ^= vy[l];
+					clearsFlag = quirks.logicResetsVf;
+					break;
+				/* ADD Vx, Vy */
+				case 0x4:
+					LANE_LOOP
+					for (int l = 0; l < LANES; ++l)
+					{
+						const uint16_t sum = static_cast<uint16_t>(vx[l] + vy[l]);
+						result[l] = static_cast<uint8_t>(sum);
+						carry[l] = static_cast<uint8_t>(sum >> 8);
+					}
+					setsCarry = true;
+					break;
+				/* SUB Vx, Vy */
+				case 0x5:
+					LANE_LOOP
+					for (int l = 0; l < LANES; ++l)
+					{
+						result[l] = static_cast<uint8_t>(vx[l] - vy[l]);
+						carry[l] = vy[l] <= vx[l];
+					}
+					setsCarry = true;
+					break;
+				/* SHR Vx */
+				case 0x6:
+					LANE_LOOP
+					for (int l = 0; l < LANES; ++l)
+					{
+						result[l] = shiftSource[l] >> 1;
+						carry[l] = shiftSource[l] & 0x1u;
+					}
+					setsCarry = true;
+					break;
+				/* SUBN Vx, Vy */
+				case 0x7:
+					LANE_LOOP
+					for (int l = 0; l < LANES; ++l)
+					{
+						result[l] = static_cast<uint8_t>(vy[l] - vx[l]);
+						carry[l] = vx[l] <= vy[l];
+					}
+					setsCarry = true;
+					break;
+				/* SHL Vx */
+				case 0xE:
+					LANE_LOOP
+					for (int l = 0; l < LANES; ++l)
+					{
+						result[l] = static_cast<uint8_t>(shiftSource[l] << 1);
+						carry[l] = shiftSource[l] >> 7;
+					}
+					setsCarry = true;
+					break;
+				default:
+					return false;
+			}
+			break;
+		case 0xF000:
+			switch (opcode & 0x00FF)
+			{
+				/* LD Vx, DT */
+				case 0x07:
+					LANE_LOOP
+					for (int l = 0; l < LANES; ++l)
+						vx[l] = delayTimer[l];
+					break;
+				/* LD DT, Vx */
+				case 0x15:
+					LANE_LOOP
+					for (int l = 0; l < LANES; ++l)
+						delayTimer[l] = vx[l];
+					break;
+				/* LD ST, Vx */
+				case 0x18:
+					LANE_LOOP
+					for (int l = 0; l < LANES; ++l)
+						soundTimer[l] = vx[l];
+					break;
+				/* ADD I, Vx */
+				case 0x1E:
+					LANE_LOOP
+					for (int l = 0; l < LANES; ++l)
+						I[l] = static_cast<uint16_t>(I[l] + vx[l]);
+					break;
+				/* LD F, Vx */
+				case 0x29:
+					LANE_LOOP
+					for (int l = 0; l < LANES; ++l)
+						I[l] = static_cast<uint16_t>(machine::fontSetStartAddress + vx[l] * 5u);
+					break;
+				default:
+					return false;
+			}
+			break;
+		default:
+			return false;
+	}
+
+	if (setsCarry)
+	{
+		// Vx first, then VF, exactly like the scalar interpreter
+		LANE_LOOP
+		for (int l = 0; l < LANES; ++l)
+			vx[l] = result[l];
+		LANE_LOOP
+		for (int l = 0; l < LANES; ++l)
+			vf[l] = carry[l];
+	}
+	else if (clearsFlag)
+	{
+		LANE_LOOP
+		for (int l = 0; l < LANES; ++l)
+			vf[l] = 0;
+	}
+	LANE_LOOP
+	for (int l = 0; l < LANES; ++l)
+		pc[l] = next;
+	return true;
+}
+
+template <int LANES>
+void lockstepEngine<LANES>::stepLane(int lane)
+{
+	laneView<LANES> view = {
+		*this, lane, memory[lane], { &V[0][lane] }, I[lane], pc[lane], { &stack[0][lane] }, sp[lane],
+		delayTimer[lane], soundTimer[lane], screen[lane], draw_flag[lane], keypad[lane], { &faultTotals[0][lane] }, quirks
+	};
+
+	// Mirrors machine::fetchInstruction
+	if (view.pc > machine::addressMask - 1u) [[unlikely]]
+	{
+		view.faults.raise(FAULT_MEMORY_OUT_OF_RANGE, view.pc, 0);
+	}
+	const uint16_t opcode = (view.memory[view.pc & machine::addressMask] << 8u) | view.memory[(view.pc + 1u) & machine::addressMask];
+	view.pc += 2;
+	interpreter::executeOpcode(view, opcode);
+}
+
+template <int LANES>
+uint64_t lockstepEngine<LANES>::laneDigest(int lane) const
+{
+	// Same function as machine::digest, so lanes can be compared against it directly
+	return interpreter::stateDigest(memory[lane], laneColumn<const uint8_t, LANES>{ &V[0][lane] }, I[lane], pc[lane],
+		laneColumn<const uint16_t, LANES>{ &stack[0][lane] }, sp[lane], delayTimer[lane], soundTimer[lane], screen[lane]);
+}
+
+template <int LANES>
+void lockstepEngine<LANES>::packLaneScreen(int lane, uint8_t out[256]) const
+{
+	interpreter::packScreen(screen[lane], out);
+}
+
+template class lockstepEngine<8>;
+template class lockstepEngine<16>;
+template class lockstepEngine<32>;
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "fault.h"
+#include "quirkProfile.h"
+
+class machine;
+
+// Lane loops are plain counted loops over LANES; this just tells the compiler the
+// iterations are independent so it vectorizes them at whatever width the target allows.
+#if defined(__clang__)
+#define LANE_LOOP _Pragma("clang loop vectorize(enable)")
+#elif defined(__GNUC__)
+#define LANE_LOOP _Pragma("GCC ivdep")
+#elif defined(_MSC_VER)
+#define LANE_LOOP __pragma(loop(ivdep))
+#else
+#define LANE_LOOP
+#endif
+
+// Runs LANES copies of one ROM side by side. Registers, PC and timers are stored
+// struct-of-arrays (one row per register, one column per lane) so that while every
+// lane sits on the same PC with the same opcode, the common ALU/branch opcodes run
+// as a single loop across lanes. Anything else, or lanes that have diverged, goes
+// through the shared interpreter one lane at a time.
+//
+// Lane l behaves exactly like machine(seed + l): digests match bit for bit.
+// Instantiated for 8, 16 and 32 lanes.
+template <int LANES>
+class lockstepEngine
+{
+	static_assert(LANES > 0 && LANES <= 64, "lane count must be 1..64");
+
+public:
+	static constexpr int laneCount = LANES;
+
+	explicit lockstepEngine(unsigned int seed);
+
+	// Clears all lanes; RNG streams continue, as with machine::reset
+	void reset();
+	// Loads the same ROM into every lane; like machine::loadRom, an oversized ROM is
+	// truncated and only an empty one fails
+	bool loadRom(const std::string& filepath);
+	bool loadRom(const uint8_t* data, std::size_t size);
+
+	// Per-lane versions, for callers that restart lanes independently
+	void resetLane(int lane);
+	bool loadLaneRom(int lane, const uint8_t* data, std::size_t size);
+	// Copies guest state, keypad and RNG stream between a machine and one lane
+	// (fault counts stay where they are)
+	void loadLaneState(int lane, const machine& m);
+	void storeLaneState(int lane, machine& m) const;
+
+	// Executes `cycles` instructions on every lane
+	void runCycles(int cycles);
+	void tickTimers();
+
+	uint64_t laneDigest(int lane) const;
+	void packLaneScreen(int lane, uint8_t out[256]) const;
+	uint64_t laneFaults(int lane, faultType type) const { return faultTotals[type][lane]; }
+	uint8_t laneRandomByte(int lane) { return static_cast<uint8_t>(randByte[lane](randGen[lane])); }
+
+	// Interpreter variant shared by every lane
+	quirkProfile quirks;
+
+	// Steps taken on the vector path vs. lane by lane
+	uint64_t convergedSteps = 0;
+	uint64_t divergedSteps = 0;
+
+public:
+	// Struct-of-arrays guest registers: X[register][lane]
+	alignas(64) uint8_t V[16][LANES];
+	alignas(64) uint16_t stack[16][LANES];
+	alignas(64) uint16_t I[LANES];
+	alignas(64) uint16_t pc[LANES];
+	alignas(64) uint8_t sp[LANES];
+	alignas(64) uint8_t delayTimer[LANES];
+	alignas(64) uint8_t soundTimer[LANES];
+	bool draw_flag[LANES];
+
+	// Per-lane guest memory and I/O, lane-major
+	alignas(64) uint8_t memory[LANES][4096];
+	uint8_t screen[LANES][64][32];
+	uint8_t keypad[LANES][16];
+
+private:
+	void step();
+	bool stepConverged(uint16_t opcode);
+	void stepLane(int lane);
+
+	uint64_t faultTotals[FAULT_TYPE_COUNT][LANES];
+	std::default_random_engine randGen[LANES];
+	std::uniform_int_distribution<int> randByte[LANES];
+};
+
+extern template class lockstepEngine<8>;
+extern template class lockstepEngine<16>;
+extern template class lockstepEngine<32>;
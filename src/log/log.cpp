@@ -0,0 +1,2 @@
+#define LOGGER_IMPLEMENTATION
+#include "log/log.h"
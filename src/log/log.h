@@ -15,10 +15,15 @@
 	\%	print a percent sign.
  */
 
-#include <_windows.h>
+/*
+	Logging is asynchronous. The caller formats the message body into a slot of a
+	lock-free multi-producer ring and returns; a background thread adds the prefix
+	and flushes whole batches to the console and/or a log file. When the ring is
+	full the message is dropped and counted rather than blocking the caller.
+ */
 
 // __VA_OPT__ is meant to be C++20 standard, but standards are optional to businesses.
-#ifdef MINGW_BUILD
+#ifndef _MSC_VER
 	#define LOG(format, ...) log_log(LOG_LEVEL_INFO, __FILE__, __FUNCTION__, __LINE__, format __VA_OPT__(, ) __VA_ARGS__)
 	#define LOG_WARNING(format, ...) log_log(LOG_LEVEL_WARN, __FILE__, __FUNCTION__, __LINE__, format __VA_OPT__(, ) __VA_ARGS__)
 	#define LOG_ERROR(format, ...) log_log(LOG_LEVEL_ERROR, __FILE__, __FUNCTION__, __LINE__, format __VA_OPT__(, ) __VA_ARGS__)
@@ -38,8 +43,26 @@ typedef enum
 	LOG_LEVEL_FATAL
 } LogLevel;
 
+enum
+{
+	LOG_TARGET_CONSOLE = 1 << 0,
+	LOG_TARGET_FILE = 1 << 1
+};
+
 void log_log(LogLevel level, const char* file, const char* function, int line, const char* fmt, ...);
 
+// Selects where the background thread writes. filePath is only used with LOG_TARGET_FILE.
+void log_set_targets(int targets, const char* filePath);
+
+// Blocks until every message enqueued before the call has been written.
+void log_flush();
+
+// Flushes and stops the background thread. Later messages are written synchronously.
+void log_shutdown();
+
+// Messages dropped because the ring was full.
+unsigned long long log_dropped_count();
+
 #endif // LOGGER_H
 
 // =====================================================================================
@@ -51,19 +74,75 @@ void log_log(LogLevel level, const char* file, const char* function, int line, c
 #define STB_SPRINTF_IMPLEMENTATION
 #include "stb_sprintf.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+	#include <_windows.h>
+#else
+	#include <unistd.h>
+#endif
+
+static constexpr int LOG_RING_SIZE = 1024; // must be a power of two
+static constexpr int LOG_MESSAGE_SIZE = 480;
+static constexpr int LOG_BATCH_SIZE = 64 * 1024;
+
+struct log_slot
+{
+	std::atomic<size_t> sequence;
+	LogLevel level;
+	const char* file; // __FILE__ / __FUNCTION__ are static strings, so pointers are enough
+	const char* function;
+	int line;
+	int64_t timestampMs;
+	char message[LOG_MESSAGE_SIZE];
+};
+
 static struct
 {
-	HANDLE hConsole;		   // Handle to the console output
-	CRITICAL_SECTION crit_sec; // For thread-safe logging
-	volatile LONG initialized; // Atomic flag for one-time initialization
+	log_slot slots[LOG_RING_SIZE];
+	alignas(64) std::atomic<size_t> enqueuePos; // shared by producers
+	alignas(64) size_t dequeuePos;				  // owned by the background thread
+	std::atomic<size_t> writtenPos;				  // messages fully written, for log_flush
+	std::atomic<uint32_t> wake;					  // bumped by producers to wake the writer
+	std::atomic<unsigned long long> dropped;
+	std::atomic<bool> running;
+	std::atomic<bool> stopping;
+	std::once_flag started;
+	std::thread writer;
+	std::mutex outputLock; // guards targets/file and synchronous writes after shutdown
+	int targets = LOG_TARGET_CONSOLE;
+	FILE* file = nullptr;
+#ifdef _WIN32
+	HANDLE hConsole; // Handle to the console output
+#else
+	bool colorConsole;
+#endif
 } g_logger;
 
+#ifdef _WIN32
 static constexpr WORD LOG_COLORS[] = {
 	FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE,										// LOG_LEVEL_INFO  -> White
 	FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY,									// LOG_LEVEL_WARN  -> Bright Yellow
 	FOREGROUND_RED | FOREGROUND_INTENSITY,														// LOG_LEVEL_ERROR -> Bright Red
 	BACKGROUND_RED | FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE | FOREGROUND_INTENSITY // LOG_LEVEL_FATAL -> Bright White on Red BG
 };
+#else
+static const char* LOG_COLORS[] = {
+	"\x1b[0m",	   // LOG_LEVEL_INFO  -> Default
+	"\x1b[93m",	   // LOG_LEVEL_WARN  -> Bright Yellow
+	"\x1b[91m",	   // LOG_LEVEL_ERROR -> Bright Red
+	"\x1b[97;41m" // LOG_LEVEL_FATAL -> Bright White on Red BG
+};
+#endif
 
 static const char* LOG_LEVEL_STRINGS[] = {
 	"INFO", "WARN", "ERROR", "FATAL"
@@ -80,32 +159,32 @@ int fast_sprintf(char* dest, const char* fmt, ...)
 	return retValue;
 }
 
+static int64_t log_now_ms()
+{
+	using namespace std::chrono;
+	return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
 /**
- * @brief The core logging function that formats and prints messages.
+ * @brief Formats the prefix and body of one message into dest.
  *
- * @param level The log level (e.g., LOG_LEVEL_INFO).
- * @param file The source file name where the log was called.
- * @param line The line number in the source file.
- * @param fmt The format string (printf-style).
- * @param ... Variable arguments for the format string.
+ * @return Number of bytes written, including the trailing newline.
  */
-void log_log(LogLevel level, const char* file, const char* function, int line, const char* fmt, ...)
+static int log_format_line(char* dest, const log_slot& slot)
 {
-	if (InterlockedCompareExchange(&g_logger.initialized, 1, 0) == 0)
-	{
-		g_logger.hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-		InitializeCriticalSection(&g_logger.crit_sec);
-	}
+	char* current_pos = dest;
 
-	char buffer[4096];
-	char* current_pos = buffer;
-
-	SYSTEMTIME st;
-	GetLocalTime(&st);
-	current_pos += fast_sprintf(current_pos, "%02d:%02d:%02d.%03d ", st.wHour, st.wMinute, st.wSecond, st.wMilliseconds);
+	const time_t seconds = static_cast<time_t>(slot.timestampMs / 1000);
+	struct tm local;
+#ifdef _WIN32
+	localtime_s(&local, &seconds);
+#else
+	localtime_r(&seconds, &local);
+#endif
+	current_pos += fast_sprintf(current_pos, "%02d:%02d:%02d.%03d ", local.tm_hour, local.tm_min, local.tm_sec, static_cast<int>(slot.timestampMs % 1000));
 
-	const char* file_basename = file;
-	for (const char* p = file; *p; ++p)
+	const char* file_basename = slot.file;
+	for (const char* p = slot.file; *p; ++p)
 	{
 		if (*p == '\\' || *p == '/')
 		{
@@ -113,48 +192,297 @@ void log_log(LogLevel level, const char* file, const char* function, int line, c
 		}
 	}
 
-	current_pos += fast_sprintf(current_pos, "[%s] [%s:%s] [Line %d] ", LOG_LEVEL_STRINGS[level], file_basename, function, line);
+	current_pos += fast_sprintf(current_pos, "[%s] [%s:%s] [Line %d] %s\n", LOG_LEVEL_STRINGS[slot.level], file_basename, slot.function, slot.line, slot.message);
 
-	va_list args;
-	va_start(args, fmt);
-	// Use the v-variant here; passing `args` to a `...` function is UB
-	current_pos += fast_sprintf(current_pos, fmt, args);
-	va_end(args);
-
-	*current_pos++ = '\n';
-
-	EnterCriticalSection(&g_logger.crit_sec);
+	return static_cast<int>(current_pos - dest);
+}
 
+static void log_write_console(LogLevel level, const char* data, size_t size)
+{
+#ifdef _WIN32
 	SetConsoleTextAttribute(g_logger.hConsole, LOG_COLORS[level]);
 
-	DWORD to_write = (DWORD)(current_pos - buffer);
 	DWORD written = 0;
 
 	// If it's a real console, WriteConsoleA works; else, fall back to WriteFile
 	DWORD mode;
 	if (g_logger.hConsole != NULL && g_logger.hConsole != INVALID_HANDLE_VALUE && GetConsoleMode(g_logger.hConsole, &mode))
 	{
-		WriteConsoleA(g_logger.hConsole, buffer, to_write, &written, NULL);
+		WriteConsoleA(g_logger.hConsole, data, (DWORD)size, &written, NULL);
 	}
-#ifdef DEBUG_BUILD // IDE MODE
+	#ifdef DEBUG_BUILD // IDE MODE
 	else
 	{
 		HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
 		if (hOut != NULL && hOut != INVALID_HANDLE_VALUE)
 		{
-			WriteFile(hOut, buffer, to_write, &written, NULL);
+			WriteFile(hOut, data, (DWORD)size, &written, NULL);
 		}
 	}
-#endif
+	#endif
 
 	SetConsoleTextAttribute(g_logger.hConsole, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
+#else
+	if (g_logger.colorConsole)
+	{
+		// Colour codes bracket the whole run so a batch of one level is a single write.
+		// Callers hold outputLock, so one static buffer is enough.
+		static char colored[LOG_BATCH_SIZE + 32];
+		int length = fast_sprintf(colored, "%s", LOG_COLORS[level]);
+		memcpy(colored + length, data, size);
+		length += static_cast<int>(size);
+		length += fast_sprintf(colored + length, "%s", LOG_COLORS[LOG_LEVEL_INFO]);
+		data = colored;
+		size = static_cast<size_t>(length);
+	}
+
+	while (size > 0)
+	{
+		const ssize_t n = write(STDOUT_FILENO, data, size);
+		if (n <= 0)
+			break;
+		data += n;
+		size -= static_cast<size_t>(n);
+	}
+#endif
+}
+
+// Writes one run of same-level lines to every enabled target
+static void log_write_run(LogLevel level, const char* data, size_t size)
+{
+	if (size == 0)
+		return;
+
+	std::lock_guard<std::mutex> guard(g_logger.outputLock);
+	if (g_logger.targets & LOG_TARGET_CONSOLE)
+	{
+		log_write_console(level, data, size);
+	}
+	if ((g_logger.targets & LOG_TARGET_FILE) && g_logger.file)
+	{
+		fwrite(data, 1, size, g_logger.file);
+	}
+}
+
+static void log_writer_thread()
+{
+	static char batch[LOG_BATCH_SIZE];
+
+	while (true)
+	{
+		const uint32_t wakeValue = g_logger.wake.load(std::memory_order_acquire);
+
+		// Drain everything that is ready, grouping consecutive lines of the same level
+		size_t batchSize = 0;
+		LogLevel batchLevel = LOG_LEVEL_INFO;
+		bool wroteAny = false;
+		while (true)
+		{
+			log_slot& slot = g_logger.slots[g_logger.dequeuePos & (LOG_RING_SIZE - 1)];
+			if (slot.sequence.load(std::memory_order_acquire) != g_logger.dequeuePos + 1)
+				break;
+
+			if (batchSize > 0 && (slot.level != batchLevel || batchSize + LOG_MESSAGE_SIZE + 256 > LOG_BATCH_SIZE))
+			{
+				log_write_run(batchLevel, batch, batchSize);
+				batchSize = 0;
+			}
+			batchLevel = slot.level;
+			batchSize += static_cast<size_t>(log_format_line(batch + batchSize, slot));
+
+			slot.sequence.store(g_logger.dequeuePos + LOG_RING_SIZE, std::memory_order_release);
+			++g_logger.dequeuePos;
+			wroteAny = true;
+		}
+		log_write_run(batchLevel, batch, batchSize);
+
+		if (wroteAny)
+		{
+			if (g_logger.file)
+			{
+				std::lock_guard<std::mutex> guard(g_logger.outputLock);
+				fflush(g_logger.file);
+			}
+			g_logger.writtenPos.store(g_logger.dequeuePos, std::memory_order_release);
+			g_logger.writtenPos.notify_all();
+			continue;
+		}
+
+		if (g_logger.stopping.load(std::memory_order_acquire))
+			break;
+
+		// Sleep until a producer bumps the wake counter
+		g_logger.wake.wait(wakeValue, std::memory_order_acquire);
+	}
+}
+
+static void log_start()
+{
+	std::call_once(g_logger.started, [] {
+		for (size_t i = 0; i < LOG_RING_SIZE; ++i)
+		{
+			g_logger.slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+#ifdef _WIN32
+		g_logger.hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
+#else
+		g_logger.colorConsole = isatty(STDOUT_FILENO) != 0;
+#endif
+		g_logger.running.store(true, std::memory_order_release);
+		g_logger.writer = std::thread(log_writer_thread);
+		atexit(log_shutdown);
+	});
+}
+
+void log_set_targets(int targets, const char* filePath)
+{
+	std::lock_guard<std::mutex> guard(g_logger.outputLock);
+	if (g_logger.file)
+	{
+		fclose(g_logger.file);
+		g_logger.file = nullptr;
+	}
+	if ((targets & LOG_TARGET_FILE) && filePath)
+	{
+		g_logger.file = fopen(filePath, "ab");
+	}
+	g_logger.targets = targets;
+}
+
+void log_flush()
+{
+	if (!g_logger.running.load(std::memory_order_acquire))
+		return;
+
+	const size_t target = g_logger.enqueuePos.load(std::memory_order_acquire);
+	g_logger.wake.fetch_add(1, std::memory_order_release);
+	g_logger.wake.notify_one();
+
+	size_t written = g_logger.writtenPos.load(std::memory_order_acquire);
+	while (written < target)
+	{
+		g_logger.writtenPos.wait(written, std::memory_order_acquire);
+		written = g_logger.writtenPos.load(std::memory_order_acquire);
+	}
+}
+
+void log_shutdown()
+{
+	if (!g_logger.running.exchange(false, std::memory_order_acq_rel))
+		return;
+
+	g_logger.stopping.store(true, std::memory_order_release);
+	g_logger.wake.fetch_add(1, std::memory_order_release);
+	g_logger.wake.notify_one();
+	if (g_logger.writer.joinable())
+	{
+		g_logger.writer.join();
+	}
+
+	const unsigned long long dropped = g_logger.dropped.load(std::memory_order_relaxed);
+	if (dropped > 0)
+	{
+		char line[128];
+		const int length = fast_sprintf(line, "[WARN] Logger dropped %llu messages (ring full)\n", dropped);
+		log_write_run(LOG_LEVEL_WARN, line, static_cast<size_t>(length));
+	}
+
+	std::lock_guard<std::mutex> guard(g_logger.outputLock);
+	if (g_logger.file)
+	{
+		fclose(g_logger.file);
+		g_logger.file = nullptr;
+	}
+}
+
+unsigned long long log_dropped_count()
+{
+	return g_logger.dropped.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Formats the message body into the ring and wakes the writer thread.
+ *
+ * @param level The log level (e.g., LOG_LEVEL_INFO).
+ * @param file The source file name where the log was called.
+ * @param line The line number in the source file.
+ * @param fmt The format string (printf-style).
+ * @param ... Variable arguments for the format string.
+ */
+void log_log(LogLevel level, const char* file, const char* function, int line, const char* fmt, ...)
+{
+	log_start();
+
+	va_list args;
+
+	// After shutdown (e.g. from static destructors) fall back to a synchronous write
+	if (!g_logger.running.load(std::memory_order_acquire))
+	{
+		log_slot slot;
+		slot.level = level;
+		slot.file = file;
+		slot.function = function;
+		slot.line = line;
+		slot.timestampMs = log_now_ms();
+		va_start(args, fmt);
+		stbsp_vsnprintf(slot.message, LOG_MESSAGE_SIZE, fmt, args);
+		va_end(args);
+
+		char buffer[LOG_MESSAGE_SIZE + 256];
+		log_write_run(level, buffer, static_cast<size_t>(log_format_line(buffer, slot)));
+		if (level == LOG_LEVEL_FATAL)
+		{
+			exit(1);
+		}
+		return;
+	}
+
+	// Claim a slot (bounded MPMC ring, used here with a single consumer)
+	size_t pos = g_logger.enqueuePos.load(std::memory_order_relaxed);
+	log_slot* slot;
+	while (true)
+	{
+		slot = &g_logger.slots[pos & (LOG_RING_SIZE - 1)];
+		const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+		const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+		if (diff == 0)
+		{
+			if (g_logger.enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0)
+		{
+			// Ring is full: never block the caller
+			g_logger.dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else
+		{
+			pos = g_logger.enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	slot->level = level;
+	slot->file = file;
+	slot->function = function;
+	slot->line = line;
+	slot->timestampMs = log_now_ms();
+
+	va_start(args, fmt);
+	// Use the v-variant here; passing `args` to a `...` function is UB
+	stbsp_vsnprintf(slot->message, LOG_MESSAGE_SIZE, fmt, args);
+	va_end(args);
+
+	slot->sequence.store(pos + 1, std::memory_order_release);
 
-	LeaveCriticalSection(&g_logger.crit_sec);
+	g_logger.wake.fetch_add(1, std::memory_order_release);
+	g_logger.wake.notify_one();
 
 	if (level == LOG_LEVEL_FATAL)
 	{
-		ExitProcess(1);
+		log_shutdown();
+		exit(1);
 	}
 }
 
-#endif // LOGGER_IMPLEMENTATION
\ No newline at end of file
+#endif // LOGGER_IMPLEMENTATION
@@ -0,0 +1,242 @@
+#include "machine.h"
+#include "interpreter.h"
+#include "rom/romImage.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+machine::machine()
+	: machine(static_cast<unsigned int>(std::chrono::system_clock::now().time_since_epoch().count()))
+{
+}
+
+machine::machine(unsigned int seed)
+	: randGen(seed), randByte(0, 255)
+{
+	reset();
+}
+
+void machine::clearRegisters()
+{
+	pc = entryPoint; // Program counter starts at 0x200
+	I = 0;			 // Index register
+	sp = 0;			 // Stack pointer
+	draw_flag = false;
+	delayTimer = 0;
+	soundTimer = 0;
+
+	memset(V, 0, sizeof(V));
+	memset(stack, 0, sizeof(stack));
+
+	// resetting display and keypad
+	memset(screen, 0, sizeof(screen));
+	memset(keypad, 0, sizeof(keypad));
+
+	opcode_history.clear();
+	faults.reset();
+}
+
+void machine::reset()
+{
+	clearRegisters();
+
+	// Empty memory with the font set at its usual address
+	memset(memory, 0, sizeof(memory));
+	memcpy(memory + fontSetStartAddress, fontSet, sizeof(fontSet));
+
+	image.reset();
+	sharedWords = nullptr;
+	dirtyCodePages = 0;
+	rehash();
+}
+
+bool machine::restart()
+{
+	if (!image)
+		return false;
+	clearRegisters();
+	memcpy(memory, image->pristineMemory(), sizeof(memory));
+	sharedWords = image->opcodeWords();
+	dirtyCodePages = 0;
+#ifdef CHIP8_STATE_HASH
+	memoryHash = loadedMemoryHash;
+	screenHash = 0;
+#endif
+	return true;
+}
+
+bool machine::loadRom(const std::string& romFilepath)
+{
+	// romImage::load logs why a file could not be used
+	const std::shared_ptr<const romImage> rom = romImage::load(romFilepath);
+	if (!rom || !loadRom(rom))
+		return false;
+	LOG("Loaded ROM: %s (%zu bytes)", romFilepath.c_str(), rom->size());
+	return true;
+}
+
+bool machine::loadRom(const uint8_t* data, std::size_t size)
+{
+	if (!interpreter::copyRom(memory, data, size))
+		return false;
+	sharedWords = nullptr;
+	image.reset();
+	rehash();
+	return true;
+}
+
+bool machine::loadRom(const std::shared_ptr<const romImage>& rom)
+{
+	if (!rom)
+	{
+		return false;
+	}
+	const std::size_t capacity = sizeof(memory) - static_cast<std::size_t>(entryPoint);
+	if (rom->size() > capacity)
+	{
+		LOG_ERROR("ROM truncated: %zu bytes didn't fit", rom->size() - capacity);
+	}
+	memcpy(memory, rom->pristineMemory(), sizeof(memory));
+
+	// The words describe reset state plus this ROM; anything else in memory means they don't apply
+	image = rom;
+	sharedWords = rom->opcodeWords();
+	dirtyCodePages = 0;
+	rehash();
+#ifdef CHIP8_STATE_HASH
+	loadedMemoryHash = memoryHash;
+#endif
+	return true;
+}
+
+int machine::runCycles(int cycles)
+{
+	for (int i = 0; i < cycles; ++i)
+	{
+		uint16_t opcode = fetchInstruction();
+
+		pc += 2; // Move to the next instruction
+		executeInstruction(opcode);
+
+		if (faults.haltPending()) [[unlikely]]
+		{
+			return i + 1;
+		}
+	}
+	return cycles;
+}
+
+void machine::tickTimers()
+{
+	// Decrement the timers if they've been set
+	delayTimer -= (delayTimer > 0);
+	soundTimer -= (soundTimer > 0);
+}
+
+uint64_t machine::digest() const
+{
+	return interpreter::stateDigest(memory, V, I, pc, stack, sp, delayTimer, soundTimer, screen);
+}
+
+namespace
+{
+	uint64_t hashMemory(const uint8_t (&memory)[4096])
+	{
+		uint64_t hash = 0;
+		for (uint32_t address = 0; address < 4096; ++address)
+		{
+			hash ^= zobrist::key(zobrist::memorySlot + address, memory[address]);
+		}
+		return hash;
+	}
+
+	uint64_t hashScreen(const uint8_t (&screen)[64][32])
+	{
+		uint64_t hash = 0;
+		for (uint32_t x = 0; x < 64; ++x)
+		{
+			for (uint32_t y = 0; y < 32; ++y)
+			{
+				if (screen[x][y] & 1u)
+				{
+					hash ^= zobrist::key(zobrist::screenSlot + x * 32u + y, 1);
+				}
+			}
+		}
+		return hash;
+	}
+}
+
+uint64_t machine::stateHash() const
+{
+	uint64_t hash = 0;
+	uint32_t slot = zobrist::registerSlot;
+	auto mix = [&hash, &slot](uint8_t value) { hash ^= zobrist::key(slot++, value); };
+	for (uint8_t value : V)
+	{
+		mix(value);
+	}
+	mix(static_cast<uint8_t>(I));
+	mix(static_cast<uint8_t>(I >> 8));
+	mix(static_cast<uint8_t>(pc));
+	mix(static_cast<uint8_t>(pc >> 8));
+	for (uint16_t entry : stack)
+	{
+		mix(static_cast<uint8_t>(entry));
+		mix(static_cast<uint8_t>(entry >> 8));
+	}
+	mix(sp);
+	mix(delayTimer);
+	mix(soundTimer);
+
+#ifdef CHIP8_STATE_HASH
+	return hash ^ memoryHash ^ screenHash;
+#else
+	return hash ^ hashMemory(memory) ^ hashScreen(screen);
+#endif
+}
+
+void machine::rehash()
+{
+#ifdef CHIP8_STATE_HASH
+	memoryHash = hashMemory(memory);
+	screenHash = hashScreen(screen);
+#endif
+}
+
+void machine::clearScreen()
+{
+	memset(screen, 0, sizeof(screen));
+#ifdef CHIP8_STATE_HASH
+	screenHash = 0;
+#endif
+}
+
+void machine::packScreen(uint8_t out[256]) const
+{
+	interpreter::packScreen(screen, out);
+}
+
+uint16_t machine::fetchInstruction()
+{
+	if (pc > addressMask - 1u) [[unlikely]]
+	{
+		faults.raise(FAULT_MEMORY_OUT_OF_RANGE, pc, 0);
+	}
+	// Both bytes are masked, so a PC at 0xFFF (or pushed past it by Bnnn) wraps to 0x000
+	const uint16_t at = pc & addressMask;
+	const uint16_t opcode = sharedWords && !((dirtyCodePages >> (at >> codePageShift)) & 1u)
+		? sharedWords[at]
+		: static_cast<uint16_t>((memory[at] << 8u) | memory[(at + 1u) & addressMask]);
+	if (recordHistory)
+	{
+		opcode_history.push_back(opcode);
+	}
+	return opcode;
+}
+
+void machine::executeInstruction(uint16_t opcode)
+{
+	interpreter::executeOpcode(*this, opcode);
+}
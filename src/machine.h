@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fault.h"
+#include "quirkProfile.h"
+#include "zobrist.h"
+
+class romImage;
+
+// The CHIP-8 interpreter core: guest state plus fetch/decode/execute.
+// Has no window, audio or input dependencies, so headless tools can run
+// as many instances as they like.
+class machine
+{
+public:
+	machine();
+	explicit machine(unsigned int seed);
+
+	// Clears all guest state and reloads the font; forgets the ROM
+	void reset();
+	// Back to the state right after the current ROM was loaded: one copy from the image's
+	// pristine memory plus a register clear, no file access. Quirks stay. False (and
+	// nothing changed) if the ROM was not loaded from a romImage.
+	bool restart();
+	// Maps the file through romImage, so restart() can return to it later.
+	// All loaders truncate a ROM too large for memory (and log it); an empty one fails.
+	bool loadRom(const std::string& filepath);
+	bool loadRom(const uint8_t* data, std::size_t size);
+	// Copies a shared image's pristine memory and fetches from its predecoded opcode
+	// words until the program writes to a code page
+	bool loadRom(const std::shared_ptr<const romImage>& image);
+
+	// Executes up to `cycles` instructions; stops early if a fault requested a halt.
+	// Returns the number of instructions executed.
+	int runCycles(int cycles);
+	// Decrements the delay and sound timers (once per 60 Hz frame)
+	void tickTimers();
+
+	uint16_t fetchInstruction();
+	void executeInstruction(uint16_t opcode);
+	uint8_t randomByte() { return static_cast<uint8_t>(randByte(randGen)); }
+
+	// 64-bit FNV-1a digest of all guest-visible state
+	uint64_t digest() const;
+	// Packs the 64x32 screen row-major, 8 pixels per byte, MSB first
+	void packScreen(uint8_t out[256]) const;
+
+	// Zobrist hash of the state digest() covers. Built with CHIP8_STATE_HASH, the memory
+	// and framebuffer parts are updated on every write and only the ~55 register bytes
+	// are folded in here, so it is O(1); otherwise the same value is computed from scratch.
+	uint64_t stateHash() const;
+	// Recomputes the incremental parts after state was changed outside the interpreter
+	void rehash();
+
+public:
+	uint8_t memory[4096];
+
+	// Guest addresses are masked into memory rather than bounds checked
+	static constexpr uint16_t addressMask = 0x0FFFu;
+
+	// General purpose registers (V0-VF)
+	uint8_t V[16];
+
+	// Index register
+	uint16_t I;
+
+	// Program counter
+	uint16_t pc;
+
+	// Stack for subroutine calls
+	uint16_t stack[16];
+
+	// Stack pointer, always within [0, stackDepth]
+	uint8_t sp;
+	static constexpr uint8_t stackDepth = 16;
+
+	// Delay timer
+	uint8_t delayTimer;
+
+	// Sound timer
+	uint8_t soundTimer;
+
+	// Graphics buffer (64x32 pixels)
+	uint8_t screen[64][32];
+
+	// Flag to indicate if the screen needs to be redrawn
+	bool draw_flag;
+
+	// Keypad state (hex-based input)
+	uint8_t keypad[16];
+	std::vector<uint16_t> opcode_history;
+	bool recordHistory = true; // headless runs turn this off
+
+	faultTracker faults;
+
+	// Interpreter variant; configuration rather than guest state, so reset() keeps it
+	quirkProfile quirks;
+
+	// Call after changing memory from outside the interpreter (restoring a snapshot,
+	// poking bytes from a tool); drops the shared opcode words for every page
+	void invalidateSharedCode() { dirtyCodePages = 0xFFFFu; }
+
+	// The image the current ROM came from; null after reset() or a raw-bytes load
+	const std::shared_ptr<const romImage>& loadedImage() const { return image; }
+
+	// RNG stream, so a restored state continues the same random sequence
+	const std::default_random_engine& randomEngine() const { return randGen; }
+	void setRandomEngine(const std::default_random_engine& engine) { randGen = engine; }
+
+	// Guest stores made by the interpreter
+	void writeMemory(uint16_t address, uint8_t value)
+	{
+#ifdef CHIP8_STATE_HASH
+		memoryHash ^= zobrist::key(zobrist::memorySlot + address, memory[address]) ^ zobrist::key(zobrist::memorySlot + address, value);
+#endif
+		memory[address] = value;
+		noteWrite(address);
+	}
+	void togglePixel(uint8_t x, uint8_t y)
+	{
+		screen[x][y] ^= 1;
+#ifdef CHIP8_STATE_HASH
+		screenHash ^= zobrist::key(zobrist::screenSlot + x * 32u + y, 1);
+#endif
+	}
+	void clearScreen();
+
+	// Called for every guest memory write. A written page (and the page before it,
+	// whose last word straddles the write) stops using the shared opcode words and
+	// is fetched from this instance's own memory from then on.
+	void noteWrite(uint16_t address)
+	{
+		dirtyCodePages |= static_cast<uint16_t>((1u << (address >> codePageShift)) | (1u << (((address - 1u) & addressMask) >> codePageShift)));
+	}
+
+	// Font set for CHIP-8, each character is 5x5 pixels
+	static constexpr uint8_t fontSet[80] = {
+		0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
+		0x20, 0x60, 0x20, 0x20, 0x70, // 1
+		0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
+		0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
+		0x90, 0x90, 0xF0, 0x10, 0x10, // 4
+		0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
+		0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
+		0xF0, 0x10, 0x20, 0x40, 0x40, // 7
+		0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
+		0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
+		0xF0, 0x90, 0xF0, 0x90, 0x90, // A
+		0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
+		0xF0, 0x80, 0x80, 0x80, 0xF0, // C
+		0xE0, 0x90, 0x90, 0x90, 0xE0, // D
+		0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
+		0xF0, 0x80, 0xF0, 0x80, 0x80  // F
+	};
+
+	// font start point
+	static constexpr unsigned int fontSetStartAddress = 0x50;
+
+	static constexpr int entryPoint = 0x200;
+
+protected:
+	// Registers, stack, timers, screen, keypad, history and fault counts; not memory
+	void clearRegisters();
+
+	// Shared predecoded opcode words for the loaded image, one per 256-byte page
+	static constexpr int codePageShift = 8;
+	std::shared_ptr<const romImage> image;
+	const uint16_t* sharedWords = nullptr;
+	uint16_t dirtyCodePages = 0;
+
+#ifdef CHIP8_STATE_HASH
+	uint64_t memoryHash = 0;
+	uint64_t screenHash = 0; // 0 for a blank screen
+	uint64_t loadedMemoryHash = 0; // memoryHash right after loadRom, for restart()
+#endif
+
+	std::default_random_engine randGen;
+	std::uniform_int_distribution<int> randByte;
+};
@@ -1,10 +1,18 @@
-
-#define LOGGER_IMPLEMENTATION
 #include "log/log.h"
 
 #include "chip8.h"
 #include "raylib.h"
 #include "gui.h"
+#include "options.h"
+#include "batch/batchRunner.h"
+#include "explore/explorer.h"
+#include "gen/romGenerator.h"
+#include "library/romLibrary.h"
+#include "quirks/quirkDetector.h"
+#include "verify/verifier.h"
+#include "trace/startup.h"
+#include "trace/trace.h"
+
 using namespace std;
 
 bool showDebugWindow = false; // Toggle as needed
@@ -13,32 +21,141 @@ std::string selectedFile;
 
 chip8* chip8::instance = nullptr;
 
-int main()
+int main(int argc, char** argv)
 {
 	// Initialization
 	//--------------------------------------------------------------------------------------
-	InitAudioDevice();
+	trace::setThreadName("main");
+
+	launchOptions options;
+	if (!parseLaunchOptions(argc, argv, options))
+	{
+		printUsage();
+		log_shutdown();
+		return 2;
+	}
+	if (!options.logFile.empty())
+	{
+		log_set_targets(LOG_TARGET_CONSOLE | LOG_TARGET_FILE, options.logFile.c_str());
+	}
+	if (!options.tracePath.empty())
+	{
+		trace::setEnabled(true);
+	}
+
+	// Headless modes never touch the window, audio device or file dialogs
+	if (options.mode != MODE_GUI)
+	{
+		int exitCode = 0;
+		switch (options.mode)
+		{
+			case MODE_BATCH:
+				exitCode = runBatch(options.batch);
+				break;
+			case MODE_EXPLORE:
+				exitCode = runExplore(options.explore);
+				break;
+			case MODE_VERIFY:
+				exitCode = runVerify(options.verify);
+				break;
+			case MODE_GENERATE:
+				exitCode = runGenerate(options.generate);
+				break;
+			case MODE_DETECT_QUIRKS:
+				exitCode = runDetectQuirks(options.detectQuirks);
+				break;
+			case MODE_SCAN_LIBRARY:
+				exitCode = runLibraryScan(options.library);
+				break;
+			case MODE_BUILD_PACK:
+				exitCode = runBuildPack(options.pack);
+				break;
+			default:
+				break;
+		}
+		if (trace::isEnabled())
+		{
+			trace::dump(options.tracePath);
+		}
+		log_shutdown();
+		return exitCode;
+	}
+
+	startup::mark("options");
+
+	// Audio, file dialogs and ROM previews start on first use; see chip8::beepReady,
+	// fileDialog::open and chip8::libraryThumbnails
 	config cfg(64, 32, 20, 700);
 	chip8* chip8 = &chip8::Get(cfg);
+	chip8->faults.haltOnFault = options.haltOnFault;
+	chip8->quirks = options.quirks;
+	chip8->configuredQuirks = options.quirks;
+	chip8->autoQuirks = options.autoQuirks;
+	chip8->quirkDetection = options.detectQuirks;
+	if (!options.library.directories.empty())
+	{
+		chip8->library = std::make_unique<romLibrary>(options.library);
+		chip8->library->start();
+		chip8->thumbnailSettings = options.thumbnails;
+	}
+	if (!options.tracePath.empty())
+	{
+		chip8->tracePath = options.tracePath;
+	}
+	startup::mark("emulator");
+	chip8->session = options.session;
+	chip8->sessionResumable = sessionAvailable(options.session.path);
+	if (options.session.resume && !chip8->resumeSession())
+	{
+		LOG_WARNING("No session to resume in %s", options.session.path.c_str());
+	}
+	startup::mark("session");
+
 	InitWindow(cfg.chip8Width * cfg.windowScale, cfg.chip8Height * cfg.windowScale, cfg.name.c_str());
 
 	SetTargetFPS(60); // Set our game to run at 60 frames-per-second
+	startup::mark("window");
+	bool firstFrame = true;
 	//--------------------------------------------------------------------------------------
 	// chip8.load_rom("F:\\Git Projects\\Chip8-Emulator\\rom\\IBM Logo.ch8");
 
 	// Main game loop
 	while (!WindowShouldClose()) // Detect window close button or ESC key
 	{
+		TRACE_ZONE("frame");
+		chip8->metrics.beginFrame();
 		BeginDrawing();
 		chip8->run();
 		// debug window end
-		EndDrawing();
+		{
+			TRACE_ZONE("EndDrawing");
+			PERF_STAGE(chip8->metrics, STAGE_PRESENT);
+			EndDrawing();
+		}
+		chip8->guiInstance.afterFrame();
+		chip8->metrics.endFrame(chip8->disp.takeDrawCalls());
+		if (firstFrame)
+		{
+			startup::mark("first frame");
+			startup::report();
+			firstFrame = false;
+		}
+	}
+
+	if (trace::isEnabled())
+	{
+		trace::dump(chip8->tracePath);
 	}
 
 	// De-Initialization
 	//--------------------------------------------------------------------------------------
-	CloseAudioDevice();
+	chip8->saveSessionNow();
+	chip8->guiInstance.releaseThumbnails();
+	chip8->thumbnails.reset(); // drops previews still queued
+	chip8->library.reset();	   // stops a scan that is still running
+	chip8->releaseAudio();
 	CloseWindow(); // Close window and OpenGL context
+	log_shutdown();
 	//--------------------------------------------------------------------------------------
 	return 0;
 }
\ No newline at end of file
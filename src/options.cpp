@@ -0,0 +1,349 @@
+#include "options.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+void printUsage()
+{
+	printf(
+		"Usage: Chip8-Emulator [options]\n"
+		"  --trace <file>          record host trace zones from startup, write on exit\n"
+		"  --log-file <file>       mirror the log into a file\n"
+		"  --halt-on-fault         pause and open the debugger on the first guest fault\n"
+		"  --resume                continue the last session straight away, without the menu\n"
+		"  --session <file>        where the session is kept (default last-session.c8s)\n"
+		"  --session-interval <s>  seconds between saves while a ROM runs; 0 = only on exit (default 30)\n"
+		"\n"
+		"Batch mode (headless, no window or audio):\n"
+		"  --batch <input>         run every ROM under a directory, in a ROM pack, or listed in a manifest\n"
+		"  --report <file>         JSON report path (default batch-report.json)\n"
+		"  --frames <n>            frames per ROM when the manifest does not say (default 600)\n"
+		"  --cycles-per-frame <n>  instructions per frame (default 11)\n"
+		"  --jobs <n>              worker threads (default: all hardware threads)\n"
+		"  --numa                  pin workers round-robin to NUMA nodes, with machines in node-local\n"
+		"                          memory (batch, verify and explore; multi-socket hosts)\n"
+		"  --timeout-ms <n>        per-ROM wall-clock watchdog (default 30000)\n"
+		"  --seed <n>              RNG seed for Cxkk (default 1)\n"
+		"  --build-pack <input>    write a directory's or manifest's ROMs, frame counts and input\n"
+		"                          scripts into one memory-mapped ROM pack for --batch and --verify\n"
+		"  --pack-output <file>    ROM pack path (default corpus.c8pk)\n"
+		"\n"
+		"Exploration mode (headless; --report, --jobs, --seed and --cycles-per-frame also apply):\n"
+		"  --explore <rom>         Go-Explore style search; reports cells, screens and PC coverage\n"
+		"                          (default report explore-report.json)\n"
+		"  --rollouts <n>          restore-and-explore iterations (default 50000)\n"
+		"  --cell <screen|ram>     cell key: downsampled framebuffer or V/I registers (default screen)\n"
+		"  --baseline              also run random play with the same budget, for comparison\n"
+		"\n"
+		"Verification mode (headless; --report, --frames, --cycles-per-frame, --jobs and --seed also apply):\n"
+		"  --verify <dir|manifest> run the lockstep engine against the reference interpreter and\n"
+		"                          bisect the first divergence (default report verify-report.json)\n"
+		"  --granularity <g>       compare after every instruction, block or frame (default frame)\n"
+		"  --block-size <n>        instructions per block for --granularity block (default 64)\n"
+		"\n"
+		"Workload generation (--seed and --frames also apply):\n"
+		"  --generate <dir>        write synthetic ROMs, a batch manifest and fuzz seeds into <dir>\n"
+		"  --count <n>             number of ROMs (default 16)\n"
+		"  --mix <m>               alu, draw, memory, call or all (default all, cycling per ROM)\n"
+		"  --instructions <n>      loop body length, 1..400 (default 256)\n"
+		"  --iterations <n>        body repetitions before halting, 1..255 (default 200)\n"
+		"  --branch-density <f>    share of body slots that branch (default 0.1)\n"
+		"  --self-modify <f>       share of body slots that rewrite code (default 0)\n"
+		"\n"
+		"Quirks (--frames, --cycles-per-frame, --jobs and --seed also apply to detection):\n"
+		"  --quirks <q>            auto, default, or a comma-separated list of shift-vy, increment-i,\n"
+		"                          jump-vx, vf-reset, clip; auto detects per ROM when it is loaded\n"
+		"  --detect-quirks <rom>   run the ROM under every quirk combination, print the ranking and\n"
+		"                          cache the best profile (headless)\n"
+		"  --quirks-cache <file>   detection cache, keyed by ROM hash (default quirks-cache.txt)\n"
+		"\n"
+		"ROM library:\n"
+		"  --library <dir>         scan a directory for ROMs (repeatable); browse them from the main menu\n"
+		"  --rom-db <dir>          chip-8-database directory with programs.json and platforms.json, for\n"
+		"                          titles, recommended speed and quirks\n"
+		"  --library-index <file>  index kept between runs (default rom-library.idx)\n"
+		"  --thumbnails <dir>      preview cache, one file per ROM hash (default thumbnails)\n"
+		"  --thumbnail-frames <n>  frames run before the preview is taken (default 180)\n"
+		"  --scan-library          scan, write the index and exit (headless)\n");
+}
+
+bool parseLaunchOptions(int argc, char** argv, launchOptions& options)
+{
+	bool reportGiven = false;
+	bool framesGiven = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+
+		if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0)
+		{
+			printUsage();
+			exit(0);
+		}
+		else if (strcmp(arg, "--halt-on-fault") == 0)
+		{
+			options.haltOnFault = true;
+		}
+		else if (strcmp(arg, "--resume") == 0)
+		{
+			options.session.resume = true;
+		}
+		else if (strcmp(arg, "--scan-library") == 0)
+		{
+			options.mode = MODE_SCAN_LIBRARY;
+		}
+		else if (strcmp(arg, "--baseline") == 0)
+		{
+			options.explore.baseline = true;
+		}
+		else if (strcmp(arg, "--numa") == 0)
+		{
+			options.batch.numa = true;
+		}
+		else if (!hasValue)
+		{
+			LOG_ERROR("Missing value for %s", arg);
+			return false;
+		}
+		else if (strcmp(arg, "--trace") == 0)
+		{
+			options.tracePath = argv[++i];
+		}
+		else if (strcmp(arg, "--log-file") == 0)
+		{
+			options.logFile = argv[++i];
+		}
+		else if (strcmp(arg, "--session") == 0)
+		{
+			options.session.path = argv[++i];
+		}
+		else if (strcmp(arg, "--session-interval") == 0)
+		{
+			options.session.saveIntervalSeconds = atoi(argv[++i]);
+		}
+		else if (strcmp(arg, "--batch") == 0)
+		{
+			options.mode = MODE_BATCH;
+			options.batch.inputPath = argv[++i];
+		}
+		else if (strcmp(arg, "--build-pack") == 0)
+		{
+			options.mode = MODE_BUILD_PACK;
+			options.pack.inputPath = argv[++i];
+		}
+		else if (strcmp(arg, "--pack-output") == 0)
+		{
+			options.pack.outputPath = argv[++i];
+		}
+		else if (strcmp(arg, "--report") == 0)
+		{
+			options.batch.reportPath = argv[++i];
+			reportGiven = true;
+		}
+		else if (strcmp(arg, "--frames") == 0)
+		{
+			options.batch.defaultFrames = atoi(argv[++i]);
+			framesGiven = true;
+		}
+		else if (strcmp(arg, "--cycles-per-frame") == 0)
+		{
+			options.batch.cyclesPerFrame = atoi(argv[++i]);
+		}
+		else if (strcmp(arg, "--jobs") == 0)
+		{
+			options.batch.jobs = static_cast<unsigned int>(atoi(argv[++i]));
+		}
+		else if (strcmp(arg, "--timeout-ms") == 0)
+		{
+			options.batch.timeoutMs = atoi(argv[++i]);
+		}
+		else if (strcmp(arg, "--seed") == 0)
+		{
+			options.batch.seed = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 0));
+		}
+		else if (strcmp(arg, "--explore") == 0)
+		{
+			options.mode = MODE_EXPLORE;
+			options.explore.romPath = argv[++i];
+		}
+		else if (strcmp(arg, "--verify") == 0)
+		{
+			options.mode = MODE_VERIFY;
+			options.verify.inputPath = argv[++i];
+		}
+		else if (strcmp(arg, "--granularity") == 0)
+		{
+			const char* granularity = argv[++i];
+			if (strcmp(granularity, "instruction") == 0)
+			{
+				options.verify.granularity = VERIFY_INSTRUCTION;
+			}
+			else if (strcmp(granularity, "block") == 0)
+			{
+				options.verify.granularity = VERIFY_BLOCK;
+			}
+			else if (strcmp(granularity, "frame") == 0)
+			{
+				options.verify.granularity = VERIFY_FRAME;
+			}
+			else
+			{
+				LOG_ERROR("--granularity must be instruction, block or frame");
+				return false;
+			}
+		}
+		else if (strcmp(arg, "--block-size") == 0)
+		{
+			options.verify.blockSize = atoi(argv[++i]);
+		}
+		else if (strcmp(arg, "--generate") == 0)
+		{
+			options.mode = MODE_GENERATE;
+			options.generate.outputDir = argv[++i];
+		}
+		else if (strcmp(arg, "--count") == 0)
+		{
+			options.generate.count = atoi(argv[++i]);
+		}
+		else if (strcmp(arg, "--mix") == 0)
+		{
+			if (!parseWorkloadMix(argv[++i], options.generate.mix))
+			{
+				LOG_ERROR("--mix must be alu, draw, memory, call or all");
+				return false;
+			}
+		}
+		else if (strcmp(arg, "--instructions") == 0)
+		{
+			options.generate.rom.instructions = atoi(argv[++i]);
+		}
+		else if (strcmp(arg, "--iterations") == 0)
+		{
+			options.generate.rom.iterations = atoi(argv[++i]);
+		}
+		else if (strcmp(arg, "--branch-density") == 0)
+		{
+			options.generate.rom.branchDensity = atof(argv[++i]);
+		}
+		else if (strcmp(arg, "--self-modify") == 0)
+		{
+			options.generate.rom.selfModifyRate = atof(argv[++i]);
+		}
+		else if (strcmp(arg, "--quirks") == 0)
+		{
+			const char* quirks = argv[++i];
+			options.autoQuirks = strcmp(quirks, "auto") == 0;
+			if (!options.autoQuirks && !quirkProfile::parse(quirks, options.quirks))
+			{
+				LOG_ERROR("--quirks must be auto, default or a list of shift-vy, increment-i, jump-vx, vf-reset, clip");
+				return false;
+			}
+		}
+		else if (strcmp(arg, "--detect-quirks") == 0)
+		{
+			options.mode = MODE_DETECT_QUIRKS;
+			options.detectQuirks.romPath = argv[++i];
+		}
+		else if (strcmp(arg, "--quirks-cache") == 0)
+		{
+			options.detectQuirks.cachePath = argv[++i];
+		}
+		else if (strcmp(arg, "--library") == 0)
+		{
+			options.library.directories.push_back(argv[++i]);
+		}
+		else if (strcmp(arg, "--rom-db") == 0)
+		{
+			options.library.databaseDir = argv[++i];
+		}
+		else if (strcmp(arg, "--library-index") == 0)
+		{
+			options.library.indexPath = argv[++i];
+		}
+		else if (strcmp(arg, "--thumbnails") == 0)
+		{
+			options.thumbnails.directory = argv[++i];
+		}
+		else if (strcmp(arg, "--thumbnail-frames") == 0)
+		{
+			options.thumbnails.frames = atoi(argv[++i]);
+		}
+		else if (strcmp(arg, "--rollouts") == 0)
+		{
+			options.explore.rollouts = atoi(argv[++i]);
+		}
+		else if (strcmp(arg, "--cell") == 0)
+		{
+			const char* mode = argv[++i];
+			if (strcmp(mode, "screen") == 0)
+			{
+				options.explore.cellKey = CELL_SCREEN;
+			}
+			else if (strcmp(mode, "ram") == 0)
+			{
+				options.explore.cellKey = CELL_RAM;
+			}
+			else
+			{
+				LOG_ERROR("--cell must be screen or ram");
+				return false;
+			}
+		}
+		else
+		{
+			LOG_ERROR("Unknown argument: %s", arg);
+			return false;
+		}
+	}
+
+	// Headless options shared by batch, packing, exploration, verification, generation and quirk detection
+	options.explore.jobs = options.batch.jobs;
+	options.explore.numa = options.batch.numa;
+	options.explore.seed = options.batch.seed;
+	options.explore.cyclesPerFrame = options.batch.cyclesPerFrame;
+	options.verify.jobs = options.batch.jobs;
+	options.verify.numa = options.batch.numa;
+	options.verify.seed = options.batch.seed;
+	options.verify.cyclesPerFrame = options.batch.cyclesPerFrame;
+	options.verify.defaultFrames = options.batch.defaultFrames;
+	options.pack.defaultFrames = options.batch.defaultFrames;
+	options.generate.rom.seed = options.batch.seed;
+	options.generate.frames = options.batch.defaultFrames;
+	options.detectQuirks.jobs = options.batch.jobs;
+	options.detectQuirks.seed = options.batch.seed;
+	options.detectQuirks.cyclesPerFrame = options.batch.cyclesPerFrame;
+	// Previews of ROMs the database has no quirks for use the profile they will be opened with
+	options.thumbnails.quirks = options.quirks;
+	if (options.autoQuirks)
+	{
+		options.thumbnails.autoQuirksCache = options.detectQuirks.cachePath;
+	}
+	if (framesGiven)
+	{
+		options.detectQuirks.frames = options.batch.defaultFrames;
+	}
+	if (reportGiven)
+	{
+		options.explore.reportPath = options.batch.reportPath;
+		options.verify.reportPath = options.batch.reportPath;
+	}
+
+	if (options.batch.defaultFrames <= 0 || options.batch.cyclesPerFrame <= 0)
+	{
+		LOG_ERROR("--frames and --cycles-per-frame must be positive");
+		return false;
+	}
+	if (options.session.saveIntervalSeconds < 0)
+	{
+		LOG_ERROR("--session-interval must not be negative");
+		return false;
+	}
+	if (options.thumbnails.frames < 0)
+	{
+		LOG_ERROR("--thumbnail-frames must not be negative");
+		return false;
+	}
+	return true;
+}
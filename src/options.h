@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+
+#include "batch/batchRunner.h"
+#include "explore/explorer.h"
+#include "gen/romGenerator.h"
+#include "library/romLibrary.h"
+#include "library/thumbnailCache.h"
+#include "quirks/quirkDetector.h"
+#include "session/session.h"
+#include "verify/verifier.h"
+
+enum launchMode
+{
+	MODE_GUI = 0,
+	MODE_BATCH,
+	MODE_EXPLORE,
+	MODE_VERIFY,
+	MODE_GENERATE,
+	MODE_DETECT_QUIRKS,
+	MODE_SCAN_LIBRARY,
+	MODE_BUILD_PACK
+};
+
+struct launchOptions
+{
+	launchMode mode = MODE_GUI;
+	std::string tracePath; // empty = no capture from startup
+	std::string logFile;
+	bool haltOnFault = false;
+	batchOptions batch;
+	packOptions pack;
+	exploreOptions explore;
+	verifyOptions verify;
+	generateOptions generate;
+	quirkDetectOptions detectQuirks;
+	// GUI: profile applied to every ROM, or detected per ROM with --quirks auto
+	quirkProfile quirks;
+	bool autoQuirks = false;
+	libraryOptions library;
+	thumbnailOptions thumbnails;
+	sessionOptions session;
+};
+
+// Parses the command line; returns false (after logging why) on bad arguments
+bool parseLaunchOptions(int argc, char** argv, launchOptions& options);
+void printUsage();
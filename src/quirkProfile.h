@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+// Behaviours that differ between CHIP-8 interpreters. The defaults are what this
+// emulator has always done; each flag switches one opcode group to the other
+// common variant.
+struct quirkProfile
+{
+	bool shiftUsesVy = false;		   // 8xy6/8xyE shift Vy into Vx (COSMAC VIP) instead of shifting Vx
+	bool loadStoreIncrementsI = false; // Fx55/Fx65 leave I at I + x + 1
+	bool jumpUsesVx = false;		   // Bxnn jumps to xnn + Vx (CHIP-48/SUPER-CHIP) instead of nnn + V0
+	bool logicResetsVf = false;		   // 8xy1/8xy2/8xy3 clear VF
+	bool clipSprites = false;		   // sprites clip at the screen edge instead of wrapping
+
+	static constexpr int count = 5;
+	static constexpr int combinations = 1 << count;
+
+	uint8_t bits() const
+	{
+		return static_cast<uint8_t>(shiftUsesVy | loadStoreIncrementsI << 1 | jumpUsesVx << 2 | logicResetsVf << 3 | clipSprites << 4);
+	}
+
+	static quirkProfile fromBits(uint8_t bits)
+	{
+		quirkProfile q;
+		q.shiftUsesVy = bits & 1u;
+		q.loadStoreIncrementsI = bits & 2u;
+		q.jumpUsesVx = bits & 4u;
+		q.logicResetsVf = bits & 8u;
+		q.clipSprites = bits & 16u;
+		return q;
+	}
+
+	bool operator==(const quirkProfile& other) const { return bits() == other.bits(); }
+
+	// Flag names in bit order, as used by --quirks and the detection report
+	static const char* flagName(int bit)
+	{
+		static constexpr const char* names[count] = { "shift-vy", "increment-i", "jump-vx", "vf-reset", "clip" };
+		return bit >= 0 && bit < count ? names[bit] : "";
+	}
+
+	// Comma-separated flag names, or "default" when none are set
+	std::string describe() const
+	{
+		std::string text;
+		for (int bit = 0; bit < count; ++bit)
+		{
+			if (bits() & (1u << bit))
+			{
+				text += text.empty() ? "" : ",";
+				text += flagName(bit);
+			}
+		}
+		return text.empty() ? "default" : text;
+	}
+
+	// Inverse of describe(); false on an unknown name
+	static bool parse(const std::string& text, quirkProfile& profile)
+	{
+		uint8_t bits = 0;
+		std::size_t start = 0;
+		while (start <= text.size())
+		{
+			const std::size_t end = std::min(text.find(',', start), text.size());
+			const std::string name = text.substr(start, end - start);
+			bool known = name == "default" || name.empty();
+			for (int bit = 0; bit < count && !known; ++bit)
+			{
+				if (name == flagName(bit))
+				{
+					bits |= static_cast<uint8_t>(1u << bit);
+					known = true;
+				}
+			}
+			if (!known)
+				return false;
+			start = end + 1;
+		}
+		profile = fromBits(bits);
+		return true;
+	}
+};
@@ -0,0 +1,306 @@
+#include "quirks/quirkDetector.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+#include "arena/machineArena.h"
+#include "batch/threadPool.h"
+#include "machine.h"
+#include "rom/romImage.h"
+#include "snapshot/snapshot.h"
+#include "trace/trace.h"
+
+namespace
+{
+	// Every 20 frames: hold the next key for 10 frames, then release for 10, so Fx0A
+	// waits resolve and key-driven ROMs get some input across all 16 keys
+	void applyKeyPattern(int frame, uint8_t keypad[16])
+	{
+		memset(keypad, 0, 16);
+		if (frame % 20 < 10)
+		{
+			keypad[(frame / 20) % 16] = 1;
+		}
+	}
+
+	// Opcodes whose result depends on the quirk profile
+	bool quirkSensitive(uint16_t opcode)
+	{
+		switch (opcode & 0xF000)
+		{
+			case 0x8000:
+			{
+				const uint8_t op = opcode & 0x000F;
+				return op == 0x1 || op == 0x2 || op == 0x3 || op == 0x6 || op == 0xE;
+			}
+			case 0xB000:
+			case 0xD000:
+				return true;
+			case 0xF000:
+				return (opcode & 0x00FF) == 0x55 || (opcode & 0x00FF) == 0x65;
+			default:
+				return false;
+		}
+	}
+
+	uint64_t screenHash(const uint8_t packed[256])
+	{
+		uint64_t hash = 0xCBF29CE484222325ull;
+		for (int i = 0; i < 256; ++i)
+		{
+			hash = (hash ^ packed[i]) * 0x100000001B3ull;
+		}
+		return hash;
+	}
+
+	// Running totals for one profile; the shared prefix fills one in and every profile
+	// continues from a copy
+	struct runStats
+	{
+		std::unordered_set<uint64_t> screens;
+		uint64_t lastScreen = 0;
+		uint64_t lastState = 0;
+		int activeFrames = 0;
+		int stuckFrames = 0;
+	};
+
+	void endFrame(machine& m, runStats& stats)
+	{
+		m.tickTimers();
+		uint8_t packed[256];
+		m.packScreen(packed);
+		const uint64_t screen = screenHash(packed);
+		if (screen != stats.lastScreen)
+		{
+			++stats.activeFrames;
+			stats.screens.insert(screen);
+			stats.lastScreen = screen;
+		}
+		const uint64_t state = m.stateHash();
+		if (state == stats.lastState)
+		{
+			++stats.stuckFrames;
+		}
+		stats.lastState = state;
+	}
+
+	uint64_t totalFaults(const machine& m)
+	{
+		uint64_t total = 0;
+		for (int t = 0; t < FAULT_TYPE_COUNT; ++t)
+		{
+			total += m.faults.total(static_cast<faultType>(t));
+		}
+		return total;
+	}
+
+	int scoreRun(const quirkScore& s)
+	{
+		// Any fault is a strong sign of a wrong profile; after that, prefer the run that
+		// kept updating the screen and spent fewer frames spinning in place. Distinct
+		// screens are reported but not scored: clipping alone changes how many there are.
+		const int faultPenalty = s.faults ? 1000 + static_cast<int>(std::min<uint64_t>(s.faults, 1000)) : 0;
+		return s.activeFrames - s.stuckFrames / 2 - faultPenalty;
+	}
+}
+
+std::vector<quirkScore> detectQuirks(const std::shared_ptr<const romImage>& rom, const quirkDetectOptions& options)
+{
+	TRACE_ZONE("detectQuirks");
+
+	// The probe plus one machine per profile, contiguous and on separate cache lines
+	machineArena arena(quirkProfile::combinations + 1);
+
+	// Shared prefix: run with the default profile up to the first quirk-sensitive opcode
+	const machineArena::handle probe = arena.acquire(options.seed);
+	probe->recordHistory = false;
+	probe->faults.maxFirstLogsPerInterval = 0;
+	probe->loadRom(rom);
+	runStats prefixStats;
+	prefixStats.lastState = probe->stateHash();
+	int forkFrame = options.frames;
+	int forkCycle = 0;
+	for (int frame = 0; frame < options.frames && forkFrame == options.frames; ++frame)
+	{
+		applyKeyPattern(frame, probe->keypad);
+		for (int cycle = 0; cycle < options.cyclesPerFrame; ++cycle)
+		{
+			const uint16_t pc = probe->pc & machine::addressMask;
+			const uint16_t next = static_cast<uint16_t>(probe->memory[pc] << 8u | probe->memory[(pc + 1u) & machine::addressMask]);
+			if (quirkSensitive(next))
+			{
+				forkFrame = frame;
+				forkCycle = cycle;
+				break;
+			}
+			probe->runCycles(1);
+		}
+		if (forkFrame == options.frames)
+		{
+			endFrame(*probe, prefixStats);
+		}
+	}
+	const uint64_t prefixFaults = totalFaults(*probe);
+
+	pageStore store;
+	const snapshot fork = snapshot::capture(store, *probe);
+
+	std::vector<quirkScore> scores(quirkProfile::combinations);
+	// Created here: the arena is not synchronized, each task only uses its own slot
+	std::vector<machineArena::handle> machines;
+	for (std::size_t i = 0; i < scores.size(); ++i)
+	{
+		machines.push_back(arena.acquire(options.seed));
+	}
+	threadPool pool(std::min<unsigned int>(options.jobs, quirkProfile::combinations), "quirks");
+	pool.parallelFor(scores.size(), [&](std::size_t i) {
+		machine* m = machines[i].get();
+		m->recordHistory = false;
+		m->faults.maxFirstLogsPerInterval = 0;
+		m->loadRom(rom);
+		fork.restore(*m);
+		m->invalidateSharedCode();
+		m->quirks = quirkProfile::fromBits(static_cast<uint8_t>(i));
+
+		runStats stats = prefixStats;
+		for (int frame = forkFrame; frame < options.frames; ++frame)
+		{
+			applyKeyPattern(frame, m->keypad);
+			m->runCycles(frame == forkFrame ? options.cyclesPerFrame - forkCycle : options.cyclesPerFrame);
+			endFrame(*m, stats);
+		}
+
+		quirkScore& s = scores[i];
+		s.profile = m->quirks;
+		s.faults = prefixFaults + totalFaults(*m);
+		s.distinctScreens = static_cast<int>(stats.screens.size());
+		s.activeFrames = stats.activeFrames;
+		s.stuckFrames = stats.stuckFrames;
+		s.score = scoreRun(s);
+	});
+
+	std::sort(scores.begin(), scores.end(), [](const quirkScore& a, const quirkScore& b) {
+		if (a.score != b.score)
+			return a.score > b.score;
+		const int quirksA = std::popcount(a.profile.bits());
+		const int quirksB = std::popcount(b.profile.bits());
+		if (quirksA != quirksB)
+			return quirksA < quirksB;
+		return a.profile.bits() < b.profile.bits();
+	});
+	return scores;
+}
+
+bool lookupCachedQuirks(const std::string& cachePath, uint64_t romHash, quirkProfile& profile)
+{
+	std::ifstream file(cachePath);
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream fields(line);
+		std::string hash;
+		unsigned int bits = 0;
+		if (!(fields >> hash >> bits))
+			continue;
+		if (std::strtoull(hash.c_str(), nullptr, 16) == romHash && bits < quirkProfile::combinations)
+		{
+			profile = quirkProfile::fromBits(static_cast<uint8_t>(bits));
+			return true;
+		}
+	}
+	return false;
+}
+
+bool storeCachedQuirks(const std::string& cachePath, uint64_t romHash, const quirkScore& best)
+{
+	char entry[64];
+	snprintf(entry, sizeof(entry), "%016llx %u %d", static_cast<unsigned long long>(romHash), best.profile.bits(), best.score);
+
+	// Rewrite the file with this ROM's line replaced (or appended)
+	std::vector<std::string> lines;
+	{
+		std::ifstream file(cachePath);
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (line.compare(0, 16, entry, 16) != 0)
+			{
+				lines.push_back(line);
+			}
+		}
+	}
+	lines.push_back(entry);
+
+	FILE* out = fopen(cachePath.c_str(), "wb");
+	if (!out)
+	{
+		LOG_ERROR("Failed to write quirk cache: %s", cachePath.c_str());
+		return false;
+	}
+	for (const std::string& line : lines)
+	{
+		fprintf(out, "%s\n", line.c_str());
+	}
+	const bool ok = ferror(out) == 0;
+	fclose(out);
+	return ok;
+}
+
+quirkProfile resolveQuirks(const std::string& romPath, const quirkDetectOptions& options)
+{
+	const std::shared_ptr<const romImage> rom = romImage::load(romPath);
+	if (!rom)
+	{
+		return quirkProfile();
+	}
+	quirkProfile profile;
+	if (lookupCachedQuirks(options.cachePath, rom->hash(), profile))
+	{
+		LOG("Quirks for %s (cached): %s", romPath.c_str(), profile.describe().c_str());
+		return profile;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	const std::vector<quirkScore> scores = detectQuirks(rom, options);
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	LOG("Quirks for %s (detected in %.1f ms): %s", romPath.c_str(), ms, scores.front().profile.describe().c_str());
+	storeCachedQuirks(options.cachePath, rom->hash(), scores.front());
+	return scores.front().profile;
+}
+
+int runDetectQuirks(const quirkDetectOptions& options)
+{
+	if (options.frames <= 0 || options.cyclesPerFrame <= 0)
+	{
+		LOG_ERROR("--frames and --cycles-per-frame must be positive");
+		return 1;
+	}
+	const std::shared_ptr<const romImage> rom = romImage::load(options.romPath);
+	if (!rom)
+	{
+		return 1;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	const std::vector<quirkScore> scores = detectQuirks(rom, options);
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	printf("%s (%016llx): %d profiles x %d frames in %.1f ms\n", options.romPath.c_str(), static_cast<unsigned long long>(rom->hash()),
+		quirkProfile::combinations, options.frames, ms);
+	printf("  rank  score  faults  screens  active  stuck  profile\n");
+	for (std::size_t i = 0; i < scores.size(); ++i)
+	{
+		const quirkScore& s = scores[i];
+		printf("  %4zu  %5d  %6llu  %7d  %6d  %5d  %s\n", i + 1, s.score, static_cast<unsigned long long>(s.faults), s.distinctScreens,
+			s.activeFrames, s.stuckFrames, s.profile.describe().c_str());
+	}
+	printf("Recommended: --quirks %s\n", scores.front().profile.describe().c_str());
+
+	return storeCachedQuirks(options.cachePath, rom->hash(), scores.front()) ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "quirkProfile.h"
+
+class romImage;
+
+struct quirkDetectOptions
+{
+	std::string romPath;
+	std::string cachePath = "quirks-cache.txt";
+	int frames = 300;
+	int cyclesPerFrame = 700 / 60;
+	unsigned int jobs = 0; // 0 = one worker per hardware thread
+	unsigned int seed = 1;
+};
+
+// How one profile behaved over the detection run
+struct quirkScore
+{
+	quirkProfile profile;
+	int score = 0;
+	uint64_t faults = 0;
+	int distinctScreens = 0;
+	int activeFrames = 0; // frames whose framebuffer changed
+	int stuckFrames = 0;  // frames that ended in exactly the previous frame's state
+};
+
+// Runs the ROM under every quirk combination with a fixed key pattern and returns the
+// scores best first. Faults weigh most, then frames that changed the screen, less stuck
+// frames; ties go to the profile with fewer quirks, so ROMs that never reach a
+// quirk-sensitive opcode keep the default. Everything before the first such opcode is
+// run once and the profiles fork from a snapshot taken there.
+std::vector<quirkScore> detectQuirks(const std::shared_ptr<const romImage>& rom, const quirkDetectOptions& options);
+
+// Detection results keyed by ROM content hash, one "<hash> <profile bits> <score>" line each
+bool lookupCachedQuirks(const std::string& cachePath, uint64_t romHash, quirkProfile& profile);
+bool storeCachedQuirks(const std::string& cachePath, uint64_t romHash, const quirkScore& best);
+
+// Load-time entry point: the cached profile for this ROM, or a fresh detection
+// (which is then cached). Falls back to the default profile if the ROM cannot be read.
+quirkProfile resolveQuirks(const std::string& romPath, const quirkDetectOptions& options);
+
+// Entry point for --detect-quirks: prints the ranking and caches the winner.
+// Returns a process exit code.
+int runDetectQuirks(const quirkDetectOptions& options);
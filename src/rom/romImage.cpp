@@ -0,0 +1,276 @@
+#include "rom/romImage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+
+#include "machine.h"
+
+#ifdef _WIN32
+	#include <_windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace
+{
+	struct registry
+	{
+		std::mutex lock;
+		std::unordered_map<std::string, std::weak_ptr<const romImage>> byPath;
+		std::unordered_map<uint64_t, std::weak_ptr<const romImage>> byHash;
+		std::size_t sweepPathsAt = 64;
+		std::size_t sweepHashesAt = 64;
+	};
+
+	// Never destroyed: images held by other statics may outlive this file's statics
+	registry& getRegistry()
+	{
+		static registry* r = new registry();
+		return *r;
+	}
+
+	uint64_t fnv1a(const uint8_t* data, std::size_t size)
+	{
+		uint64_t hash = 0xCBF29CE484222325ull;
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			hash = (hash ^ data[i]) * 0x100000001B3ull;
+		}
+		return hash;
+	}
+
+	// Path key that changes when the file does, so an edited ROM is mapped afresh
+	std::string registryKey(const std::string& path)
+	{
+		std::error_code ec;
+		const std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+		const auto stamp = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+		return (ec ? path : canonical.string()) + '|' + std::to_string(stamp);
+	}
+
+	// Drops expired entries once a map has doubled since the last sweep, so the registry
+	// stays proportional to the images alive at amortised O(1) per insert
+	template <typename Map>
+	void sweepExpired(Map& map, std::size_t& sweepAt)
+	{
+		if (map.size() < sweepAt)
+			return;
+		std::erase_if(map, [](const auto& entry) { return entry.second.expired(); });
+		sweepAt = std::max<std::size_t>(64, map.size() * 2);
+	}
+
+	// Returns an already loaded image with identical contents, or registers this one.
+	// Called with the registry lock held.
+	std::shared_ptr<const romImage> dedupeByHash(registry& r, std::shared_ptr<const romImage> image)
+	{
+		std::weak_ptr<const romImage>& slot = r.byHash[image->hash()];
+		if (std::shared_ptr<const romImage> existing = slot.lock())
+		{
+			if (existing->size() == image->size() && memcmp(existing->data(), image->data(), image->size()) == 0)
+			{
+				return existing;
+			}
+		}
+		slot = image;
+		sweepExpired(r.byHash, r.sweepHashesAt);
+		return image;
+	}
+
+	std::shared_ptr<const romImage> lookup(const std::string& key)
+	{
+		registry& r = getRegistry();
+		std::lock_guard<std::mutex> guard(r.lock);
+		const auto found = r.byPath.find(key);
+		return found != r.byPath.end() ? found->second.lock() : nullptr;
+	}
+}
+
+std::shared_ptr<const romImage> romImage::load(const std::string& path)
+{
+	return open(path, false);
+}
+
+std::shared_ptr<const romImage> romImage::map(const std::string& path)
+{
+	return open(path, true);
+}
+
+std::shared_ptr<const romImage> romImage::open(const std::string& path, bool mapped)
+{
+	const std::string key = registryKey(path) + (mapped ? "|mapped" : "");
+	if (std::shared_ptr<const romImage> cached = lookup(key))
+	{
+		return cached;
+	}
+
+	std::shared_ptr<romImage> image(new romImage());
+	if (mapped)
+	{
+		image->mapFile(path);
+	}
+
+	if (!image->bytes)
+	{
+		// Not mapped (a loose ROM, or an empty or special file): read it
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+		{
+			LOG_ERROR("Failed to open ROM: %s", path.c_str());
+			return nullptr;
+		}
+		image->owned.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		if (image->owned.empty())
+		{
+			LOG_ERROR("ROM is empty: %s", path.c_str());
+			return nullptr;
+		}
+		image->bytes = image->owned.data();
+		image->length = image->owned.size();
+	}
+	image->contentHash = fnv1a(image->bytes, image->length);
+
+	registry& r = getRegistry();
+	std::lock_guard<std::mutex> guard(r.lock);
+	std::weak_ptr<const romImage>& slot = r.byPath[key];
+	if (std::shared_ptr<const romImage> raced = slot.lock())
+	{
+		return raced; // another thread loaded it meanwhile
+	}
+	std::shared_ptr<const romImage> shared = dedupeByHash(r, image);
+	slot = shared;
+	sweepExpired(r.byPath, r.sweepPathsAt);
+	return shared;
+}
+
+void romImage::mapFile(const std::string& path)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER fileSize;
+		if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+		{
+			HANDLE handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			void* address = handle ? MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+			if (address)
+			{
+				mapping = handle;
+				view = address;
+				bytes = static_cast<const uint8_t*>(address);
+				length = static_cast<std::size_t>(fileSize.QuadPart);
+			}
+			else if (handle)
+			{
+				CloseHandle(handle);
+			}
+		}
+		CloseHandle(file);
+	}
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd >= 0)
+	{
+		struct stat info;
+		if (fstat(fd, &info) == 0 && info.st_size > 0)
+		{
+			void* address = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (address != MAP_FAILED)
+			{
+				view = address;
+				bytes = static_cast<const uint8_t*>(address);
+				length = static_cast<std::size_t>(info.st_size);
+			}
+		}
+		close(fd);
+	}
+#endif
+}
+
+std::shared_ptr<const romImage> romImage::fromBytes(const uint8_t* data, std::size_t size)
+{
+	std::shared_ptr<romImage> image(new romImage());
+	image->owned.assign(data, data + size);
+	image->bytes = image->owned.data();
+	image->length = size;
+	image->contentHash = fnv1a(data, size);
+
+	registry& r = getRegistry();
+	std::lock_guard<std::mutex> guard(r.lock);
+	return dedupeByHash(r, image);
+}
+
+std::shared_ptr<const romImage> romImage::slice(
+	const std::shared_ptr<const romImage>& container, std::size_t offset, std::size_t size, uint64_t hash)
+{
+	if (!container || offset > container->size() || size > container->size() - offset || size == 0)
+		return nullptr;
+	std::shared_ptr<romImage> image(new romImage());
+	image->container = container;
+	image->bytes = container->data() + offset;
+	image->length = size;
+	image->contentHash = hash;
+	return image;
+}
+
+romImage::~romImage()
+{
+	unmap();
+}
+
+void romImage::unmap()
+{
+#ifdef _WIN32
+	if (view)
+	{
+		UnmapViewOfFile(view);
+	}
+	if (mapping)
+	{
+		CloseHandle(static_cast<HANDLE>(mapping));
+	}
+#else
+	if (view)
+	{
+		munmap(view, length);
+	}
+#endif
+	view = nullptr;
+	mapping = nullptr;
+}
+
+void romImage::buildLayout() const
+{
+	std::call_once(layoutBuilt, [this] {
+		// Zero-filled, font at 0x50, ROM at 0x200 (truncated to fit)
+		pristine = std::make_unique<uint8_t[]>(4096);
+		memcpy(pristine.get() + machine::fontSetStartAddress, machine::fontSet, sizeof(machine::fontSet));
+		const std::size_t capacity = 4096 - static_cast<std::size_t>(machine::entryPoint);
+		memcpy(pristine.get() + machine::entryPoint, bytes, length < capacity ? length : capacity);
+
+		words = std::make_unique<uint16_t[]>(4096);
+		for (uint16_t address = 0; address < 4096; ++address)
+		{
+			words[address] = static_cast<uint16_t>((pristine[address] << 8u) | pristine[(address + 1u) & machine::addressMask]);
+		}
+	});
+}
+
+const uint8_t* romImage::pristineMemory() const
+{
+	buildLayout();
+	return pristine.get();
+}
+
+const uint16_t* romImage::opcodeWords() const
+{
+	buildLayout();
+	return words.get();
+}
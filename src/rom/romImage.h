@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// An immutable ROM shared by every instance that runs it. Files are deduplicated by
+// path and by content hash, so a corpus that runs the same ROM hundreds of times holds
+// one copy. Lifetime is reference counted through shared_ptr; the registry only keeps
+// weak references and sweeps out expired ones as it grows.
+class romImage
+{
+public:
+	// Returns the shared image for a ROM file, reading it on first use. Null on failure.
+	// Loose ROMs are a few KB, so they are copied: a file truncated on disk later
+	// cannot fault a running machine.
+	static std::shared_ptr<const romImage> load(const std::string& path);
+	// As load(), but memory-maps the file read-only, for large containers (ROM packs)
+	// that are sliced rather than copied
+	static std::shared_ptr<const romImage> map(const std::string& path);
+	// Wraps bytes that did not come from a file (copied, not deduplicated by path)
+	static std::shared_ptr<const romImage> fromBytes(const uint8_t* data, std::size_t size);
+	// A view of `size` bytes inside another image (a ROM pack), sharing its mapping with
+	// no copy. Keeps the container alive; null if the range is out of bounds.
+	static std::shared_ptr<const romImage> slice(
+		const std::shared_ptr<const romImage>& container, std::size_t offset, std::size_t size, uint64_t hash);
+
+	~romImage();
+	romImage(const romImage&) = delete;
+	romImage& operator=(const romImage&) = delete;
+
+	const uint8_t* data() const { return bytes; }
+	std::size_t size() const { return length; }
+	// 64-bit FNV-1a of the contents
+	uint64_t hash() const { return contentHash; }
+
+	// Guest memory of a freshly loaded machine: zeroes, the font and the ROM (4096 bytes).
+	// Loading or restarting a machine is one copy of this.
+	const uint8_t* pristineMemory() const;
+	// Opcode word at every address of that memory (big-endian, wrapping at 0xFFF).
+	// Both are built once on first use and shared read-only by all instances.
+	const uint16_t* opcodeWords() const;
+
+private:
+	romImage() = default;
+	static std::shared_ptr<const romImage> open(const std::string& path, bool mapped);
+	void mapFile(const std::string& path);
+	void unmap();
+
+	const uint8_t* bytes = nullptr;
+	std::size_t length = 0;
+	uint64_t contentHash = 0;
+	std::vector<uint8_t> owned; // fallback storage when the file could not be mapped
+	void* mapping = nullptr;	// platform mapping handle, null when not mapped
+	void* view = nullptr;
+	std::shared_ptr<const romImage> container; // set for slices
+
+	void buildLayout() const;
+
+	mutable std::once_flag layoutBuilt;
+	mutable std::unique_ptr<uint8_t[]> pristine;
+	mutable std::unique_ptr<uint16_t[]> words;
+};
@@ -0,0 +1,255 @@
+#include "rom/romPack.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+#include "rom/romImage.h"
+
+namespace
+{
+	constexpr char packMagic[4] = { 'C', '8', 'P', 'K' };
+	constexpr std::size_t headerSize = 56;
+	constexpr std::size_t recordSize = 40;
+	constexpr std::size_t dataAlignment = 16;
+
+	uint64_t readLe(const uint8_t* p, int size)
+	{
+		uint64_t value = 0;
+		for (int i = 0; i < size; ++i)
+		{
+			value |= static_cast<uint64_t>(p[i]) << (i * 8);
+		}
+		return value;
+	}
+
+	void appendLe(std::string& out, uint64_t value, int size)
+	{
+		for (int i = 0; i < size; ++i)
+		{
+			out.push_back(static_cast<char>(value >> (i * 8)));
+		}
+	}
+
+	void pad(std::string& out, std::size_t alignment)
+	{
+		out.resize((out.size() + alignment - 1) / alignment * alignment, '\0');
+	}
+}
+
+bool romPack::isPack(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	char magic[4] = {};
+	return file.read(magic, sizeof(magic)) && memcmp(magic, packMagic, sizeof(magic)) == 0;
+}
+
+std::shared_ptr<const romPack> romPack::open(const std::string& path)
+{
+	std::shared_ptr<romPack> pack(new romPack());
+	pack->file = romImage::map(path);
+	if (!pack->file)
+		return nullptr;
+
+	const uint8_t* bytes = pack->file->data();
+	const std::size_t fileSize = pack->file->size();
+	if (fileSize < headerSize || memcmp(bytes, packMagic, sizeof(packMagic)) != 0)
+	{
+		LOG_ERROR("%s is not a ROM pack", path.c_str());
+		return nullptr;
+	}
+	if (readLe(bytes + 4, 4) != version)
+	{
+		LOG_ERROR("%s: unsupported ROM pack version %u", path.c_str(), static_cast<unsigned int>(readLe(bytes + 4, 4)));
+		return nullptr;
+	}
+	pack->count = static_cast<std::size_t>(readLe(bytes + 8, 4));
+	pack->indexOffset = readLe(bytes + 16, 8);
+	pack->namesOffset = readLe(bytes + 24, 8);
+	pack->metadataOffset = readLe(bytes + 32, 8);
+	pack->dataOffset = readLe(bytes + 40, 8);
+	const uint64_t declaredSize = readLe(bytes + 48, 8);
+
+	// Validate every range once here so the accessors can trust the records
+	bool valid = declaredSize == fileSize && pack->indexOffset >= headerSize && pack->indexOffset <= fileSize &&
+				 pack->count <= (fileSize - pack->indexOffset) / recordSize && pack->namesOffset <= fileSize &&
+				 pack->metadataOffset <= fileSize && pack->dataOffset <= fileSize;
+	for (std::size_t i = 0; valid && i < pack->count; ++i)
+	{
+		const record r = pack->readRecord(i);
+		valid = r.size > 0 && r.dataOffset <= fileSize - pack->dataOffset && r.size <= fileSize - pack->dataOffset - r.dataOffset &&
+				r.nameOffset <= fileSize - pack->namesOffset && r.nameLength <= fileSize - pack->namesOffset - r.nameOffset &&
+				r.metadataOffset <= fileSize - pack->metadataOffset &&
+				r.metadataLength <= fileSize - pack->metadataOffset - r.metadataOffset &&
+				(i == 0 || pack->readRecord(i - 1).hash <= r.hash);
+	}
+	if (!valid)
+	{
+		LOG_ERROR("%s: ROM pack is truncated or corrupt", path.c_str());
+		return nullptr;
+	}
+	return pack;
+}
+
+romPack::record romPack::readRecord(std::size_t index) const
+{
+	const uint8_t* p = file->data() + indexOffset + index * recordSize;
+	record r;
+	r.hash = readLe(p, 8);
+	r.dataOffset = readLe(p + 8, 8);
+	r.size = static_cast<uint32_t>(readLe(p + 16, 4));
+	r.nameOffset = static_cast<uint32_t>(readLe(p + 20, 4));
+	r.nameLength = static_cast<uint32_t>(readLe(p + 24, 4));
+	r.metadataOffset = static_cast<uint32_t>(readLe(p + 28, 4));
+	r.metadataLength = static_cast<uint32_t>(readLe(p + 32, 4));
+	return r;
+}
+
+uint64_t romPack::hash(std::size_t index) const
+{
+	return readLe(file->data() + indexOffset + index * recordSize, 8);
+}
+
+std::string_view romPack::name(std::size_t index) const
+{
+	const record r = readRecord(index);
+	return std::string_view(reinterpret_cast<const char*>(file->data() + namesOffset + r.nameOffset), r.nameLength);
+}
+
+std::string_view romPack::metadata(std::size_t index) const
+{
+	const record r = readRecord(index);
+	return std::string_view(reinterpret_cast<const char*>(file->data() + metadataOffset + r.metadataOffset), r.metadataLength);
+}
+
+std::shared_ptr<const romImage> romPack::image(std::size_t index) const
+{
+	const record r = readRecord(index);
+	return romImage::slice(file, static_cast<std::size_t>(dataOffset + r.dataOffset), r.size, r.hash);
+}
+
+std::size_t romPack::find(uint64_t contentHash) const
+{
+	std::size_t low = 0;
+	std::size_t high = count;
+	while (low < high)
+	{
+		const std::size_t mid = low + (high - low) / 2;
+		if (hash(mid) < contentHash)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low < count && hash(low) == contentHash ? low : count;
+}
+
+bool romPack::write(const std::string& path, const std::vector<source>& sources)
+{
+	// Index order: content hash, then name, so lookups can binary search
+	std::vector<std::size_t> order(sources.size());
+	for (std::size_t i = 0; i < order.size(); ++i)
+	{
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&sources](std::size_t a, std::size_t b) {
+		const uint64_t hashA = sources[a].image->hash();
+		const uint64_t hashB = sources[b].image->hash();
+		return hashA != hashB ? hashA < hashB : sources[a].name < sources[b].name;
+	});
+
+	std::string names;
+	std::string metadata;
+	std::string data;
+	std::string index;
+	// Identical images (same hash and bytes) share one copy in the data section
+	std::multimap<uint64_t, std::pair<const romImage*, uint64_t>> stored;
+	for (std::size_t i : order)
+	{
+		const source& s = sources[i];
+		const romImage& image = *s.image;
+		if (image.size() > UINT32_MAX || names.size() + s.name.size() > UINT32_MAX || metadata.size() + s.metadata.size() > UINT32_MAX)
+		{
+			LOG_ERROR("ROM pack too large at %s", s.name.c_str());
+			return false;
+		}
+
+		uint64_t offset = UINT64_MAX;
+		const auto range = stored.equal_range(image.hash());
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			const romImage& other = *it->second.first;
+			if (other.size() == image.size() && memcmp(other.data(), image.data(), image.size()) == 0)
+			{
+				offset = it->second.second;
+				break;
+			}
+		}
+		if (offset == UINT64_MAX)
+		{
+			pad(data, dataAlignment);
+			offset = data.size();
+			data.append(reinterpret_cast<const char*>(image.data()), image.size());
+			stored.emplace(image.hash(), std::make_pair(&image, offset));
+		}
+
+		appendLe(index, image.hash(), 8);
+		appendLe(index, offset, 8);
+		appendLe(index, image.size(), 4);
+		appendLe(index, names.size(), 4);
+		appendLe(index, s.name.size(), 4);
+		appendLe(index, metadata.size(), 4);
+		appendLe(index, s.metadata.size(), 4);
+		appendLe(index, 0, 4);
+		names += s.name;
+		metadata += s.metadata;
+	}
+
+	std::string out(headerSize, '\0');
+	const uint64_t indexAt = out.size();
+	out += index;
+	const uint64_t namesAt = out.size();
+	out += names;
+	const uint64_t metadataAt = out.size();
+	out += metadata;
+	pad(out, dataAlignment);
+	const uint64_t dataAt = out.size();
+	out += data;
+
+	std::string header;
+	header.append(packMagic, sizeof(packMagic));
+	appendLe(header, version, 4);
+	appendLe(header, sources.size(), 4);
+	appendLe(header, 0, 4);
+	appendLe(header, indexAt, 8);
+	appendLe(header, namesAt, 8);
+	appendLe(header, metadataAt, 8);
+	appendLe(header, dataAt, 8);
+	appendLe(header, out.size(), 8);
+	out.replace(0, headerSize, header);
+
+	// Write beside the target and rename, so readers never map half a pack
+	const std::string temporary = path + ".tmp";
+	FILE* file = fopen(temporary.c_str(), "wb");
+	if (!file)
+	{
+		LOG_ERROR("Failed to open %s", temporary.c_str());
+		return false;
+	}
+	const bool written = fwrite(out.data(), 1, out.size(), file) == out.size();
+	fclose(file);
+	std::error_code ec;
+	if (written)
+	{
+		std::filesystem::rename(temporary, path, ec);
+	}
+	if (!written || ec)
+	{
+		std::filesystem::remove(temporary, ec);
+		LOG_ERROR("Failed to write %s", path.c_str());
+		return false;
+	}
+	return true;
+}
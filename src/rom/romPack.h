@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class romImage;
+
+// Single-file ROM corpus. Opening tens of thousands of loose .ch8 files costs far more
+// in filesystem calls than in emulation, so a pack holds them in one mapped file:
+//
+//   header    "C8PK", version, entry count, section offsets, file size
+//   index     one 40-byte record per ROM, sorted by content hash: hash, data offset,
+//             size, name offset/length, metadata offset/length
+//   names     the ROMs' original relative paths
+//   metadata  optional per-ROM text (see batchRunner for the keys it reads)
+//   data      ROM images, 16-byte aligned; identical ROMs are stored once
+//
+// All integers are little-endian. The ROMs handed out by image() point into the mapping.
+class romPack
+{
+public:
+	static constexpr uint32_t version = 1;
+
+	// Maps and validates a pack; null (after logging why) if it is not a usable pack
+	static std::shared_ptr<const romPack> open(const std::string& path);
+	// True if the file starts with the pack magic
+	static bool isPack(const std::string& path);
+
+	std::size_t size() const { return count; }
+	uint64_t hash(std::size_t index) const;
+	std::string_view name(std::size_t index) const;
+	std::string_view metadata(std::size_t index) const;
+	// Zero-copy view of one ROM; keeps the pack mapped while it lives
+	std::shared_ptr<const romImage> image(std::size_t index) const;
+	// First entry with this content hash, or size() if there is none
+	std::size_t find(uint64_t contentHash) const;
+
+	struct source
+	{
+		std::string name;
+		std::shared_ptr<const romImage> image;
+		std::string metadata;
+	};
+	// Writes a pack from already loaded images
+	static bool write(const std::string& path, const std::vector<source>& sources);
+
+private:
+	struct record
+	{
+		uint64_t hash;
+		uint64_t dataOffset;
+		uint32_t size;
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		uint32_t metadataOffset;
+		uint32_t metadataLength;
+	};
+	record readRecord(std::size_t index) const;
+
+	std::shared_ptr<const romImage> file;
+	std::size_t count = 0;
+	uint64_t indexOffset = 0;
+	uint64_t namesOffset = 0;
+	uint64_t metadataOffset = 0;
+	uint64_t dataOffset = 0;
+};
@@ -0,0 +1,172 @@
+#include "session/session.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "machine.h"
+#include "rom/romImage.h"
+#include "trace/trace.h"
+#include "util/byteStream.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	constexpr uint32_t sessionMagic = 0x53523843u; // "C8RS"
+	constexpr uint32_t sessionVersion = 1;
+}
+
+bool saveSession(const std::string& path, const machine& m, const sessionInfo& info)
+{
+	TRACE_ZONE("saveSession");
+	const std::shared_ptr<const romImage>& rom = m.loadedImage();
+	if (path.empty() || !rom)
+		return false;
+
+	// Text is the only portable form of the engine's state
+	std::ostringstream engine;
+	engine << m.randomEngine();
+
+	byteWriter out;
+	out.u32(sessionMagic);
+	out.u32(sessionVersion);
+	out.u64(rom->hash());
+	out.u32(static_cast<uint32_t>(rom->size()));
+	out.u32(static_cast<uint32_t>(info.instructionsPerSecond));
+	out.u8(info.quirks.bits());
+	out.raw(m.V, sizeof(m.V));
+	out.u16(m.I);
+	out.u16(m.pc);
+	for (uint16_t entry : m.stack)
+	{
+		out.u16(entry);
+	}
+	out.u8(m.sp);
+	out.u8(m.delayTimer);
+	out.u8(m.soundTimer);
+	out.text(info.romPath);
+	out.text(engine.str());
+	out.raw(m.memory, sizeof(m.memory));
+	uint8_t packed[256];
+	m.packScreen(packed);
+	out.raw(packed, sizeof(packed));
+	out.raw(rom->data(), rom->size());
+
+	const std::string temporary = path + ".tmp";
+	FILE* file = fopen(temporary.c_str(), "wb");
+	if (!file)
+	{
+		LOG_ERROR("Session: cannot write %s", temporary.c_str());
+		return false;
+	}
+	const bool written = fwrite(out.bytes.data(), 1, out.bytes.size(), file) == out.bytes.size();
+	fclose(file);
+	std::error_code ec;
+	if (written)
+	{
+		fs::rename(temporary, path, ec);
+	}
+	if (!written || ec)
+	{
+		fs::remove(temporary, ec);
+		LOG_ERROR("Session: failed to write %s", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool loadSession(const std::string& path, machine& m, sessionInfo& info)
+{
+	TRACE_ZONE("loadSession");
+	if (!sessionAvailable(path))
+		return false;
+	const std::shared_ptr<const romImage> file = romImage::load(path);
+	if (!file)
+		return false;
+
+	byteReader in(file->data(), file->size());
+	if (in.u32() != sessionMagic || in.u32() != sessionVersion)
+	{
+		LOG_WARNING("Session: ignoring %s (not a current session file)", path.c_str());
+		return false;
+	}
+	const uint64_t romHash = in.u64();
+	const uint32_t romSize = in.u32();
+	sessionInfo loaded;
+	loaded.instructionsPerSecond = static_cast<int>(in.u32());
+	loaded.quirks = quirkProfile::fromBits(in.u8());
+
+	// Registers go to a scratch copy first, so a bad file leaves the machine untouched
+	uint8_t V[16] = {};
+	uint16_t stack[16] = {};
+	in.raw(V, sizeof(V));
+	const uint16_t I = in.u16();
+	const uint16_t pc = in.u16();
+	for (uint16_t& entry : stack)
+	{
+		entry = in.u16();
+	}
+	const uint8_t sp = in.u8();
+	const uint8_t delayTimer = in.u8();
+	const uint8_t soundTimer = in.u8();
+	loaded.romPath = in.text();
+	std::istringstream engineText(in.text());
+	uint8_t memory[4096] = {};
+	in.raw(memory, sizeof(memory));
+	uint8_t packed[256] = {};
+	in.raw(packed, sizeof(packed));
+	std::string romBytes(romSize <= 4096 ? romSize : 0, '\0');
+	in.raw(romBytes.data(), romBytes.size());
+
+	std::default_random_engine engine;
+	engineText >> engine;
+	const std::shared_ptr<const romImage> rom =
+		in.ok() && !romBytes.empty() ? romImage::fromBytes(reinterpret_cast<const uint8_t*>(romBytes.data()), romBytes.size()) : nullptr;
+	if (!in.ok() || !engineText || !rom || rom->hash() != romHash || sp > machine::stackDepth || loaded.instructionsPerSecond <= 0)
+	{
+		LOG_WARNING("Session: %s is truncated or corrupt", path.c_str());
+		return false;
+	}
+
+	m.reset();
+	m.quirks = loaded.quirks;
+	m.loadRom(rom);
+	memcpy(m.memory, memory, sizeof(memory));
+	// The guest may have rewritten its code since it was loaded
+	m.invalidateSharedCode();
+	memcpy(m.V, V, sizeof(V));
+	m.I = I;
+	m.pc = pc;
+	memcpy(m.stack, stack, sizeof(stack));
+	m.sp = sp;
+	m.delayTimer = delayTimer;
+	m.soundTimer = soundTimer;
+	m.setRandomEngine(engine);
+	for (int x = 0; x < 64; ++x)
+	{
+		for (int y = 0; y < 32; ++y)
+		{
+			m.screen[x][y] = (packed[y * 8 + x / 8] >> (7 - x % 8)) & 1u;
+		}
+	}
+	m.draw_flag = true;
+	m.rehash();
+
+	info = std::move(loaded);
+	return true;
+}
+
+bool sessionAvailable(const std::string& path)
+{
+	if (path.empty())
+		return false;
+	std::ifstream file(path, std::ios::binary);
+	uint8_t magic[4] = {};
+	if (!file.read(reinterpret_cast<char*>(magic), sizeof(magic)))
+		return false;
+	byteReader in(magic, sizeof(magic));
+	return in.u32() == sessionMagic;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+
+#include "quirkProfile.h"
+
+class machine;
+
+struct sessionOptions
+{
+	std::string path = "last-session.c8s"; // empty = never saved or offered
+	int saveIntervalSeconds = 30;		   // while a ROM runs; also saved on exit
+	bool resume = false;				   // --resume: skip the menu and continue straight away
+};
+
+// Settings that belong to the session rather than the guest
+struct sessionInfo
+{
+	std::string romPath;
+	int instructionsPerSecond = 0;
+	quirkProfile quirks;
+};
+
+// Quick resume. A session file holds the complete guest state (memory, registers,
+// timers, screen, RNG), the ROM itself and the settings it ran with, so resuming
+// needs neither the menu nor the original file:
+//
+//   "C8RS", version, ROM hash and size, speed, quirks, registers, stack, ROM path,
+//   RNG state, memory, packed screen, ROM bytes
+//
+// Files are written beside the target and renamed into place.
+bool saveSession(const std::string& path, const machine& m, const sessionInfo& info);
+// Maps the file and restores it into `m` (the ROM image becomes `m`'s loaded image,
+// so restart() works). False, leaving `m` alone, if the file is missing or invalid.
+bool loadSession(const std::string& path, machine& m, sessionInfo& info);
+// Cheap check for the menu: the file exists and starts with the session magic
+bool sessionAvailable(const std::string& path);
@@ -0,0 +1,72 @@
+#include "snapshot/pageStore.h"
+
+#include <cstring>
+
+pageStore::~pageStore()
+{
+	for (shard& s : shards)
+	{
+		for (auto& entry : s.byHash)
+		{
+			delete entry.second;
+		}
+	}
+}
+
+uint64_t pageStore::hashPage(const uint8_t* bytes)
+{
+	// FNV-1a over 64-bit words; pages are compared in full on a hash match
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (std::size_t i = 0; i < pageSize; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, bytes + i, sizeof(word));
+		hash = (hash ^ word) * 0x100000001B3ull;
+	}
+	return hash ^ (hash >> 29);
+}
+
+const pageStore::page* pageStore::intern(const uint8_t* bytes)
+{
+	const uint64_t hash = hashPage(bytes);
+	shard& s = shardFor(hash);
+	std::lock_guard<std::mutex> guard(s.lock);
+
+	auto range = s.byHash.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (memcmp(it->second->bytes, bytes, pageSize) == 0)
+		{
+			it->second->refs.fetch_add(1, std::memory_order_relaxed);
+			return it->second;
+		}
+	}
+
+	page* p = new page;
+	p->hash = hash;
+	p->refs.store(1, std::memory_order_relaxed);
+	memcpy(p->bytes, bytes, pageSize);
+	s.byHash.emplace(hash, p);
+	pages.fetch_add(1, std::memory_order_relaxed);
+	return p;
+}
+
+void pageStore::release(const page* p)
+{
+	shard& s = shardFor(p->hash);
+	std::lock_guard<std::mutex> guard(s.lock);
+	if (p->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+
+	auto range = s.byHash.equal_range(p->hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second == p)
+		{
+			s.byHash.erase(it);
+			break;
+		}
+	}
+	pages.fetch_sub(1, std::memory_order_relaxed);
+	delete p;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+// Content-addressed store of fixed-size pages. Identical pages are stored once and
+// reference counted, so memory scales with the number of distinct pages rather than
+// with the number of states that use them. Thread-safe.
+class pageStore
+{
+public:
+	static constexpr std::size_t pageSize = 256;
+
+	struct page
+	{
+		uint64_t hash;
+		mutable std::atomic<uint32_t> refs;
+		uint8_t bytes[pageSize];
+	};
+
+	pageStore() = default;
+	~pageStore();
+	pageStore(const pageStore&) = delete;
+	pageStore& operator=(const pageStore&) = delete;
+
+	// Returns the shared page holding these bytes, with one reference taken
+	const page* intern(const uint8_t* bytes);
+	// Adds a reference to a page the caller already holds
+	void retain(const page* p) const { p->refs.fetch_add(1, std::memory_order_relaxed); }
+	void release(const page* p);
+
+	std::size_t pageCount() const { return pages.load(std::memory_order_relaxed); }
+	std::size_t bytesUsed() const { return pageCount() * sizeof(page); }
+
+	static uint64_t hashPage(const uint8_t* bytes);
+
+private:
+	// Sharded by hash so concurrent searches rarely contend. Releases take the shard
+	// lock too, which keeps a page from being revived by intern() while it is freed.
+	static constexpr std::size_t shardCount = 64;
+	struct shard
+	{
+		std::mutex lock;
+		std::unordered_multimap<uint64_t, page*> byHash;
+	};
+
+	shard& shardFor(uint64_t hash) { return shards[hash & (shardCount - 1)]; }
+
+	shard shards[shardCount];
+	std::atomic<std::size_t> pages{ 0 };
+};
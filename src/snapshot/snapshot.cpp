@@ -0,0 +1,183 @@
+#include "snapshot/snapshot.h"
+
+#include <cstring>
+#include <utility>
+
+#include "machine.h"
+
+snapshot::snapshot(const snapshot& other)
+{
+	memcpy(V, other.V, sizeof(V));
+	I = other.I;
+	pc = other.pc;
+	memcpy(stack, other.stack, sizeof(stack));
+	sp = other.sp;
+	delayTimer = other.delayTimer;
+	soundTimer = other.soundTimer;
+	draw_flag = other.draw_flag;
+	memcpy(keypad, other.keypad, sizeof(keypad));
+	randGen = other.randGen;
+
+	store = other.store;
+	if (!store)
+		return;
+	for (int p = 0; p < memoryPages; ++p)
+	{
+		memory[p] = other.memory[p];
+		store->retain(memory[p]);
+	}
+	screen = other.screen;
+	store->retain(screen);
+}
+
+snapshot::snapshot(snapshot&& other) noexcept
+{
+	swap(other);
+}
+
+snapshot& snapshot::operator=(snapshot other) noexcept
+{
+	swap(other);
+	return *this;
+}
+
+snapshot::~snapshot()
+{
+	if (!store)
+		return;
+	for (const pageStore::page* p : memory)
+	{
+		store->release(p);
+	}
+	store->release(screen);
+}
+
+void snapshot::swap(snapshot& other) noexcept
+{
+	std::swap(V, other.V);
+	std::swap(I, other.I);
+	std::swap(pc, other.pc);
+	std::swap(stack, other.stack);
+	std::swap(sp, other.sp);
+	std::swap(delayTimer, other.delayTimer);
+	std::swap(soundTimer, other.soundTimer);
+	std::swap(draw_flag, other.draw_flag);
+	std::swap(keypad, other.keypad);
+	std::swap(randGen, other.randGen);
+	std::swap(store, other.store);
+	std::swap(memory, other.memory);
+	std::swap(screen, other.screen);
+}
+
+snapshot snapshot::capture(pageStore& store, const machine& m, const snapshot* parent)
+{
+	snapshot s;
+	memcpy(s.V, m.V, sizeof(s.V));
+	s.I = m.I;
+	s.pc = m.pc;
+	memcpy(s.stack, m.stack, sizeof(s.stack));
+	s.sp = m.sp;
+	s.delayTimer = m.delayTimer;
+	s.soundTimer = m.soundTimer;
+	s.draw_flag = m.draw_flag;
+	memcpy(s.keypad, m.keypad, sizeof(s.keypad));
+	s.randGen = m.randomEngine();
+
+	const bool shareParent = parent && parent->store == &store;
+	s.store = &store;
+	for (int p = 0; p < memoryPages; ++p)
+	{
+		const uint8_t* bytes = m.memory + p * pageStore::pageSize;
+		if (shareParent && memcmp(parent->memory[p]->bytes, bytes, pageStore::pageSize) == 0)
+		{
+			s.memory[p] = parent->memory[p];
+			store.retain(s.memory[p]);
+		}
+		else
+		{
+			s.memory[p] = store.intern(bytes);
+		}
+	}
+
+	uint8_t packed[pageStore::pageSize];
+	m.packScreen(packed);
+	if (shareParent && memcmp(parent->screen->bytes, packed, sizeof(packed)) == 0)
+	{
+		s.screen = parent->screen;
+		store.retain(s.screen);
+	}
+	else
+	{
+		s.screen = store.intern(packed);
+	}
+	return s;
+}
+
+void snapshot::restore(machine& m) const
+{
+	if (!store)
+		return;
+	memcpy(m.V, V, sizeof(V));
+	m.I = I;
+	m.pc = pc;
+	memcpy(m.stack, stack, sizeof(stack));
+	m.sp = sp;
+	m.delayTimer = delayTimer;
+	m.soundTimer = soundTimer;
+	m.draw_flag = draw_flag;
+	memcpy(m.keypad, keypad, sizeof(keypad));
+	m.setRandomEngine(randGen);
+
+	for (int p = 0; p < memoryPages; ++p)
+	{
+		memcpy(m.memory + p * pageStore::pageSize, memory[p]->bytes, pageStore::pageSize);
+	}
+	m.invalidateSharedCode();
+
+	// A blank screen (every fresh reset, most fuzz and search roots) is a single memset
+	static const uint8_t blank[pageStore::pageSize] = {};
+	if (memcmp(screen->bytes, blank, sizeof(blank)) == 0)
+	{
+		memset(m.screen, 0, sizeof(m.screen));
+	}
+	else
+	{
+		unpackScreen(m);
+	}
+	m.rehash();
+}
+
+void snapshot::unpackScreen(machine& m) const
+{
+	// Column-major to match screen[x][y], so the stores are sequential
+	for (int x = 0; x < 64; ++x)
+	{
+		const uint8_t* column = screen->bytes + x / 8;
+		const int shift = 7 - x % 8;
+		for (int y = 0; y < 32; ++y)
+		{
+			m.screen[x][y] = (column[y * 8] >> shift) & 1u;
+		}
+	}
+}
+
+uint8_t snapshot::readByte(uint16_t address) const
+{
+	address &= machine::addressMask;
+	return memory[address / pageStore::pageSize]->bytes[address % pageStore::pageSize];
+}
+
+void snapshot::writeByte(uint16_t address, uint8_t value)
+{
+	address &= machine::addressMask;
+	const pageStore::page*& slot = memory[address / pageStore::pageSize];
+	if (slot->bytes[address % pageStore::pageSize] == value)
+		return;
+
+	uint8_t copy[pageStore::pageSize];
+	memcpy(copy, slot->bytes, sizeof(copy));
+	copy[address % pageStore::pageSize] = value;
+	const pageStore::page* updated = store->intern(copy);
+	store->release(slot);
+	slot = updated;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+#include "snapshot/pageStore.h"
+
+class machine;
+
+// A machine state whose 4 KB memory (16 pages) and packed framebuffer (one page) are
+// references into a pageStore. Copying a snapshot copies 17 references, so branching
+// a search tree is cheap; writes copy only the page they touch.
+class snapshot
+{
+public:
+	static constexpr int memoryPages = 4096 / pageStore::pageSize;
+
+	snapshot() = default;
+	snapshot(const snapshot& other);
+	snapshot(snapshot&& other) noexcept;
+	snapshot& operator=(snapshot other) noexcept;
+	~snapshot();
+
+	// Captures a machine. Pages that still match `parent` are shared without hashing.
+	static snapshot capture(pageStore& store, const machine& m, const snapshot* parent = nullptr);
+	// Writes the state back into a machine (faults and history are left alone)
+	void restore(machine& m) const;
+
+	bool empty() const { return store == nullptr; }
+	uint8_t readByte(uint16_t address) const;
+	// Copy-on-write: the page is re-interned, other snapshots keep the old one
+	void writeByte(uint16_t address, uint8_t value);
+
+	// Registers and small state, stored inline
+	uint8_t V[16] = {};
+	uint16_t I = 0;
+	uint16_t pc = 0;
+	uint16_t stack[16] = {};
+	uint8_t sp = 0;
+	uint8_t delayTimer = 0;
+	uint8_t soundTimer = 0;
+	bool draw_flag = false;
+	uint8_t keypad[16] = {};
+	std::default_random_engine randGen;
+
+private:
+	void swap(snapshot& other) noexcept;
+	void unpackScreen(machine& m) const;
+
+	pageStore* store = nullptr;
+	const pageStore::page* memory[memoryPages] = {};
+	const pageStore::page* screen = nullptr; // 64x32, row-major, 8 pixels per byte
+};
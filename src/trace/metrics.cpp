@@ -0,0 +1,84 @@
+#include "trace/metrics.h"
+#include "trace/trace.h"
+
+void perfMetrics::beginFrame()
+{
+	const uint64_t now = trace::nowNs();
+	if (secondStartNs == 0)
+	{
+		secondStartNs = now;
+	}
+	frameStartNs = now;
+}
+
+void perfMetrics::endFrame(int drawCalls)
+{
+	const uint64_t now = trace::nowNs();
+	const uint64_t frameNs = now - frameStartNs;
+	const float ms = static_cast<float>(frameNs) / 1.0e6f;
+
+	// Retire the oldest frame from the rolling histogram and stage totals
+	const int slot = frameIndex;
+	if (frameNsHistory[slot] != 0)
+	{
+		--histogram[bucketFor(frameMs[slot])];
+		frameNsTotal -= frameNsHistory[slot];
+		for (int s = 0; s < STAGE_COUNT; ++s)
+		{
+			stageNsTotal[s] -= stageNsHistory[slot][s];
+		}
+	}
+
+	frameMs[slot] = ms;
+	frameNsHistory[slot] = frameNs;
+	++histogram[bucketFor(ms)];
+	frameNsTotal += frameNs;
+	for (int s = 0; s < STAGE_COUNT; ++s)
+	{
+		stageNsHistory[slot][s] = stageNsThisFrame[s];
+		stageNsTotal[s] += stageNsThisFrame[s];
+		stageNsThisFrame[s] = 0;
+	}
+	frameIndex = (frameIndex + 1) % historyFrames;
+
+	lastDrawCalls = drawCalls;
+
+	const uint64_t elapsed = now - secondStartNs;
+	if (elapsed >= 1000000000ull)
+	{
+		measuredIps = static_cast<double>(instructionsThisSecond) * 1.0e9 / static_cast<double>(elapsed);
+		instructionsThisSecond = 0;
+		secondStartNs = now;
+	}
+}
+
+float perfMetrics::averageFrameMs() const
+{
+	int frames = 0;
+	for (int i = 0; i < histogramBuckets; ++i)
+	{
+		frames += histogram[i];
+	}
+	return frames ? static_cast<float>(frameNsTotal) / 1.0e6f / frames : 0.0f;
+}
+
+float perfMetrics::stagePercent(perfStage stage) const
+{
+	return frameNsTotal ? 100.0f * static_cast<float>(stageNsTotal[stage]) / static_cast<float>(frameNsTotal) : 0.0f;
+}
+
+int perfMetrics::bucketFor(float ms)
+{
+	const int bucket = static_cast<int>(ms / histogramBucketMs);
+	return bucket < histogramBuckets ? bucket : histogramBuckets - 1;
+}
+
+perfMetrics::stageScope::stageScope(perfMetrics& metrics, perfStage stage)
+	: metrics(metrics), stage(stage), startNs(trace::nowNs())
+{
+}
+
+perfMetrics::stageScope::~stageScope()
+{
+	metrics.addStageTime(stage, trace::nowNs() - startNs);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+//
+// Always-on frame metrics for the performance HUD.
+// Collection is a handful of clock reads and integer adds per frame.
+//
+
+#include <cstddef>
+#include <cstdint>
+
+#include "trace/trace.h"
+
+enum perfStage
+{
+	STAGE_EMULATION = 0,
+	STAGE_RENDER,
+	STAGE_GUI,
+	STAGE_PRESENT, // EndDrawing, including the frame-rate wait
+	STAGE_COUNT
+};
+
+class perfMetrics
+{
+public:
+	static constexpr int historyFrames = 120;
+	static constexpr int histogramBuckets = 8;
+	static constexpr float histogramBucketMs = 4.0f; // last bucket collects everything slower
+
+	void beginFrame();
+	void endFrame(int drawCalls);
+	void addInstructions(uint32_t count) { instructionsThisSecond += count; }
+	void addStageTime(perfStage stage, uint64_t ns) { stageNsThisFrame[stage] += ns; }
+
+	// Emulated instructions per second measured over the last full second
+	double instructionsPerSecond() const { return measuredIps; }
+	float lastFrameMs() const { return frameMs[(frameIndex + historyFrames - 1) % historyFrames]; }
+	float averageFrameMs() const;
+	float frameMsAt(int i) const { return frameMs[(frameIndex + i) % historyFrames]; } // oldest first
+	int histogramCount(int bucket) const { return histogram[bucket]; }
+	// Share of frame time spent in a stage, averaged over the frame history
+	float stagePercent(perfStage stage) const;
+	int drawCallsLastFrame() const { return lastDrawCalls; }
+
+	class stageScope
+	{
+	public:
+		stageScope(perfMetrics& metrics, perfStage stage);
+		~stageScope();
+
+		stageScope(const stageScope&) = delete;
+		stageScope& operator=(const stageScope&) = delete;
+
+	private:
+		perfMetrics& metrics;
+		perfStage stage;
+		uint64_t startNs;
+	};
+
+private:
+	uint64_t frameStartNs = 0;
+	uint64_t secondStartNs = 0;
+	uint64_t instructionsThisSecond = 0;
+	double measuredIps = 0.0;
+
+	float frameMs[historyFrames] = {};
+	int frameIndex = 0;
+	int histogram[histogramBuckets] = {};
+
+	uint64_t stageNsThisFrame[STAGE_COUNT] = {};
+	uint64_t stageNsTotal[STAGE_COUNT] = {};
+	uint64_t frameNsTotal = 0;
+	uint64_t stageNsHistory[historyFrames][STAGE_COUNT] = {};
+	uint64_t frameNsHistory[historyFrames] = {};
+
+	int lastDrawCalls = 0;
+
+	static int bucketFor(float ms);
+};
+
+#define PERF_STAGE(metrics, stage) perfMetrics::stageScope TRACE_CONCAT(perfStage_, __LINE__)(metrics, stage)
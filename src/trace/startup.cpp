@@ -0,0 +1,65 @@
+#include "trace/startup.h"
+
+#include <string>
+
+#include "trace/trace.h"
+
+namespace startup
+{
+	namespace
+	{
+		struct stage
+		{
+			const char* name;
+			uint64_t startNs;
+			uint64_t durationNs;
+		};
+
+		constexpr int maxStages = 16;
+
+		// Taken during static initialisation, before main()
+		const uint64_t processStartNs = trace::nowNs();
+		stage stages[maxStages];
+		int stageCount = 0;
+		uint64_t lastMarkNs = processStartNs;
+
+		double toMs(uint64_t ns) { return static_cast<double>(ns) / 1.0e6; }
+	}
+
+	void mark(const char* name)
+	{
+		const uint64_t now = trace::nowNs();
+		if (stageCount < maxStages)
+		{
+			stages[stageCount++] = { name, lastMarkNs, now - lastMarkNs };
+		}
+		if (trace::isEnabled())
+		{
+			trace::record(name, lastMarkNs, now - lastMarkNs);
+		}
+		lastMarkNs = now;
+	}
+
+	void report()
+	{
+		std::string line;
+		for (int i = 0; i < stageCount; ++i)
+		{
+			char part[64];
+			snprintf(part, sizeof(part), "%s%s %.1f ms", i ? ", " : "", stages[i].name, toMs(stages[i].durationNs));
+			line += part;
+		}
+		LOG("Startup: %s (total %.1f ms)", line.c_str(), toMs(lastMarkNs - processStartNs));
+	}
+
+	void lateInit(const char* subsystem, uint64_t startNs)
+	{
+		const uint64_t now = trace::nowNs();
+		if (trace::isEnabled())
+		{
+			trace::record(subsystem, startNs, now - startNs);
+		}
+		LOG("Startup: %s initialised on first use in %.1f ms (%.1f s after launch)", subsystem, toMs(now - startNs),
+			toMs(startNs - processStartNs) / 1000.0);
+	}
+}
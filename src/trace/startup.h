@@ -0,0 +1,22 @@
+#pragma once
+
+//
+// Startup timeline. main() marks the end of each stage; report() logs them once the
+// first frame is up. Subsystems that start on first use (audio, file dialogs, ROM
+// previews) log their own line through lateInit(), so a slow device shows up either way.
+//
+
+#include <cstdint>
+
+namespace startup
+{
+	// Ends the stage running since the previous mark (or process start).
+	// `stage` must be a string literal; it is also recorded as a trace zone.
+	void mark(const char* stage);
+
+	// Logs every stage marked so far and the total since process start
+	void report();
+
+	// Logs a subsystem brought up after startup, begun at `startNs` (trace::nowNs())
+	void lateInit(const char* subsystem, uint64_t startNs);
+}
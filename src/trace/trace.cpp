@@ -0,0 +1,231 @@
+#include "trace/trace.h"
+#include "util/json.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace trace
+{
+	namespace detail
+	{
+		std::atomic<bool> enabled{ false };
+	}
+
+	namespace
+	{
+		// 32k zones per thread is several minutes of frames at 60 Hz
+		constexpr std::size_t ringCapacity = 1u << 15;
+
+		// Single-producer/single-consumer ring. The owning thread pushes, dump() pops.
+		struct threadRing
+		{
+			event events[ringCapacity];
+			std::atomic<std::size_t> head{ 0 }; // next slot to write (producer)
+			std::atomic<std::size_t> tail{ 0 }; // next slot to read (consumer)
+			std::atomic<uint64_t> dropped{ 0 };
+			std::atomic<const char*> threadName{ nullptr };
+			uint32_t tid = 0;
+			bool exited = false; // owner is gone; dropped once dump() has drained it
+		};
+
+		struct registry
+		{
+			std::mutex lock; // only taken on ring creation, thread exit and dump
+			std::vector<std::shared_ptr<threadRing>> rings;
+			uint32_t nextTid = 1;
+		};
+
+		registry& getRegistry()
+		{
+			static registry r;
+			return r;
+		}
+
+		// Set by setThreadName; copied into the ring if the thread ever records
+		thread_local const char* localName = nullptr;
+
+		// Owns the calling thread's ring, which is created by the first record() while
+		// capture is on. Threads that never record cost nothing, and a thread's ring goes
+		// away with it unless it still holds events for the next dump().
+		struct ringHandle
+		{
+			std::shared_ptr<threadRing> ring;
+
+			~ringHandle()
+			{
+				if (!ring)
+					return;
+				registry& r = getRegistry();
+				std::lock_guard<std::mutex> guard(r.lock);
+				if (ring->head.load(std::memory_order_acquire) != ring->tail.load(std::memory_order_relaxed))
+				{
+					ring->exited = true;
+					return;
+				}
+				r.rings.erase(std::remove(r.rings.begin(), r.rings.end(), ring), r.rings.end());
+			}
+		};
+
+		thread_local ringHandle localHandle;
+
+		threadRing* localRing(bool create)
+		{
+			if (!localHandle.ring && create)
+			{
+				auto ring = std::make_shared<threadRing>();
+				ring->threadName.store(localName, std::memory_order_relaxed);
+				registry& r = getRegistry();
+				std::lock_guard<std::mutex> guard(r.lock);
+				ring->tid = r.nextTid++;
+				r.rings.push_back(ring);
+				localHandle.ring = std::move(ring);
+			}
+			return localHandle.ring.get();
+		}
+	}
+
+	uint64_t nowNs()
+	{
+		const auto now = std::chrono::steady_clock::now().time_since_epoch();
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()) | 1u;
+	}
+
+	void setEnabled(bool enabled)
+	{
+		detail::enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	bool isEnabled()
+	{
+		return detail::enabled.load(std::memory_order_relaxed);
+	}
+
+	void setThreadName(const char* name)
+	{
+		localName = name;
+		if (threadRing* ring = localRing(false))
+		{
+			ring->threadName.store(name, std::memory_order_relaxed);
+		}
+	}
+
+	void record(const char* name, uint64_t startNs, uint64_t durationNs)
+	{
+		// A zone that straddles the end of a capture is not worth a ring
+		threadRing* ring = localRing(isEnabled());
+		if (!ring)
+			return;
+		const std::size_t head = ring->head.load(std::memory_order_relaxed);
+		const std::size_t tail = ring->tail.load(std::memory_order_acquire);
+		if (head - tail >= ringCapacity)
+		{
+			ring->dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		ring->events[head & (ringCapacity - 1)] = { name, startNs, durationNs };
+		ring->head.store(head + 1, std::memory_order_release);
+	}
+
+	bool dump(const std::string& path)
+	{
+		FILE* out = fopen(path.c_str(), "wb");
+		if (!out)
+		{
+			LOG_ERROR("Failed to open trace file: %s", path.c_str());
+			return false;
+		}
+
+		registry& r = getRegistry();
+		std::lock_guard<std::mutex> guard(r.lock);
+
+		// Drain first so timestamps can be made relative to the earliest zone
+		std::vector<std::pair<uint32_t, event>> drained;
+		for (const auto& ring : r.rings)
+		{
+			const std::size_t head = ring->head.load(std::memory_order_acquire);
+			std::size_t tail = ring->tail.load(std::memory_order_relaxed);
+			for (; tail != head; ++tail)
+			{
+				drained.emplace_back(ring->tid, ring->events[tail & (ringCapacity - 1)]);
+			}
+			ring->tail.store(tail, std::memory_order_release);
+		}
+
+		uint64_t baseNs = UINT64_MAX;
+		for (const auto& [tid, e] : drained)
+		{
+			baseNs = std::min(baseNs, e.startNs);
+		}
+
+		fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", out);
+		bool first = true;
+		for (const auto& ring : r.rings)
+		{
+			const char* name = ring->threadName.load(std::memory_order_relaxed);
+			if (!name)
+			{
+				continue;
+			}
+			fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", ring->tid);
+			writeJsonString(out, name);
+			fputs("}}", out);
+			first = false;
+		}
+
+		for (const auto& [tid, e] : drained)
+		{
+			// Trace-event timestamps are microseconds; keep sub-microsecond precision
+			fprintf(out, "%s{\"name\":", first ? "" : ",\n");
+			writeJsonString(out, e.name);
+			fprintf(out, ",\"cat\":\"host\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				tid, (e.startNs - baseNs) / 1000.0, e.durationNs / 1000.0);
+			first = false;
+		}
+		fputs("\n]}\n", out);
+
+		const bool ok = ferror(out) == 0;
+		fclose(out);
+
+		uint64_t dropped = 0;
+		for (const auto& ring : r.rings)
+		{
+			dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+		}
+		// Rings of threads that have exited are drained now
+		r.rings.erase(std::remove_if(r.rings.begin(), r.rings.end(), [](const auto& ring) { return ring->exited; }), r.rings.end());
+
+		if (ok)
+		{
+			LOG("Wrote %zu trace events to %s (%llu dropped)", drained.size(), path.c_str(), static_cast<unsigned long long>(dropped));
+		}
+		else
+		{
+			LOG_ERROR("Failed writing trace file: %s", path.c_str());
+		}
+		return ok;
+	}
+
+	uint64_t droppedEvents()
+	{
+		registry& r = getRegistry();
+		std::lock_guard<std::mutex> guard(r.lock);
+		uint64_t dropped = 0;
+		for (const auto& ring : r.rings)
+		{
+			dropped += ring->dropped.load(std::memory_order_relaxed);
+		}
+		return dropped;
+	}
+
+	std::size_t bufferBytes()
+	{
+		registry& r = getRegistry();
+		std::lock_guard<std::mutex> guard(r.lock);
+		return r.rings.size() * sizeof(threadRing);
+	}
+}
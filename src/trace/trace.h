@@ -0,0 +1,78 @@
+#pragma once
+
+//
+// Scoped host-side instrumentation zones.
+//
+// Each thread writes finished zones into its own single-producer ring, so recording
+// a zone is two clock reads and a couple of relaxed atomics. dump() drains every
+// ring into a Chrome trace-event JSON file that chrome://tracing and Perfetto open.
+//
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace trace
+{
+	struct event
+	{
+		const char* name; // must be a string literal (stored by pointer)
+		uint64_t startNs;
+		uint64_t durationNs;
+	};
+
+	// Monotonic clock in nanoseconds (never zero)
+	uint64_t nowNs();
+
+	// Capture toggle; zones are a single relaxed load while disabled
+	void setEnabled(bool enabled);
+	bool isEnabled();
+
+	// Names the calling thread in the exported trace; allocates nothing
+	void setThreadName(const char* name);
+
+	// Appends a finished zone to the calling thread's ring. The ring is created by the
+	// thread's first zone while capture is on, and freed once the thread has exited and
+	// its events have been dumped.
+	void record(const char* name, uint64_t startNs, uint64_t durationNs);
+
+	// Drains all thread rings into a trace-event JSON file
+	bool dump(const std::string& path);
+
+	// Events dropped because a ring was full since the last dump
+	uint64_t droppedEvents();
+
+	// Bytes reserved by all registered thread rings
+	std::size_t bufferBytes();
+
+	namespace detail
+	{
+		extern std::atomic<bool> enabled;
+	}
+
+	class scope
+	{
+	public:
+		explicit scope(const char* name)
+			: name(name), startNs(detail::enabled.load(std::memory_order_relaxed) ? nowNs() : 0) {}
+
+		~scope()
+		{
+			if (startNs != 0)
+			{
+				record(name, startNs, nowNs() - startNs);
+			}
+		}
+
+		scope(const scope&) = delete;
+		scope& operator=(const scope&) = delete;
+
+	private:
+		const char* name;
+		uint64_t startNs;
+	};
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(name) trace::scope TRACE_CONCAT(traceZone_, __LINE__)(name)
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Little-endian serialisation for the binary files the emulator keeps between runs
+// (library index, session). Strings are a u16 length and the bytes.
+class byteWriter
+{
+public:
+	void u8(uint8_t value) { bytes.push_back(static_cast<char>(value)); }
+	void u16(uint16_t value) { integer(value, 2); }
+	void u32(uint32_t value) { integer(value, 4); }
+	void u64(uint64_t value) { integer(value, 8); }
+	void raw(const void* data, std::size_t size) { bytes.append(static_cast<const char*>(data), size); }
+	void text(const std::string& value)
+	{
+		const std::size_t length = std::min<std::size_t>(value.size(), 0xFFFF);
+		u16(static_cast<uint16_t>(length));
+		raw(value.data(), length);
+	}
+
+	std::string bytes;
+
+private:
+	void integer(uint64_t value, int size)
+	{
+		for (int i = 0; i < size; ++i)
+		{
+			bytes.push_back(static_cast<char>(value >> (i * 8)));
+		}
+	}
+};
+
+// Bounds-checked reads; any overrun marks the whole input as unusable
+class byteReader
+{
+public:
+	byteReader(const void* data, std::size_t size) : bytes(static_cast<const uint8_t*>(data)), length(size) {}
+	explicit byteReader(const std::string& data) : byteReader(data.data(), data.size()) {}
+
+	uint8_t u8() { return static_cast<uint8_t>(integer(1)); }
+	uint16_t u16() { return static_cast<uint16_t>(integer(2)); }
+	uint32_t u32() { return static_cast<uint32_t>(integer(4)); }
+	uint64_t u64() { return integer(8); }
+	void raw(void* out, std::size_t size)
+	{
+		if (!take(size))
+			return;
+		memcpy(out, bytes + offset - size, size);
+	}
+	std::string text()
+	{
+		const std::size_t size = u16();
+		if (!take(size))
+			return std::string();
+		return std::string(reinterpret_cast<const char*>(bytes + offset - size), size);
+	}
+
+	bool ok() const { return !overrun; }
+
+private:
+	bool take(std::size_t size)
+	{
+		if (overrun || length - offset < size)
+		{
+			overrun = true;
+			return false;
+		}
+		offset += size;
+		return true;
+	}
+	uint64_t integer(int size)
+	{
+		if (!take(static_cast<std::size_t>(size)))
+			return 0;
+		uint64_t value = 0;
+		for (int i = 0; i < size; ++i)
+		{
+			value |= static_cast<uint64_t>(bytes[offset - size + i]) << (i * 8);
+		}
+		return value;
+	}
+
+	const uint8_t* bytes;
+	std::size_t length;
+	std::size_t offset = 0;
+	bool overrun = false;
+};
@@ -0,0 +1,324 @@
+#include "util/json.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+	// Recursive descent over the raw buffer; depth is bounded so hostile files
+	// cannot exhaust the stack
+	class jsonParser
+	{
+	public:
+		jsonParser(const char* text, std::size_t size) : p(text), begin(text), end(text + size) {}
+
+		bool parseDocument(jsonValue& out)
+		{
+			skipSpace();
+			if (!parseValue(out, 0))
+				return false;
+			skipSpace();
+			return p == end;
+		}
+
+		std::size_t offset() const { return static_cast<std::size_t>(p - begin); }
+
+	private:
+		static constexpr int maxDepth = 256;
+
+		void skipSpace()
+		{
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+			{
+				++p;
+			}
+		}
+
+		bool literal(const char* word)
+		{
+			const std::size_t length = strlen(word);
+			if (static_cast<std::size_t>(end - p) < length || memcmp(p, word, length) != 0)
+				return false;
+			p += length;
+			return true;
+		}
+
+		bool parseValue(jsonValue& out, int depth)
+		{
+			if (p == end || depth > maxDepth)
+				return false;
+			switch (*p)
+			{
+				case '{':
+					return parseObject(out, depth);
+				case '[':
+					return parseArray(out, depth);
+				case '"':
+					out.type = jsonValue::JSON_STRING;
+					return parseString(out.string);
+				case 't':
+					out.type = jsonValue::JSON_BOOL;
+					out.boolean = true;
+					return literal("true");
+				case 'f':
+					out.type = jsonValue::JSON_BOOL;
+					out.boolean = false;
+					return literal("false");
+				case 'n':
+					out.type = jsonValue::JSON_NULL;
+					return literal("null");
+				default:
+					return parseNumber(out);
+			}
+		}
+
+		bool parseNumber(jsonValue& out)
+		{
+			// strtod needs a terminator; numbers are short, so copy into a local buffer
+			char buffer[64];
+			std::size_t length = 0;
+			while (p + length < end && length < sizeof(buffer) - 1 && strchr("+-0123456789.eE", p[length]) != nullptr)
+			{
+				buffer[length] = p[length];
+				++length;
+			}
+			if (length == 0)
+				return false;
+			buffer[length] = '\0';
+			char* parsedEnd = nullptr;
+			out.type = jsonValue::JSON_NUMBER;
+			out.number = strtod(buffer, &parsedEnd);
+			if (parsedEnd != buffer + length)
+				return false;
+			p += length;
+			return true;
+		}
+
+		static void appendUtf8(std::string& text, uint32_t codepoint)
+		{
+			if (codepoint < 0x80)
+			{
+				text += static_cast<char>(codepoint);
+			}
+			else if (codepoint < 0x800)
+			{
+				text += static_cast<char>(0xC0 | codepoint >> 6);
+				text += static_cast<char>(0x80 | (codepoint & 0x3F));
+			}
+			else if (codepoint < 0x10000)
+			{
+				text += static_cast<char>(0xE0 | codepoint >> 12);
+				text += static_cast<char>(0x80 | (codepoint >> 6 & 0x3F));
+				text += static_cast<char>(0x80 | (codepoint & 0x3F));
+			}
+			else
+			{
+				text += static_cast<char>(0xF0 | codepoint >> 18);
+				text += static_cast<char>(0x80 | (codepoint >> 12 & 0x3F));
+				text += static_cast<char>(0x80 | (codepoint >> 6 & 0x3F));
+				text += static_cast<char>(0x80 | (codepoint & 0x3F));
+			}
+		}
+
+		bool parseHex4(uint32_t& value)
+		{
+			if (end - p < 4)
+				return false;
+			value = 0;
+			for (int i = 0; i < 4; ++i)
+			{
+				const char c = *p++;
+				value <<= 4;
+				if (c >= '0' && c <= '9')
+					value |= static_cast<uint32_t>(c - '0');
+				else if (c >= 'a' && c <= 'f')
+					value |= static_cast<uint32_t>(c - 'a' + 10);
+				else if (c >= 'A' && c <= 'F')
+					value |= static_cast<uint32_t>(c - 'A' + 10);
+				else
+					return false;
+			}
+			return true;
+		}
+
+		bool parseString(std::string& out)
+		{
+			++p; // opening quote
+			out.clear();
+			while (p < end)
+			{
+				const char c = *p++;
+				if (c == '"')
+					return true;
+				if (c != '\\')
+				{
+					out += c;
+					continue;
+				}
+				if (p == end)
+					return false;
+				const char escape = *p++;
+				switch (escape)
+				{
+					case '"':
+					case '\\':
+					case '/':
+						out += escape;
+						break;
+					case 'b':
+						out += '\b';
+						break;
+					case 'f':
+						out += '\f';
+						break;
+					case 'n':
+						out += '\n';
+						break;
+					case 'r':
+						out += '\r';
+						break;
+					case 't':
+						out += '\t';
+						break;
+					case 'u':
+					{
+						uint32_t codepoint = 0;
+						if (!parseHex4(codepoint))
+							return false;
+						// Surrogate pair
+						if (codepoint >= 0xD800 && codepoint < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u')
+						{
+							p += 2;
+							uint32_t low = 0;
+							if (!parseHex4(low) || low < 0xDC00 || low >= 0xE000)
+								return false;
+							codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+						}
+						appendUtf8(out, codepoint);
+						break;
+					}
+					default:
+						return false;
+				}
+			}
+			return false;
+		}
+
+		bool parseArray(jsonValue& out, int depth)
+		{
+			++p;
+			out.type = jsonValue::JSON_ARRAY;
+			skipSpace();
+			if (p < end && *p == ']')
+			{
+				++p;
+				return true;
+			}
+			while (true)
+			{
+				out.items.emplace_back();
+				skipSpace();
+				if (!parseValue(out.items.back(), depth + 1))
+					return false;
+				skipSpace();
+				if (p == end)
+					return false;
+				if (*p == ']')
+				{
+					++p;
+					return true;
+				}
+				if (*p++ != ',')
+					return false;
+			}
+		}
+
+		bool parseObject(jsonValue& out, int depth)
+		{
+			++p;
+			out.type = jsonValue::JSON_OBJECT;
+			skipSpace();
+			if (p < end && *p == '}')
+			{
+				++p;
+				return true;
+			}
+			while (true)
+			{
+				skipSpace();
+				if (p == end || *p != '"')
+					return false;
+				out.members.emplace_back();
+				if (!parseString(out.members.back().first))
+					return false;
+				skipSpace();
+				if (p == end || *p++ != ':')
+					return false;
+				skipSpace();
+				if (!parseValue(out.members.back().second, depth + 1))
+					return false;
+				skipSpace();
+				if (p == end)
+					return false;
+				if (*p == '}')
+				{
+					++p;
+					return true;
+				}
+				if (*p++ != ',')
+					return false;
+			}
+		}
+
+		const char* p;
+		const char* begin;
+		const char* end;
+	};
+}
+
+const jsonValue* jsonValue::find(const char* key) const
+{
+	for (const auto& member : members)
+	{
+		if (member.first == key)
+			return &member.second;
+	}
+	return nullptr;
+}
+
+bool parseJson(const char* text, std::size_t size, jsonValue& out, std::size_t* errorOffset)
+{
+	// Tolerate a UTF-8 byte order mark
+	if (size >= 3 && memcmp(text, "\xEF\xBB\xBF", 3) == 0)
+	{
+		text += 3;
+		size -= 3;
+	}
+	out = jsonValue();
+	jsonParser parser(text, size);
+	if (parser.parseDocument(out))
+		return true;
+	if (errorOffset)
+	{
+		*errorOffset = parser.offset();
+	}
+	return false;
+}
+
+bool loadJsonFile(const std::string& path, jsonValue& out)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+	const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	std::size_t errorOffset = 0;
+	if (!parseJson(text.data(), text.size(), out, &errorOffset))
+	{
+		LOG_ERROR("%s: JSON syntax error at byte %zu", path.c_str(), errorOffset);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Writes text as a JSON string literal, including the surrounding quotes
+inline void writeJsonString(FILE* out, const char* text)
+{
+	fputc('"', out);
+	for (const unsigned char* p = reinterpret_cast<const unsigned char*>(text); *p; ++p)
+	{
+		switch (*p)
+		{
+			case '"':
+				fputs("\\\"", out);
+				break;
+			case '\\':
+				fputs("\\\\", out);
+				break;
+			case '\n':
+				fputs("\\n", out);
+				break;
+			case '\r':
+				fputs("\\r", out);
+				break;
+			case '\t':
+				fputs("\\t", out);
+				break;
+			default:
+				if (*p < 0x20)
+				{
+					fprintf(out, "\\u%04x", *p);
+				}
+				else
+				{
+					fputc(*p, out);
+				}
+				break;
+		}
+	}
+	fputc('"', out);
+}
+
+// Parsed JSON document. Small and read-only: objects keep their members in file order
+// and lookups are linear, which is fine for the config and database files read here.
+struct jsonValue
+{
+	enum kind
+	{
+		JSON_NULL = 0,
+		JSON_BOOL,
+		JSON_NUMBER,
+		JSON_STRING,
+		JSON_ARRAY,
+		JSON_OBJECT
+	};
+
+	kind type = JSON_NULL;
+	bool boolean = false;
+	double number = 0.0;
+	std::string string;
+	std::vector<jsonValue> items;							 // JSON_ARRAY
+	std::vector<std::pair<std::string, jsonValue>> members; // JSON_OBJECT
+
+	// Member lookup; null if this is not an object or has no such key
+	const jsonValue* find(const char* key) const;
+	bool isString() const { return type == JSON_STRING; }
+	bool isNumber() const { return type == JSON_NUMBER; }
+	bool isArray() const { return type == JSON_ARRAY; }
+	bool isObject() const { return type == JSON_OBJECT; }
+};
+
+// Parses a complete document (UTF-8; \u escapes are decoded to UTF-8). Returns false on
+// a syntax error and writes the byte offset of the error to errorOffset if given.
+bool parseJson(const char* text, std::size_t size, jsonValue& out, std::size_t* errorOffset = nullptr);
+bool loadJsonFile(const std::string& path, jsonValue& out);
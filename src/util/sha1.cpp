@@ -0,0 +1,121 @@
+#include "util/sha1.h"
+
+#include <cstring>
+
+namespace
+{
+	uint32_t rotl(uint32_t value, int bits)
+	{
+		return value << bits | value >> (32 - bits);
+	}
+
+	void processBlock(uint32_t state[5], const uint8_t block[64])
+	{
+		uint32_t w[80];
+		for (int i = 0; i < 16; ++i)
+		{
+			w[i] = static_cast<uint32_t>(block[i * 4]) << 24 | static_cast<uint32_t>(block[i * 4 + 1]) << 16 |
+				   static_cast<uint32_t>(block[i * 4 + 2]) << 8 | block[i * 4 + 3];
+		}
+		for (int i = 16; i < 80; ++i)
+		{
+			w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+		}
+
+		uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+		for (int i = 0; i < 80; ++i)
+		{
+			uint32_t f;
+			uint32_t k;
+			if (i < 20)
+			{
+				f = (b & c) | (~b & d);
+				k = 0x5A827999u;
+			}
+			else if (i < 40)
+			{
+				f = b ^ c ^ d;
+				k = 0x6ED9EBA1u;
+			}
+			else if (i < 60)
+			{
+				f = (b & c) | (b & d) | (c & d);
+				k = 0x8F1BBCDCu;
+			}
+			else
+			{
+				f = b ^ c ^ d;
+				k = 0xCA62C1D6u;
+			}
+			const uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+			e = d;
+			d = c;
+			c = rotl(b, 30);
+			b = a;
+			a = temp;
+		}
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+	}
+}
+
+std::string sha1Digest::hex() const
+{
+	static const char digits[] = "0123456789abcdef";
+	std::string text(40, '0');
+	for (int i = 0; i < 20; ++i)
+	{
+		text[i * 2] = digits[bytes[i] >> 4];
+		text[i * 2 + 1] = digits[bytes[i] & 0xF];
+	}
+	return text;
+}
+
+bool sha1Digest::operator==(const sha1Digest& other) const
+{
+	return memcmp(bytes, other.bytes, sizeof(bytes)) == 0;
+}
+
+sha1Digest sha1(const uint8_t* data, std::size_t size)
+{
+	uint32_t state[5] = { 0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x10325476u, 0xC3D2E1F0u };
+
+	std::size_t offset = 0;
+	for (; offset + 64 <= size; offset += 64)
+	{
+		processBlock(state, data + offset);
+	}
+
+	// Final one or two blocks: remaining bytes, 0x80, zero padding, bit length
+	uint8_t tail[128] = {};
+	const std::size_t remaining = size - offset;
+	if (remaining)
+	{
+		memcpy(tail, data + offset, remaining);
+	}
+	tail[remaining] = 0x80;
+	const std::size_t tailSize = remaining < 56 ? 64 : 128;
+	const uint64_t bits = static_cast<uint64_t>(size) * 8;
+	for (int i = 0; i < 8; ++i)
+	{
+		tail[tailSize - 1 - i] = static_cast<uint8_t>(bits >> (i * 8));
+	}
+	processBlock(state, tail);
+	if (tailSize == 128)
+	{
+		processBlock(state, tail + 64);
+	}
+
+	sha1Digest digest;
+	for (int i = 0; i < 5; ++i)
+	{
+		digest.bytes[i * 4] = static_cast<uint8_t>(state[i] >> 24);
+		digest.bytes[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+		digest.bytes[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+		digest.bytes[i * 4 + 3] = static_cast<uint8_t>(state[i]);
+	}
+	return digest;
+}
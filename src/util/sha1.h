@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// SHA-1, used only to match ROMs against databases that are keyed by it
+// (not for anything security related)
+struct sha1Digest
+{
+	uint8_t bytes[20] = {};
+
+	std::string hex() const;
+	bool operator==(const sha1Digest& other) const;
+};
+
+sha1Digest sha1(const uint8_t* data, std::size_t size);
@@ -0,0 +1,416 @@
+#include "verify/verifier.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "arena/machineArena.h"
+#include "batch/batchRunner.h"
+#include "batch/inputScript.h"
+#include "batch/threadPool.h"
+#include "lockstep/lockstep.h"
+#include "machine.h"
+#include "rom/romImage.h"
+#include "snapshot/snapshot.h"
+#include "trace/trace.h"
+#include "util/json.h"
+
+namespace
+{
+	constexpr int verifyLanes = 8;
+	using verifyEngine = lockstepEngine<verifyLanes>;
+
+	enum verifyStatus
+	{
+		VERIFY_MATCH = 0,
+		VERIFY_DIVERGED,
+		VERIFY_LOAD_FAILED,
+		VERIFY_INPUT_FAILED
+	};
+
+	const char* verifyStatusName(verifyStatus status)
+	{
+		switch (status)
+		{
+			case VERIFY_MATCH:
+				return "match";
+			case VERIFY_DIVERGED:
+				return "diverged";
+			case VERIFY_LOAD_FAILED:
+				return "load-failed";
+			case VERIFY_INPUT_FAILED:
+				return "input-failed";
+		}
+		return "unknown";
+	}
+
+	struct verifyResult
+	{
+		verifyStatus status = VERIFY_MATCH;
+		int framesRun = 0;
+		uint64_t instructions = 0;
+		double wallMs = 0.0;
+		std::string divergence; // JSON object, empty while the backends agree
+	};
+
+	void appendf(std::string& out, const char* fmt, ...)
+	{
+		char buffer[256];
+		va_list args;
+		va_start(args, fmt);
+		const int written = vsnprintf(buffer, sizeof(buffer), fmt, args);
+		va_end(args);
+		if (written > 0)
+		{
+			out.append(buffer, std::min<std::size_t>(static_cast<std::size_t>(written), sizeof(buffer) - 1));
+		}
+	}
+
+	// The reference lanes plus the bisector's two machines. Each worker keeps one arena
+	// for all its jobs, so a job's machines sit side by side and cost no allocation;
+	// under --numa it lives on the worker's node.
+	machineArena::handle makeMachine(unsigned int seed)
+	{
+		thread_local machineArena arena(verifyLanes + 2, arenaOptions{ false, threadPool::pinnedNode() });
+		machineArena::handle m = arena.acquire(seed);
+		m->recordHistory = false;
+		m->faults.maxFirstLogsPerInterval = 0;
+		return m;
+	}
+
+	// Field-by-field version of comparing digest() with laneDigest(); memcmp over the
+	// 6 KB of memory and screen is far cheaper than hashing both sides
+	bool sameState(const machine& m, const verifyEngine& engine, int lane)
+	{
+		for (int r = 0; r < 16; ++r)
+		{
+			if (m.V[r] != engine.V[r][lane] || m.stack[r] != engine.stack[r][lane])
+				return false;
+		}
+		return m.I == engine.I[lane] && m.pc == engine.pc[lane] && m.sp == engine.sp[lane] && m.delayTimer == engine.delayTimer[lane] &&
+			m.soundTimer == engine.soundTimer[lane] && memcmp(m.memory, engine.memory[lane], sizeof(m.memory)) == 0 &&
+			memcmp(m.screen, engine.screen[lane], sizeof(m.screen)) == 0;
+	}
+
+	void appendState(std::string& out, const machine& m)
+	{
+		out += "{\"V\": [";
+		for (int r = 0; r < 16; ++r)
+		{
+			appendf(out, "%s%u", r ? ", " : "", m.V[r]);
+		}
+		appendf(out, "], \"I\": %u, \"pc\": %u, \"sp\": %u, \"stack\": [", m.I, m.pc, m.sp);
+		for (int s = 0; s < 16; ++s)
+		{
+			appendf(out, "%s%u", s ? ", " : "", m.stack[s]);
+		}
+		appendf(out, "], \"delayTimer\": %u, \"soundTimer\": %u, \"digest\": \"%016llx\"}", m.delayTimer, m.soundTimer,
+			static_cast<unsigned long long>(m.digest()));
+	}
+
+	// Replays one window from the checkpoint and narrows a lane's mismatch down to
+	// the first instruction after which the two backends disagree
+	class bisector
+	{
+	public:
+		bisector(const snapshot (&checkpoint)[verifyLanes], int lane, unsigned int seed)
+			: checkpoint(checkpoint), lane(lane), reference(makeMachine(seed)), fast(makeMachine(seed)),
+			  engine(std::make_unique<verifyEngine>(seed))
+		{
+		}
+
+		// Runs `cycles` instructions from the checkpoint on both backends; true if lane still agrees
+		bool agreesAfter(int cycles)
+		{
+			// Every lane goes back to its checkpoint: a bug on the per-lane path may
+			// only show while the other lanes sit somewhere else
+			for (int l = 0; l < verifyLanes; ++l)
+			{
+				checkpoint[l].restore(*reference);
+				engine->loadLaneState(l, *reference);
+			}
+			checkpoint[lane].restore(*reference);
+			reference->runCycles(cycles);
+			engine->runCycles(cycles);
+			return sameState(*reference, *engine, lane);
+		}
+
+		// Fills `out` with the divergence record for a window of `window` instructions
+		void describe(std::string& out, int frame, uint64_t windowStart, int window, bool windowTicked)
+		{
+			// Smallest k in [1, window] whose prefix already disagrees
+			int lo = 1;
+			int hi = window;
+			bool atTimerTick = false;
+			if (agreesAfter(window))
+			{
+				// Every instruction agreed, so the timer tick at the end of the frame differs
+				atTimerTick = windowTicked;
+				lo = window;
+			}
+			else
+			{
+				while (lo < hi)
+				{
+					const int mid = lo + (hi - lo) / 2;
+					if (agreesAfter(mid))
+					{
+						lo = mid + 1;
+					}
+					else
+					{
+						hi = mid;
+					}
+				}
+			}
+
+			// State just before the offending step
+			agreesAfter(atTimerTick ? lo : lo - 1);
+			const uint16_t pc = reference->pc;
+			const uint16_t opcode = static_cast<uint16_t>((reference->memory[pc & machine::addressMask] << 8u) |
+				reference->memory[(pc + 1u) & machine::addressMask]);
+			if (atTimerTick)
+			{
+				reference->tickTimers();
+				engine->tickTimers();
+			}
+			else
+			{
+				reference->runCycles(1);
+				engine->runCycles(1);
+			}
+			engine->storeLaneState(lane, *fast);
+
+			appendf(out, "{\"lane\": %d, \"frame\": %d, \"instruction\": %llu, \"atTimerTick\": %s, \"reproduced\": %s, ",
+				lane, frame, static_cast<unsigned long long>(windowStart + static_cast<uint64_t>(lo) - (atTimerTick ? 0u : 1u)),
+				atTimerTick ? "true" : "false", reference->digest() != fast->digest() ? "true" : "false");
+			appendf(out, "\"pc\": \"%03X\", \"opcode\": \"%04X\",\n      \"reference\": ", pc, opcode);
+			appendState(out, *reference);
+			out += ",\n      \"lockstep\": ";
+			appendState(out, *fast);
+
+			out += ",\n      \"memoryDiffs\": [";
+			int listed = 0;
+			for (int a = 0; a < 4096 && listed < 32; ++a)
+			{
+				if (reference->memory[a] != fast->memory[a])
+				{
+					appendf(out, "%s{\"address\": \"%03X\", \"reference\": %u, \"lockstep\": %u}", listed ? ", " : "", a,
+						reference->memory[a], fast->memory[a]);
+					++listed;
+				}
+			}
+			int pixels = 0;
+			for (int x = 0; x < 64; ++x)
+			{
+				for (int y = 0; y < 32; ++y)
+				{
+					pixels += reference->screen[x][y] != fast->screen[x][y];
+				}
+			}
+			appendf(out, "], \"screenDiffs\": %d}", pixels);
+		}
+
+	private:
+		const snapshot (&checkpoint)[verifyLanes];
+		const int lane;
+		machineArena::handle reference;
+		machineArena::handle fast;
+		std::unique_ptr<verifyEngine> engine;
+	};
+
+	verifyResult verifyJob(const batchJob& job, const verifyOptions& options)
+	{
+		TRACE_ZONE("verifyJob");
+		const auto start = std::chrono::steady_clock::now();
+		verifyResult result;
+
+		inputScript script;
+		if (!loadJobInput(job, script))
+		{
+			result.status = VERIFY_INPUT_FAILED;
+			return result;
+		}
+
+		machineArena::handle reference[verifyLanes];
+		std::unique_ptr<verifyEngine> engine = std::make_unique<verifyEngine>(options.seed);
+		const std::shared_ptr<const romImage> image = job.image ? job.image : romImage::load(job.romPath);
+		bool loaded = image && engine->loadRom(image->data(), image->size());
+		for (int l = 0; l < verifyLanes && loaded; ++l)
+		{
+			reference[l] = makeMachine(options.seed + static_cast<unsigned int>(l));
+			loaded = reference[l]->loadRom(image);
+		}
+		if (!loaded)
+		{
+			result.status = VERIFY_LOAD_FAILED;
+			return result;
+		}
+
+		const int window = options.granularity == VERIFY_INSTRUCTION ? 1
+			: options.granularity == VERIFY_BLOCK					 ? std::min(options.blockSize, options.cyclesPerFrame)
+																	 : options.cyclesPerFrame;
+		pageStore store;
+		snapshot checkpoint[verifyLanes];
+		uint8_t keys[16] = {};
+
+		for (int frame = 0; frame < job.frames && result.status == VERIFY_MATCH; ++frame)
+		{
+			script.apply(frame, keys);
+			for (int l = 0; l < verifyLanes; ++l)
+			{
+				memcpy(reference[l]->keypad, keys, sizeof(keys));
+				memcpy(engine->keypad[l], keys, sizeof(keys));
+			}
+
+			for (int done = 0; done < options.cyclesPerFrame;)
+			{
+				const int cycles = std::min(window, options.cyclesPerFrame - done);
+				for (int l = 0; l < verifyLanes; ++l)
+				{
+					checkpoint[l] = snapshot::capture(store, *reference[l], &checkpoint[l]);
+					reference[l]->runCycles(cycles);
+				}
+				engine->runCycles(cycles);
+				done += cycles;
+				const bool frameEnd = done == options.cyclesPerFrame;
+				if (frameEnd)
+				{
+					for (int l = 0; l < verifyLanes; ++l)
+					{
+						reference[l]->tickTimers();
+					}
+					engine->tickTimers();
+				}
+
+				for (int l = 0; l < verifyLanes; ++l)
+				{
+					if (sameState(*reference[l], *engine, l))
+						continue;
+					result.status = VERIFY_DIVERGED;
+					bisector search(checkpoint, l, options.seed);
+					search.describe(result.divergence, frame, result.instructions, cycles, frameEnd);
+					break;
+				}
+				result.instructions += static_cast<uint64_t>(cycles);
+				if (result.status != VERIFY_MATCH)
+					break;
+			}
+			result.framesRun = frame + 1;
+		}
+
+		result.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return result;
+	}
+
+	bool writeVerifyReport(const std::string& path, const verifyOptions& options, const std::vector<batchJob>& jobs,
+		const std::vector<verifyResult>& results, unsigned int workers, double wallMs)
+	{
+		FILE* out = fopen(path.c_str(), "wb");
+		if (!out)
+		{
+			LOG_ERROR("Failed to open verify report %s", path.c_str());
+			return false;
+		}
+
+		fprintf(out, "{\n  \"roms\": %zu,\n  \"workers\": %u,\n  \"wallMs\": %.3f,\n  \"granularity\": \"%s\",\n  \"lanes\": %d,\n  \"results\": [\n",
+			jobs.size(), workers, wallMs, verifyGranularityName(options.granularity), verifyLanes);
+		for (std::size_t i = 0; i < jobs.size(); ++i)
+		{
+			const verifyResult& r = results[i];
+			fputs("    {\"name\": ", out);
+			writeJsonString(out, jobs[i].name.c_str());
+			fprintf(out, ", \"status\": \"%s\", \"frames\": %d, \"instructions\": %llu, \"wallMs\": %.3f", verifyStatusName(r.status),
+				r.framesRun, static_cast<unsigned long long>(r.instructions), r.wallMs);
+			if (!r.divergence.empty())
+			{
+				fprintf(out, ",\n     \"divergence\": %s", r.divergence.c_str());
+			}
+			fprintf(out, "}%s\n", i + 1 < jobs.size() ? "," : "");
+		}
+		fputs("  ]\n}\n", out);
+
+		const bool ok = ferror(out) == 0;
+		fclose(out);
+		if (!ok)
+		{
+			LOG_ERROR("Failed to write verify report %s", path.c_str());
+		}
+		return ok;
+	}
+}
+
+const char* verifyGranularityName(verifyGranularity granularity)
+{
+	switch (granularity)
+	{
+		case VERIFY_INSTRUCTION:
+			return "instruction";
+		case VERIFY_BLOCK:
+			return "block";
+		case VERIFY_FRAME:
+			return "frame";
+	}
+	return "unknown";
+}
+
+int runVerify(const verifyOptions& options)
+{
+	if (options.cyclesPerFrame <= 0 || options.blockSize <= 0)
+	{
+		LOG_ERROR("Cycles per frame and block size must be positive");
+		return 1;
+	}
+
+	std::vector<batchJob> jobs;
+	if (!loadBatchJobs(options.inputPath, options.defaultFrames, jobs))
+	{
+		return 1;
+	}
+	if (jobs.empty())
+	{
+		LOG_ERROR("No ROMs found in %s", options.inputPath.c_str());
+		return 1;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	for (batchJob& job : jobs)
+	{
+		if (!job.image)
+		{
+			job.image = romImage::load(job.romPath);
+		}
+	}
+
+	std::vector<verifyResult> results(jobs.size());
+	unsigned int workers = 0;
+	{
+		threadPool pool(options.jobs, "verify", false, options.numa);
+		workers = pool.size();
+		LOG("Verifying %zu ROMs on %u workers, %s granularity", jobs.size(), workers, verifyGranularityName(options.granularity));
+		pool.parallelFor(jobs.size(), [&](std::size_t i) { results[i] = verifyJob(jobs[i], options); });
+	}
+	const double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	int failures = 0;
+	for (std::size_t i = 0; i < jobs.size(); ++i)
+	{
+		if (results[i].status != VERIFY_MATCH)
+		{
+			++failures;
+			LOG_WARNING("%s: %s", jobs[i].name.c_str(), verifyStatusName(results[i].status));
+		}
+	}
+
+	if (!writeVerifyReport(options.reportPath, options, jobs, results, workers, wallMs))
+	{
+		return 1;
+	}
+	LOG("Verification finished in %.1f ms: %zu ROMs, %d mismatched or failed, report written to %s", wallMs, jobs.size(), failures,
+		options.reportPath.c_str());
+	return failures == 0 ? 0 : 1;
+}
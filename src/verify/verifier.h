@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+
+enum verifyGranularity
+{
+	VERIFY_INSTRUCTION = 0,
+	VERIFY_BLOCK,	 // every blockSize instructions
+	VERIFY_FRAME
+};
+
+struct verifyOptions
+{
+	std::string inputPath;						// directory of ROMs or a batch manifest
+	std::string reportPath = "verify-report.json";
+	int defaultFrames = 600;
+	int cyclesPerFrame = 700 / 60;
+	unsigned int jobs = 0;						// 0 = one worker per hardware thread
+	bool numa = false;							// see batchOptions::numa
+	unsigned int seed = 1;
+	verifyGranularity granularity = VERIFY_FRAME;
+	int blockSize = 64;
+};
+
+const char* verifyGranularityName(verifyGranularity granularity);
+
+// Differential check of the lockstep engine against the reference interpreter.
+// Every ROM runs on machine(seed + l) and on lane l of an 8-lane lockstepEngine with
+// the same input script; digests are compared at the chosen granularity. On the first
+// mismatch the run is replayed from the last matching checkpoint (page-store
+// snapshots of all lanes) and bisected to the first differing instruction; its PC,
+// opcode and the resulting state on both backends go into the JSON report.
+// Returns 0 when every ROM matched.
+int runVerify(const verifyOptions& options);
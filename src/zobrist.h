@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+// Zobrist keys for machine state. Each (slot, value) pair maps to a pseudo-random
+// 64-bit key; a state's hash is the XOR of the keys of its contents, so changing
+// one byte updates the hash with two XORs. Keys are computed rather than tabled:
+// a table for 4 KB of memory x 256 values would be 8 MB.
+namespace zobrist
+{
+	// Slot ranges
+	static constexpr uint32_t memorySlot = 0;		// 4096 bytes
+	static constexpr uint32_t screenSlot = 4096;	// 2048 pixels, only lit ones contribute
+	static constexpr uint32_t registerSlot = 6144; // V, I, pc, stack, sp, timers
+
+	// splitmix64 finalizer over the packed (slot, value) pair
+	inline uint64_t key(uint32_t slot, uint8_t value)
+	{
+		uint64_t z = ((static_cast<uint64_t>(slot) << 8) | value) + 0x9E3779B97F4A7C15ull;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+}
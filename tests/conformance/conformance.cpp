@@ -0,0 +1,261 @@
+// Headless conformance runner. Runs one ROM for a fixed number of frames with an
+// optional input script and compares the framebuffer hash after every frame, plus
+// the final machine digest, against a golden file. CTest runs one case per process
+// (see cases.txt), so `ctest -j` runs the suite in parallel.
+//
+// Golden files list "<frame> <hash>" only for frames whose framebuffer changed,
+// followed by "digest <hash>". Regenerate with --update after an intended change.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "batch/inputScript.h"
+#include "machine.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	// CTest SKIP_RETURN_CODE: the ROM or golden is not available
+	constexpr int skipExitCode = 77;
+
+	struct caseOptions
+	{
+		std::string romPath;
+		std::string goldenPath;
+		std::string inputPath;
+		int frames = 0;
+		int cyclesPerFrame = 700 / 60;
+		bool update = false;
+	};
+
+	uint64_t hashFramebuffer(const uint8_t packed[256])
+	{
+		uint64_t hash = 0xCBF29CE484222325ull;
+		for (int i = 0; i < 256; ++i)
+		{
+			hash = (hash ^ packed[i]) * 0x100000001B3ull;
+		}
+		return hash;
+	}
+
+	void printFramebuffer(const uint8_t packed[256])
+	{
+		for (int y = 0; y < 32; ++y)
+		{
+			char row[65];
+			for (int x = 0; x < 64; ++x)
+			{
+				row[x] = (packed[y * 8 + x / 8] >> (7 - x % 8)) & 1u ? '#' : '.';
+			}
+			row[64] = '\0';
+			printf("  %s\n", row);
+		}
+	}
+
+	bool parseArgs(int argc, char** argv, caseOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const char* arg = argv[i];
+			const bool hasValue = i + 1 < argc;
+			if (strcmp(arg, "--update") == 0)
+			{
+				options.update = true;
+			}
+			else if (!hasValue)
+			{
+				LOG_ERROR("Missing value for %s", arg);
+				return false;
+			}
+			else if (strcmp(arg, "--rom") == 0)
+			{
+				options.romPath = argv[++i];
+			}
+			else if (strcmp(arg, "--golden") == 0)
+			{
+				options.goldenPath = argv[++i];
+			}
+			else if (strcmp(arg, "--input") == 0)
+			{
+				options.inputPath = argv[++i];
+			}
+			else if (strcmp(arg, "--frames") == 0)
+			{
+				options.frames = atoi(argv[++i]);
+			}
+			else if (strcmp(arg, "--cycles-per-frame") == 0)
+			{
+				options.cyclesPerFrame = atoi(argv[++i]);
+			}
+			else
+			{
+				LOG_ERROR("Unknown argument: %s", arg);
+				return false;
+			}
+		}
+		if (options.romPath.empty() || options.goldenPath.empty() || options.frames <= 0 || options.cyclesPerFrame <= 0)
+		{
+			LOG_ERROR("Usage: chip8-conformance --rom <file> --golden <file> --frames <n> [--input <script>] [--cycles-per-frame <n>] [--update]");
+			return false;
+		}
+		return true;
+	}
+
+	// Expands the golden's change list back into one hash per frame
+	bool loadGolden(const std::string& path, int frames, std::vector<uint64_t>& hashes, uint64_t& digest)
+	{
+		std::ifstream file(path);
+		if (!file.is_open())
+			return false;
+
+		hashes.assign(static_cast<std::size_t>(frames), 0);
+		std::vector<bool> listed(static_cast<std::size_t>(frames), false);
+		bool haveDigest = false;
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (line.empty() || line[0] == '#')
+				continue;
+			std::istringstream fields(line);
+			std::string first;
+			std::string hash;
+			fields >> first >> hash;
+			if (first == "digest")
+			{
+				digest = std::stoull(hash, nullptr, 16);
+				haveDigest = true;
+				continue;
+			}
+			const int frame = std::stoi(first);
+			if (frame < 0 || frame >= frames)
+			{
+				LOG_ERROR("%s: frame %d outside the case's %d frames", path.c_str(), frame, frames);
+				return false;
+			}
+			hashes[static_cast<std::size_t>(frame)] = std::stoull(hash, nullptr, 16);
+			listed[static_cast<std::size_t>(frame)] = true;
+		}
+		if (!haveDigest || !listed[0])
+		{
+			LOG_ERROR("%s: missing frame 0 or digest", path.c_str());
+			return false;
+		}
+		for (std::size_t f = 1; f < hashes.size(); ++f)
+		{
+			if (!listed[f])
+			{
+				hashes[f] = hashes[f - 1];
+			}
+		}
+		return true;
+	}
+
+	bool writeGolden(const caseOptions& options, const std::vector<uint64_t>& hashes, uint64_t digest)
+	{
+		FILE* out = fopen(options.goldenPath.c_str(), "wb");
+		if (!out)
+		{
+			LOG_ERROR("Failed to open %s", options.goldenPath.c_str());
+			return false;
+		}
+		fprintf(out, "# %s, %d frames at %d cycles per frame\n", fs::path(options.romPath).filename().string().c_str(), options.frames,
+			options.cyclesPerFrame);
+		for (std::size_t f = 0; f < hashes.size(); ++f)
+		{
+			if (f == 0 || hashes[f] != hashes[f - 1])
+			{
+				fprintf(out, "%zu %016llx\n", f, static_cast<unsigned long long>(hashes[f]));
+			}
+		}
+		fprintf(out, "digest %016llx\n", static_cast<unsigned long long>(digest));
+		const bool ok = ferror(out) == 0;
+		fclose(out);
+		return ok;
+	}
+}
+
+static int runCase(const caseOptions& options)
+{
+	if (!fs::exists(options.romPath))
+	{
+		printf("SKIP: ROM %s not found\n", options.romPath.c_str());
+		return options.update ? 0 : skipExitCode;
+	}
+
+	inputScript script;
+	if (!options.inputPath.empty() && !script.load(options.inputPath))
+		return 1;
+
+	machine m(1);
+	m.recordHistory = false;
+	m.faults.maxFirstLogsPerInterval = 0;
+	if (!m.loadRom(options.romPath))
+		return 1;
+
+	std::vector<uint64_t> hashes(static_cast<std::size_t>(options.frames));
+	std::vector<uint8_t> frames(static_cast<std::size_t>(options.frames) * 256);
+	for (int frame = 0; frame < options.frames; ++frame)
+	{
+		script.apply(frame, m.keypad);
+		m.runCycles(options.cyclesPerFrame);
+		m.tickTimers();
+		uint8_t* packed = &frames[static_cast<std::size_t>(frame) * 256];
+		m.packScreen(packed);
+		hashes[static_cast<std::size_t>(frame)] = hashFramebuffer(packed);
+	}
+	const uint64_t digest = m.digest();
+
+	if (options.update)
+	{
+		if (!writeGolden(options, hashes, digest))
+			return 1;
+		printf("Updated %s\n", options.goldenPath.c_str());
+		return 0;
+	}
+
+	std::vector<uint64_t> expected;
+	uint64_t expectedDigest = 0;
+	if (!fs::exists(options.goldenPath))
+	{
+		printf("SKIP: no golden %s; run with --update to record one\n", options.goldenPath.c_str());
+		return skipExitCode;
+	}
+	if (!loadGolden(options.goldenPath, options.frames, expected, expectedDigest))
+		return 1;
+
+	for (int frame = 0; frame < options.frames; ++frame)
+	{
+		if (hashes[static_cast<std::size_t>(frame)] == expected[static_cast<std::size_t>(frame)])
+			continue;
+		printf("FAIL: framebuffer differs at frame %d (expected %016llx, got %016llx)\n", frame,
+			static_cast<unsigned long long>(expected[static_cast<std::size_t>(frame)]),
+			static_cast<unsigned long long>(hashes[static_cast<std::size_t>(frame)]));
+		printFramebuffer(&frames[static_cast<std::size_t>(frame) * 256]);
+		return 1;
+	}
+	if (digest != expectedDigest)
+	{
+		printf("FAIL: final machine digest differs (expected %016llx, got %016llx)\n", static_cast<unsigned long long>(expectedDigest),
+			static_cast<unsigned long long>(digest));
+		return 1;
+	}
+	printf("PASS: %d frames\n", options.frames);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	caseOptions options;
+	if (!parseArgs(argc, argv, options))
+		return 2;
+	const int exitCode = runCase(options);
+	log_shutdown();
+	return exitCode;
+}
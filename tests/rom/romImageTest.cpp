@@ -0,0 +1,117 @@
+// Checks that a mapped romImage gives its mapping back when the last reference goes:
+// after every release, the file must be gone from /proc/self/maps. Skipped where that
+// file does not exist.
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "log/log.h"
+#include "rom/romImage.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	// CTest SKIP_RETURN_CODE: no /proc/self/maps on this platform
+	constexpr int skipExitCode = 77;
+
+	int countMappings(const std::string& path)
+	{
+		std::ifstream maps("/proc/self/maps");
+		int count = 0;
+		std::string line;
+		while (std::getline(maps, line))
+		{
+			if (line.find(path) != std::string::npos)
+			{
+				++count;
+			}
+		}
+		return count;
+	}
+
+	bool expectMappings(const std::string& path, int expected, const char* when)
+	{
+		const int count = countMappings(path);
+		if (count == expected)
+			return true;
+		printf("FAIL: %d mappings of %s %s, expected %d\n", count, path.c_str(), when, expected);
+		return false;
+	}
+
+	bool runChecks(const std::string& path)
+	{
+		// Map, release, repeat: each release must unmap
+		for (int round = 0; round < 5; ++round)
+		{
+			std::shared_ptr<const romImage> image = romImage::map(path);
+			if (!image || image->size() != 8192)
+			{
+				printf("FAIL: could not map %s\n", path.c_str());
+				return false;
+			}
+			if (!expectMappings(path, 1, "while held"))
+				return false;
+			image.reset();
+			if (!expectMappings(path, 0, "after release"))
+				return false;
+		}
+
+		// Same path mapped several times at once: one shared mapping, gone with the last reference
+		std::vector<std::shared_ptr<const romImage>> images;
+		for (int i = 0; i < 5; ++i)
+		{
+			images.push_back(romImage::map(path));
+		}
+		if (!expectMappings(path, 1, "with five references"))
+			return false;
+		images.clear();
+		if (!expectMappings(path, 0, "after releasing all references"))
+			return false;
+
+		// A mapping that loses to an already loaded copy of the same bytes is dropped at once
+		const std::shared_ptr<const romImage> loaded = romImage::load(path);
+		const std::shared_ptr<const romImage> mapped = romImage::map(path);
+		if (mapped != loaded)
+		{
+			printf("FAIL: mapping was not deduplicated against the loaded copy\n");
+			return false;
+		}
+		return expectMappings(path, 0, "after losing to a loaded copy");
+	}
+}
+
+int main()
+{
+	if (!fs::exists("/proc/self/maps"))
+	{
+		printf("SKIP: no /proc/self/maps\n");
+		return skipExitCode;
+	}
+
+	// In the working directory (the build tree under CTest), removed again at the end
+	const fs::path file = fs::current_path() / "chip8-rom-test.c8pk";
+	{
+		std::ofstream out(file, std::ios::binary);
+		std::vector<char> bytes(8192);
+		for (std::size_t i = 0; i < bytes.size(); ++i)
+		{
+			bytes[i] = static_cast<char>(i * 31);
+		}
+		out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+	}
+
+	const bool passed = runChecks(fs::canonical(file).string());
+	std::error_code ec;
+	fs::remove(file, ec);
+	if (passed)
+	{
+		printf("PASS\n");
+	}
+	log_shutdown();
+	return passed ? 0 : 1;
+}